@@ -7,4 +7,8 @@ mkdir %RELEASEDIR%\x64\plugins
 copy bin\x32\SwissArmyKnife.dp32 %RELEASEDIR%\x32\plugins\
 copy bin\x64\SwissArmyKnife.dp64 %RELEASEDIR%\x64\plugins\
 
+REM Generated by the CMake build (see README), the same file for both architectures
+if exist build\findcrypt.fcdb copy build\findcrypt.fcdb %RELEASEDIR%\x32\plugins\
+if exist build\findcrypt.fcdb copy build\findcrypt.fcdb %RELEASEDIR%\x64\plugins\
+
 exit 0
\ No newline at end of file
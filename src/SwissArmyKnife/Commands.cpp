@@ -38,6 +38,25 @@ void Cmd_RegisterCommands()
 		return true;
 	}, true);
 
+	_plugin_registercommand(g_PluginHandle, "findcrypt_db", [](int argc, char **argv)
+	{
+		// findcrypt_db file
+		if (argc != 2)
+		{
+			dprintf("Usage: findcrypt_db file\n");
+			return false;
+		}
+
+		if (!FindcryptLoadDatabaseFile(argv[1]))
+		{
+			dprintf("Unable to load the constant database %s\n", argv[1]);
+			return false;
+		}
+
+		dprintf("Loaded constants from %s\n", argv[1]);
+		return true;
+	}, true);
+
 	//
 	// AES-FINDER
 	//
@@ -73,4 +92,91 @@ void Cmd_RegisterCommands()
 		AESFinderScanModule();
 		return true;
 	}, true);
+
+	//
+	// SIGMAKE
+	//
+	_plugin_registercommand(g_PluginHandle, "sigscan", [](int argc, char **argv)
+	{
+		// sigscan pattern[, mask][, module...][, /regions]
+		if (argc < 2)
+		{
+			dprintf("Usage: sigscan pattern[, mask][, module...][, /regions]\n");
+			return false;
+		}
+
+		const char *mask = nullptr;
+		bool regions = false;
+		std::vector<std::string> modules;
+
+		for (int i = 2; i < argc; i++)
+		{
+			// A mask can only follow the pattern directly
+			if (i == 2 && strspn(argv[i], "xX?") == strlen(argv[i]) && (strstr(argv[1], "\\x") || strchr(argv[1], ':')))
+				mask = argv[i];
+			else if (_stricmp(argv[i], "/regions") == 0)
+				regions = true;
+			else
+				modules.push_back(argv[i]);
+		}
+
+		return SigScan(argv[1], mask, regions, modules);
+	}, true);
+
+	_plugin_registercommand(g_PluginHandle, "sigbuilds", [](int argc, char **argv)
+	{
+		// sigbuilds address, file[, file...]
+		if (argc < 3)
+		{
+			dprintf("Usage: sigbuilds address, file[, file...]\n");
+			return false;
+		}
+
+		std::vector<std::string> files(argv + 2, argv + argc);
+		SIG_DESCRIPTOR *desc = MultiBuildSigFromCode(DbgValFromString(argv[1]), files);
+
+		if (!desc)
+			return false;
+
+		// Print it in the format last used in the dialog
+		char *data = nullptr;
+		char *mask = nullptr;
+
+		switch (Settings::LastType)
+		{
+		case SIG_CODE:	DescriptorToCode(desc, &data, &mask);	break;
+		case SIG_IDA:	DescriptorToIDA(desc, &data);			break;
+		case SIG_PEID:	DescriptorToPEiD(desc, &data);			break;
+		case SIG_CRC:	DescriptorToCRC(desc, &data, &mask);	break;
+		}
+
+		BridgeFree(desc);
+
+		if (data)
+		{
+			dprintf("Signature: %s\n", data);
+			BridgeFree(data);
+		}
+
+		if (mask)
+		{
+			dprintf("Mask: %s\n", mask);
+			BridgeFree(mask);
+		}
+
+		return true;
+	}, true);
+
+	_plugin_registercommand(g_PluginHandle, "sigexport", [](int argc, char **argv)
+	{
+		// sigexport file
+		if (argc != 2)
+		{
+			dprintf("Usage: sigexport file\n");
+			return false;
+		}
+
+		// Every function of the current module
+		return ExportModuleSigs(DbgGetCurrentModule(), argv[1]);
+	}, true);
 }
\ No newline at end of file
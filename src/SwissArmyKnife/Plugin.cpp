@@ -83,6 +83,9 @@ DLL_EXPORT bool pluginit(PLUG_INITSTRUCT *InitStruct)
 
 	// Add any of the callbacks
 	_plugin_registercallback(g_PluginHandle, CB_MENUENTRY, (CBPLUGIN)MenuEntryCallback);
+	_plugin_registercallback(g_PluginHandle, CB_PAUSEDEBUG, (CBPLUGIN)SnapshotDebugCallback);
+	_plugin_registercallback(g_PluginHandle, CB_LOADDLL, (CBPLUGIN)SnapshotDebugCallback);
+	_plugin_registercallback(g_PluginHandle, CB_STOPDEBUG, (CBPLUGIN)SnapshotDebugCallback);
 
 	// Update all check box settings
 	Settings::InitIni();
@@ -95,6 +98,42 @@ DLL_EXPORT bool pluginit(PLUG_INITSTRUCT *InitStruct)
 	Plugin_FindcryptLogo();
 	Plugin_AESFinderLogo();
 
+	//
+	// The randomized engine self tests take over a second, so release builds leave them
+	// to "sak-cli selftest" and only debug builds run them at every start
+	//
+#ifdef _DEBUG
+	if (!PatternScanSelfTest())
+		_plugin_logprintf("Pattern scanner self test failed!\n");
+
+	if (!BatchSigSelfTest())
+		_plugin_logprintf("Batch signature self test failed!\n");
+
+	if (!CrcPatternSelfTest())
+		_plugin_logprintf("CRC signature self test failed!\n");
+
+	if (!DescriptorTextSelfTest())
+		_plugin_logprintf("Signature text codec self test failed!\n");
+
+	if (!PEImageSelfTest())
+		_plugin_logprintf("PE image loader self test failed!\n");
+
+	if (!MultiBuildSelfTest())
+		_plugin_logprintf("Multi-build signature self test failed!\n");
+
+	if (!MemoryIndexSelfTest())
+		_plugin_logprintf("Memory index self test failed!\n");
+
+	if (!CodeStreamSelfTest())
+		_plugin_logprintf("Streaming decoder self test failed!\n");
+
+	if (!MemoryStreamSelfTest())
+		_plugin_logprintf("Memory stream self test failed!\n");
+
+	if (!SigDatabaseSelfTest())
+		_plugin_logprintf("Signature database self test failed!\n");
+#endif // _DEBUG
+
 	return true;
 }
 
@@ -109,6 +148,15 @@ DLL_EXPORT bool plugstop()
 
 	// Remove callbacks
 	_plugin_unregistercallback(g_PluginHandle, CB_MENUENTRY);
+	_plugin_unregistercallback(g_PluginHandle, CB_PAUSEDEBUG);
+	_plugin_unregistercallback(g_PluginHandle, CB_LOADDLL);
+	_plugin_unregistercallback(g_PluginHandle, CB_STOPDEBUG);
+
+	// Nothing may still be reading them
+	StopScanResults();
+
+	// Release any cached module copies
+	SnapshotInvalidateAll();
 	return true;
 }
 
@@ -0,0 +1,214 @@
+#include "stdafx.h"
+#include <mutex>
+
+// Snapshots nobody is using are dropped once the cache grows past this
+const duint SnapshotCacheLimit	= 512 * 1024 * 1024;
+const duint SnapshotPageSize	= 0x1000;
+
+std::mutex g_SnapshotLock;
+std::map<duint, std::shared_ptr<ModuleSnapshot>> g_Snapshots;
+
+void SnapshotGetPatches(duint Base, duint Size, std::map<duint, BYTE>& Patches)
+{
+	size_t size = 0;
+	DbgFunctions()->PatchEnum(nullptr, &size);
+
+	if (size <= 0)
+		return;
+
+	DBGPATCHINFO *patchInfo = (DBGPATCHINFO *)BridgeAlloc(size);
+	DbgFunctions()->PatchEnum(patchInfo, &size);
+
+	for (size_t i = 0; i < (size / sizeof(DBGPATCHINFO)); i++)
+	{
+		if (patchInfo[i].addr >= Base && patchInfo[i].addr < (Base + Size))
+			Patches[patchInfo[i].addr] = patchInfo[i].newbyte;
+	}
+
+	BridgeFree(patchInfo);
+}
+
+ModuleSnapshot::ModuleSnapshot(duint Base, duint Size)
+{
+	m_Base	= Base;
+	m_Size	= Size;
+	m_Data	= (PBYTE)VirtualAlloc(nullptr, Size, MEM_COMMIT, PAGE_READWRITE);
+
+	m_ReadablePages.resize((Size + SnapshotPageSize - 1) / SnapshotPageSize, true);
+
+	if (!m_Data)
+	{
+		_plugin_logprintf("Couldn't allocate a local copy of 0x%llX bytes at 0x%llX\n", (ULONGLONG)Size, (ULONGLONG)Base);
+		return;
+	}
+
+	// The read below already includes these
+	SnapshotGetPatches(Base, Size, m_Patches);
+
+	// Only fall back to single pages when the full read fails
+	if (!DbgMemRead(Base, m_Data, Size))
+		ReadPages(Base, Base + Size);
+}
+
+ModuleSnapshot::ModuleSnapshot(const ModuleSnapshot& Other)
+{
+	m_Base			= Other.m_Base;
+	m_Size			= Other.m_Size;
+	m_Data			= (PBYTE)VirtualAlloc(nullptr, m_Size, MEM_COMMIT, PAGE_READWRITE);
+	m_ReadablePages	= Other.m_ReadablePages;
+	m_Patches		= Other.m_Patches;
+
+	if (m_Data && Other.m_Data)
+		memcpy(m_Data, Other.m_Data, m_Size);
+}
+
+ModuleSnapshot::~ModuleSnapshot()
+{
+	if (m_Data)
+		VirtualFree(m_Data, 0, MEM_RELEASE);
+}
+
+bool ModuleSnapshot::IsReadable(duint Address) const
+{
+	if (Address < m_Base || Address >= (m_Base + m_Size))
+		return false;
+
+	return m_ReadablePages[(Address - m_Base) / SnapshotPageSize];
+}
+
+void ModuleSnapshot::UpdatePatches(const std::map<duint, BYTE>& Patches)
+{
+	if (!m_Data)
+		return;
+
+	// Re-read pages with patches that were added, removed or changed
+	for (auto& [address, value] : m_Patches)
+	{
+		auto itr = Patches.find(address);
+
+		if (itr == Patches.end() || itr->second != value)
+			ReadPages(address, address + 1);
+	}
+
+	for (auto& [address, value] : Patches)
+	{
+		if (m_Patches.find(address) == m_Patches.end())
+			ReadPages(address, address + 1);
+	}
+
+	m_Patches = Patches;
+}
+
+void ModuleSnapshot::ReadPages(duint Start, duint End)
+{
+	duint first	= (Start - m_Base) / SnapshotPageSize;
+	duint last	= (End - m_Base + SnapshotPageSize - 1) / SnapshotPageSize;
+
+	for (duint page = first; page < last && page < m_ReadablePages.size(); page++)
+	{
+		duint offset	= page * SnapshotPageSize;
+		duint size		= min(SnapshotPageSize, m_Size - offset);
+
+		m_ReadablePages[page] = DbgMemRead(m_Base + offset, m_Data + offset, size);
+
+		if (!m_ReadablePages[page])
+			memset(m_Data + offset, 0, size);
+	}
+}
+
+SnapshotPtr SnapshotModule(duint ModuleBase)
+{
+	duint moduleSize = DbgFunctions()->ModSizeFromAddr(ModuleBase);
+
+	if (ModuleBase <= 0 || moduleSize <= 0)
+		return nullptr;
+
+	std::map<duint, BYTE> patches;
+	SnapshotGetPatches(ModuleBase, moduleSize, patches);
+
+	// Reads happen under the lock so concurrent users of one module share a single copy
+	std::lock_guard<std::mutex> lock(g_SnapshotLock);
+
+	auto itr = g_Snapshots.find(ModuleBase);
+
+	if (itr != g_Snapshots.end() && itr->second->Size() == moduleSize)
+	{
+		std::shared_ptr<ModuleSnapshot>& snapshot = itr->second;
+
+		if (snapshot->Patches() != patches)
+		{
+			// Copy on write when somebody is still looking at the old contents
+			if (snapshot.use_count() > 1)
+				snapshot = std::make_shared<ModuleSnapshot>(*snapshot);
+
+			snapshot->UpdatePatches(patches);
+		}
+
+		if (!snapshot->Data())
+			return nullptr;
+
+		return snapshot;
+	}
+
+	auto snapshot = std::make_shared<ModuleSnapshot>(ModuleBase, moduleSize);
+
+	if (!snapshot->Data())
+		return nullptr;
+
+	// Drop unused snapshots until the new one fits
+	duint totalSize = moduleSize;
+
+	for (auto& [base, entry] : g_Snapshots)
+		totalSize += entry->Size();
+
+	for (auto entry = g_Snapshots.begin(); entry != g_Snapshots.end() && totalSize > SnapshotCacheLimit;)
+	{
+		if (entry->second.use_count() > 1)
+		{
+			entry++;
+			continue;
+		}
+
+		totalSize -= entry->second->Size();
+		entry = g_Snapshots.erase(entry);
+	}
+
+	g_Snapshots.insert_or_assign(ModuleBase, snapshot);
+	return snapshot;
+}
+
+SnapshotPtr SnapshotRange(duint Start, duint End)
+{
+	if (End <= Start)
+		return nullptr;
+
+	// Whole modules go through the cache, anything else is a private copy
+	if (DbgFunctions()->ModBaseFromAddr(Start) == Start && DbgFunctions()->ModSizeFromAddr(Start) == (End - Start))
+		return SnapshotModule(Start);
+
+	auto snapshot = std::make_shared<ModuleSnapshot>(Start, End - Start);
+
+	if (!snapshot->Data())
+		return nullptr;
+
+	return snapshot;
+}
+
+void SnapshotInvalidateAll()
+{
+	// Anyone still holding a snapshot keeps their copy alive
+	std::lock_guard<std::mutex> lock(g_SnapshotLock);
+	g_Snapshots.clear();
+}
+
+void SnapshotDebugCallback(CBTYPE Type, void *Info)
+{
+	switch (Type)
+	{
+	case CB_PAUSEDEBUG:
+	case CB_LOADDLL:
+	case CB_STOPDEBUG:
+		SnapshotInvalidateAll();
+		break;
+	}
+}
\ No newline at end of file
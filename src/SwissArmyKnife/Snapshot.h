@@ -0,0 +1,60 @@
+#pragma once
+
+//
+// Local copies of debuggee memory shared between every scanner. A module is read
+// once (page by page when needed, unreadable pages are zero filled) and the copy is
+// reused until the debuggee runs again, a module is loaded or debugging stops.
+// Patches made in the meantime only cause the touched pages to be re-read.
+//
+class ModuleSnapshot
+{
+public:
+	ModuleSnapshot(duint Base, duint Size);
+	ModuleSnapshot(const ModuleSnapshot& Other);
+	~ModuleSnapshot();
+
+	ModuleSnapshot& operator=(const ModuleSnapshot&) = delete;
+
+	duint Base() const
+	{
+		return m_Base;
+	}
+
+	duint Size() const
+	{
+		return m_Size;
+	}
+
+	const BYTE *Data() const
+	{
+		return m_Data;
+	}
+
+	// False if the page holding Address couldn't be read (and was zero filled)
+	bool IsReadable(duint Address) const;
+
+	// Patched bytes (address, new value) at the time of the last read
+	const std::map<duint, BYTE>& Patches() const
+	{
+		return m_Patches;
+	}
+
+	void UpdatePatches(const std::map<duint, BYTE>& Patches);
+
+private:
+	void ReadPages(duint Start, duint End);
+
+	duint m_Base;
+	duint m_Size;
+	PBYTE m_Data;
+
+	std::vector<bool> m_ReadablePages;
+	std::map<duint, BYTE> m_Patches;
+};
+
+typedef std::shared_ptr<const ModuleSnapshot> SnapshotPtr;
+
+SnapshotPtr SnapshotModule(duint ModuleBase);
+SnapshotPtr SnapshotRange(duint Start, duint End);
+void SnapshotInvalidateAll();
+void SnapshotDebugCallback(CBTYPE Type, void *Info);
\ No newline at end of file
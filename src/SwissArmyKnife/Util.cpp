@@ -53,6 +53,54 @@ bool DbgEnumMemoryRanges(std::function<bool(duint Start, duint End)> Callback)
 	return true;
 }
 
+bool DbgGetMemoryIndex(MemoryIndex& Index)
+{
+	// One memory map request instead of a bridge call for every pointer check
+	MEMMAP map;
+
+	if (!DbgMemMap(&map))
+	{
+		Index.Build();
+		return false;
+	}
+
+	for (int i = 0; i < map.count; i++)
+	{
+		const MEMORY_BASIC_INFORMATION& mbi = map.page[i].mbi;
+
+		if (mbi.State != MEM_COMMIT || (mbi.Protect & (PAGE_NOACCESS | PAGE_GUARD)))
+			continue;
+
+		duint base = (duint)mbi.BaseAddress;
+		Index.Add(base, base + mbi.RegionSize);
+	}
+
+	if (map.page)
+		BridgeFree(map.page);
+
+	Index.Build();
+	return true;
+}
+
+bool DbgStreamMemory(duint Start, duint End, size_t Overlap, const MemoryStreamCallback& Callback, size_t *UnreadablePages)
+{
+	//
+	// Reads the range one window at a time instead of copying all of it first. Pages
+	// that can't be read are skipped rather than zero filled and scanned.
+	//
+	MemoryStream stream;
+
+	bool result = stream.Scan(Start, End, Overlap, [](uint64_t Address, uint8_t *Buffer, size_t Size)
+	{
+		return DbgMemRead((duint)Address, Buffer, (duint)Size);
+	}, Callback);
+
+	if (UnreadablePages)
+		*UnreadablePages = stream.UnreadablePages();
+
+	return result;
+}
+
 bool OpenSelectionDialog(const char *Title, const char *Filter, bool Save, bool(*Callback)(char *, duint))
 {
 	duint moduleBase = DbgGetCurrentModule();
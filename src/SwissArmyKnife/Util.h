@@ -2,5 +2,7 @@
 
 duint DbgGetCurrentModule();
 bool DbgEnumMemoryRanges(std::function<bool(duint Start, duint End)> Callback);
+bool DbgGetMemoryIndex(MemoryIndex& Index);
+bool DbgStreamMemory(duint Start, duint End, size_t Overlap, const MemoryStreamCallback& Callback, size_t *UnreadablePages = nullptr);
 bool OpenSelectionDialog(const char *Title, const char *Filter, bool Save, bool(*Callback)(char *, duint));
 void StringReplace(std::string& Subject, const std::string& Search, const std::string& Replace);
\ No newline at end of file
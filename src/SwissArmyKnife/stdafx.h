@@ -8,6 +8,9 @@
 //
 #include <windows.h>
 #include <functional>
+#include <memory>
+#include <vector>
+#include <map>
 
 //
 // X64DBG
@@ -44,5 +47,6 @@
 #include "../aes-finder/aes-finder.h"
 
 #include "Util.h"
+#include "Snapshot.h"
 #include "Plugin.h"
 #include "Commands.h"
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+//
+// AES key schedule detection, without any dependency on the debugger so it can
+// also be built into the command line scanner.
+//
+#include <stdint.h>
+#include <functional>
+
+// Receives every key schedule found: its address, whether it's for encryption and the key
+typedef std::function<void(uint64_t Address, bool Encryption, const uint8_t *Key, int Length)> AESKeyCallback;
+
+int find_keys(const uint8_t *buffer, uint64_t total, uint64_t addr, const AESKeyCallback& callback);
+
+//
+// Same, but only checks offsets below limit, starting at offset. Returns with offset set
+// to the next one to check, so a scan split across buffers steps exactly like one pass.
+//
+int find_keys(const uint8_t *buffer, uint64_t total, uint64_t limit, uint64_t addr, const AESKeyCallback& callback, uint64_t& offset);
+
+//
+// The offset to pass to the next of those buffers, at addr: next is where the previous
+// one left off (addr + offset), or the start of the scan for the first. A gap before
+// addr is crossed in whole 4-byte steps, so the scan still checks what one pass would.
+//
+uint64_t find_keys_resume(uint64_t next, uint64_t addr);
+bool aes_finder_self_test();
\ No newline at end of file
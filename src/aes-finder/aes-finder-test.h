@@ -2,8 +2,10 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <vector>
+#include <algorithm>
 
-static void self_test()
+bool aes_finder_self_test()
 {
 	static const uint32_t aes128_encB[] = {
 		0x00010203, 0x04050607, 0x08090a0b, 0x0c0d0e0f,
@@ -288,8 +290,7 @@ static void self_test()
 #define AES_CHECK(fun, reverse, arr, len)                              \
     if (!fun<reverse>(arr, tmp) || memcmp(aes_key, tmp, len) != 0)     \
     {                                                                  \
-        dprintf("Self-test %s<%s>(%s) failed\n", #fun, #reverse, #arr);\
-        abort();                                                       \
+        return false;                                                  \
     }                                                                  \
     else                                                               \
     {                                                                  \
@@ -324,4 +325,59 @@ static void self_test()
 	AES_CHECK(aes256_detect_decB, false, aes256_decLB, 32);
 
 #undef AES_CHECK
+
+	//
+	// Scanning in pieces has to find the same keys as one pass over the whole buffer. One
+	// pass steps by 4 bytes from where it starts, so the key at 302 is only found when
+	// starting at 2, and the other two only when starting at 0. The pieces skip a gap
+	// without keys, like an unreadable page, and have to stay on the same steps after it.
+	//
+	uint8_t buffer[1024];
+
+	for (size_t i = 0; i < sizeof(buffer); i++)
+		buffer[i] = (uint8_t)(i * 37);
+
+	memcpy(&buffer[8], aes128_encB, sizeof(aes128_encB));
+	memcpy(&buffer[302], aes256_decLF, sizeof(aes256_decLF));
+	memcpy(&buffer[sizeof(buffer) - sizeof(aes192_encL)], aes192_encL, sizeof(aes192_encL));
+
+	for (uint64_t first : { 0, 2 })
+	{
+		std::vector<uint64_t> expected;
+		find_keys(&buffer[first], sizeof(buffer) - first, 0x1000 + first, [&](uint64_t Address, bool Encryption, const uint8_t *Key, int Length)
+		{
+			expected.push_back(Address);
+		});
+
+		if (expected.size() != ((first == 0) ? 2 : 1))
+			return false;
+
+		for (uint64_t piece : { 1, 60, 100, 250 })
+		{
+			std::vector<uint64_t> found;
+			uint64_t next = 0x1000 + first;
+
+			for (uint64_t start = first; start < sizeof(buffer);)
+			{
+				// Each piece sees the following bytes as well, like a streamed window, up to the gap
+				uint64_t readable	= (start < 600) ? 600 : sizeof(buffer);
+				uint64_t end		= std::min<uint64_t>(start + piece, readable);
+				uint64_t size		= std::min<uint64_t>(end + 240, readable) - start;
+				uint64_t offset		= find_keys_resume(next, 0x1000 + start);
+
+				find_keys(&buffer[start], size, end - start, 0x1000 + start, [&](uint64_t Address, bool Encryption, const uint8_t *Key, int Length)
+				{
+					found.push_back(Address);
+				}, offset);
+
+				next	= 0x1000 + start + offset;
+				start	= (end == 600) ? 700 : end;
+			}
+
+			if (found != expected)
+				return false;
+		}
+	}
+
+	return true;
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "findcrypt.h"
+#include "findcrypt-core.h"
 
 // Various constants used in crypto algorithms
 // They were copied from public domain codes
@@ -8457,5 +8457,5 @@ const array_info_t non_sparse_consts[] =
   { ARR(zinflate_distanceStarts),         "zlib"           },
   { ARR(zinflate_lengthExtraBits),        "zlib"           },
   { ARR(zinflate_lengthStarts),           "zlib"           },
-  { NULL, 0, NULL, NULL }
+  { nullptr, 0, 0, nullptr }
 };
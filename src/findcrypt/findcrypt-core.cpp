@@ -0,0 +1,545 @@
+#include "findcrypt-core.h"
+#include <string.h>
+#include <set>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// SSE2 is always there on x64; 32-bit builds use the scalar search
+#if defined(_M_X64) || defined(__x86_64__)
+#define FINDCRYPT_SSE2
+#include <emmintrin.h>
+#endif // x64
+
+// Constants are looked up by their first four bytes in a table of 2^N buckets
+const uint32_t FindcryptBucketBits = 12;
+
+// Both searches run over one block at a time while it is still in the cache
+const size_t FindcryptBlockSize = 64 * 1024;
+
+template<typename T>
+static T FindcryptRead(const uint8_t *Data, size_t Size, size_t Offset)
+{
+	// Anything past the end reads as zero
+	if (Offset > Size || sizeof(T) > (Size - Offset))
+		return (T)0;
+
+	T value;
+	memcpy(&value, Data + Offset, sizeof(T));
+	return value;
+}
+
+static uint8_t FindcryptFirstByte(const array_info_t *ai)
+{
+	const uint8_t *ptr = (const uint8_t *)ai->array;
+
+	// The lowest byte of the first element comes first in memory
+#ifndef IS_LITTLE_ENDIAN
+	return ptr[ai->elsize - 1];
+#else
+	return ptr[0];
+#endif // IS_LITTLE_ENDIAN
+}
+
+static bool FindcryptMatchArray(const uint8_t *Data, size_t Size, size_t Offset, const array_info_t *ai)
+{
+	// Elements are stored in the target's byte order, so the whole array compares at once
+	size_t arraySize = ai->size * ai->elsize;
+
+	if (Offset > Size || arraySize > (Size - Offset))
+		return false;
+
+	return memcmp(Data + Offset, ai->array, arraySize) == 0;
+}
+
+static size_t FindcryptWindow(const array_info_t *ai)
+{
+	return ai->window ? ai->window : FindcryptSparseWindow;
+}
+
+static bool FindcryptMatchSparse(const uint8_t *Data, size_t Size, size_t Offset, const array_info_t *ai)
+{
+	// Tables loaded from a database don't have to be aligned
+	const uint8_t *ptr = (const uint8_t *)ai->array;
+	const size_t arraySize = ai->size * sizeof(word32);
+
+	// Match first 4 bytes
+	if (FindcryptRead<word32>(Data, Size, Offset) != FindcryptRead<word32>(ptr, arraySize, 0))
+		return false;
+
+	Offset += 4;
+
+	// Continue with looping the remaining pattern
+	for (size_t i = 1; i < ai->size; i++)
+	{
+		word32 c = FindcryptRead<word32>(ptr, arraySize, i * sizeof(word32));
+
+		// Look for the constant in the next N bytes
+		const size_t N = FindcryptWindow(ai);
+		size_t j;
+
+		for (j = 0; j < N; j++)
+		{
+			if (FindcryptRead<word32>(Data, Size, Offset + j) == c)
+				break;
+		}
+
+		if (j == N)
+			return false;
+
+		Offset += j + 4;
+	}
+
+	return true;
+}
+
+static const char *FindcryptAESNI(const uint8_t *Data, size_t Size, size_t Offset)
+{
+	if (FindcryptRead<uint8_t>(Data, Size, Offset) != 0x66 || FindcryptRead<uint8_t>(Data, Size, Offset + 1) != 0x0f)
+		return nullptr;
+
+	uint8_t escape = FindcryptRead<uint8_t>(Data, Size, Offset + 2);
+	uint8_t opcode = FindcryptRead<uint8_t>(Data, Size, Offset + 3);
+
+	if (escape == 0x38)
+	{
+		switch (opcode)
+		{
+		case 0xdb: return "AESIMC";
+		case 0xdc: return "AESENC";
+		case 0xdd: return "AESENCLAST";
+		case 0xde: return "AESDEC";
+		case 0xdf: return "AESDECLAST";
+		}
+	}
+	else if (escape == 0x3a && opcode == 0xdf)
+	{
+		return "AESKEYGENASSIST";
+	}
+
+	return nullptr;
+}
+
+//
+// Buckets keep arrays before sparse sets, each in table order. Arrays shorter than
+// four bytes have no full prefix and are checked on their own.
+//
+FindcryptMatcher::FindcryptMatcher(const array_info_t *Arrays, const array_info_t *Sparse, const std::shared_ptr<const void>& Owner)
+{
+	m_Arrays	= Arrays;
+	m_Sparse	= Sparse;
+	m_Owner		= Owner;
+
+	std::vector<FINDCRYPT_CANDIDATE> candidates;
+	uint32_t order = 0;
+
+	// AES-NI instructions are four bytes
+	size_t extent = 4;
+
+	for (const array_info_t *ptr = Arrays; ptr->size != 0; ptr++, order++)
+	{
+		if ((ptr->size * ptr->elsize) < sizeof(uint32_t))
+			m_ShortArrays.push_back({ 0, order, false, ptr });
+		else
+			candidates.push_back({ FindcryptRead<uint32_t>((const uint8_t *)ptr->array, sizeof(uint32_t), 0), order, false, ptr });
+
+		extent = std::max(extent, ptr->size * ptr->elsize);
+	}
+
+	// Sparse sets always start with a whole word32
+	for (const array_info_t *ptr = Sparse; ptr->size != 0; ptr++, order++)
+	{
+		candidates.push_back({ FindcryptRead<uint32_t>((const uint8_t *)ptr->array, sizeof(uint32_t), 0), order, true, ptr });
+
+		// The first word, then every later one up to the window after the previous
+		extent = std::max(extent, sizeof(word32) + ((ptr->size - 1) * (FindcryptWindow(ptr) - 1 + sizeof(word32))));
+	}
+
+	m_Overlap = extent - 1;
+
+	// Counting sort by bucket, which keeps the order within each bucket
+	m_BucketStarts.assign((1u << FindcryptBucketBits) + 1, 0);
+
+	for (auto& candidate : candidates)
+		m_BucketStarts[Bucket(candidate.Prefix) + 1]++;
+
+	for (size_t i = 1; i < m_BucketStarts.size(); i++)
+		m_BucketStarts[i] += m_BucketStarts[i - 1];
+
+	std::vector<uint32_t> next(m_BucketStarts.begin(), m_BucketStarts.end() - 1);
+	m_Candidates.resize(candidates.size());
+
+	for (auto& candidate : candidates)
+		m_Candidates[next[Bucket(candidate.Prefix)]++] = candidate;
+}
+
+void FindcryptMatcher::Scan(const uint8_t *Data, size_t Size, size_t Offset, uint32_t Prefix, uint64_t Address, const FindcryptMatchCallback& Match) const
+{
+	uint32_t bucket = Bucket(Prefix);
+
+	// Nothing can start with these four bytes, the common case
+	if (m_BucketStarts[bucket] == m_BucketStarts[bucket + 1] && m_ShortArrays.empty())
+		return;
+
+	const FINDCRYPT_CANDIDATE *array = nullptr;
+	const FINDCRYPT_CANDIDATE *sparse = nullptr;
+
+	for (uint32_t i = m_BucketStarts[bucket]; i < m_BucketStarts[bucket + 1]; i++)
+	{
+		const FINDCRYPT_CANDIDATE *candidate = &m_Candidates[i];
+
+		if (candidate->Prefix != Prefix)
+			continue;
+
+		if (!candidate->Sparse && !array && FindcryptMatchArray(Data, Size, Offset, candidate->Info))
+			array = candidate;
+		else if (candidate->Sparse && !sparse && FindcryptMatchSparse(Data, Size, Offset, candidate->Info))
+			sparse = candidate;
+	}
+
+	for (auto& candidate : m_ShortArrays)
+	{
+		if (array && array->Order < candidate.Order)
+			break;
+
+		if (Data[Offset] == FindcryptFirstByte(candidate.Info) && FindcryptMatchArray(Data, Size, Offset, candidate.Info))
+		{
+			array = &candidate;
+			break;
+		}
+	}
+
+	if (array)
+		Match({ Address + Offset, FINDCRYPT_MATCH_ARRAY, array->Info->name, array->Info->algorithm });
+
+	if (sparse)
+		Match({ Address + Offset, FINDCRYPT_MATCH_SPARSE, sparse->Info->name, sparse->Info->algorithm });
+}
+
+uint32_t FindcryptMatcher::Bucket(uint32_t Prefix)
+{
+	return (Prefix * 0x9E3779B1u) >> (32 - FindcryptBucketBits);
+}
+
+static std::mutex FindcryptMatcherLock;
+static FindcryptMatcherPtr FindcryptCurrentMatcher;
+
+FindcryptMatcherPtr FindcryptGetMatcher()
+{
+	std::lock_guard<std::mutex> guard(FindcryptMatcherLock);
+
+	// The built-in tables are indexed on first use
+	if (!FindcryptCurrentMatcher)
+		FindcryptCurrentMatcher = std::make_shared<const FindcryptMatcher>(non_sparse_consts, sparse_consts, nullptr);
+
+	return FindcryptCurrentMatcher;
+}
+
+void FindcryptSetMatcher(const FindcryptMatcherPtr& Matcher)
+{
+	std::lock_guard<std::mutex> guard(FindcryptMatcherLock);
+	FindcryptCurrentMatcher = Matcher;
+}
+
+static inline unsigned int FindcryptTrailingZeros(uint32_t Value)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, Value);
+	return index;
+#else
+	return __builtin_ctz(Value);
+#endif // _MSC_VER
+}
+
+//
+// Appends every offset in [Start, End) that begins with 66 0F 38 or 66 0F 3A, the
+// escapes of every AES-NI instruction. Bytes up to Size can be read.
+//
+static void FindcryptFindEscapes(const uint8_t *Data, size_t Size, size_t Start, size_t End, std::vector<size_t>& Offsets)
+{
+	size_t i = Start;
+
+#ifdef FINDCRYPT_SSE2
+	const __m128i prefix	= _mm_set1_epi8(0x66);
+	const __m128i escape	= _mm_set1_epi8(0x0F);
+	const __m128i map		= _mm_set1_epi8(0x38);
+	const __m128i mapMask	= _mm_set1_epi8((char)0xFD);
+
+	// Three overlapping loads compare sixteen starting offsets at once
+	for (; i < End && (i + 16 + 2) <= Size; i += 16)
+	{
+		__m128i hits = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(Data + i)), prefix);
+		hits = _mm_and_si128(hits, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(Data + i + 1)), escape));
+		hits = _mm_and_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128((const __m128i *)(Data + i + 2)), mapMask), map));
+
+		for (uint32_t mask = (uint32_t)_mm_movemask_epi8(hits); mask != 0; mask &= mask - 1)
+		{
+			size_t offset = i + FindcryptTrailingZeros(mask);
+
+			if (offset < End)
+				Offsets.push_back(offset);
+		}
+	}
+#endif // FINDCRYPT_SSE2
+
+	// 0x38 and 0x3A only differ in bit 1
+	for (; i < End; i++)
+	{
+		if (Data[i] == 0x66 && (i + 2) < Size && Data[i + 1] == 0x0F && (Data[i + 2] & 0xFD) == 0x38)
+			Offsets.push_back(i);
+	}
+}
+
+void FindcryptScanBuffer(const uint8_t *Data, size_t Size, uint64_t Address, const FindcryptMatchCallback& Match, const FindcryptProgressCallback& Progress)
+{
+	FindcryptScanBuffer(*FindcryptGetMatcher(), Data, Size, Address, Match, Progress);
+}
+
+void FindcryptScanBuffer(const FindcryptMatcher& Matcher, const uint8_t *Data, size_t Size, uint64_t Address, const FindcryptMatchCallback& Match, const FindcryptProgressCallback& Progress)
+{
+
+	// Only the last three offsets need the bounds-checked read
+	size_t whole = (Size >= sizeof(uint32_t)) ? (Size - sizeof(uint32_t) + 1) : 0;
+
+	auto scanConstants = [&](size_t Start, size_t End)
+	{
+		for (size_t i = Start; i < End; i++)
+		{
+			uint32_t prefix;
+
+			if (i < whole)
+				memcpy(&prefix, Data + i, sizeof(uint32_t));
+			else
+				prefix = FindcryptRead<uint32_t>(Data, Size, i);
+
+			Matcher.Scan(Data, Size, i, prefix, Address, Match);
+		}
+	};
+
+	auto lastProgress = std::chrono::steady_clock::now();
+	std::vector<size_t> escapes;
+
+	for (size_t block = 0; block < Size; block += FindcryptBlockSize)
+	{
+		size_t end = block + std::min(FindcryptBlockSize, Size - block);
+
+		escapes.clear();
+		FindcryptFindEscapes(Data, Size, block, end, escapes);
+
+		// Constants up to each instruction, so everything comes out in address order
+		size_t next = block;
+
+		for (size_t offset : escapes)
+		{
+			if (const char *instruction = FindcryptAESNI(Data, Size, offset))
+			{
+				scanConstants(next, offset + 1);
+				Match({ Address + offset, FINDCRYPT_MATCH_AESNI, instruction, nullptr });
+
+				next = offset + 1;
+			}
+		}
+
+		scanConstants(next, end);
+
+		if (Progress)
+		{
+			auto now = std::chrono::steady_clock::now();
+
+			if (now - lastProgress >= std::chrono::milliseconds(FindcryptProgressInterval))
+			{
+				lastProgress = now;
+				Progress(Address + end);
+			}
+		}
+	}
+}
+
+size_t FindcryptOverlap()
+{
+	return FindcryptGetMatcher()->Overlap();
+}
+
+void FindcryptScanRanges(const std::vector<FINDCRYPT_RANGE>& Ranges, const FindcryptReadCallback& Read, const FindcryptMatchCallback& Match,
+	const FindcryptProgressCallback& Progress, size_t ChunkSize, size_t ThreadCount)
+{
+	struct FINDCRYPT_CHUNK
+	{
+		uint64_t Start;
+		uint64_t End;
+		uint64_t RangeEnd;
+
+		std::vector<FINDCRYPT_MATCH> Matches;
+		bool Done;
+	};
+
+	std::vector<FINDCRYPT_CHUNK> chunks;
+	ChunkSize = std::max<size_t>(ChunkSize, 1);
+
+	for (auto& range : Ranges)
+	{
+		for (uint64_t start = range.Start; start < range.End;)
+		{
+			uint64_t end = start + std::min<uint64_t>(ChunkSize, range.End - start);
+
+			chunks.push_back({ start, end, range.End, {}, false });
+			start = end;
+		}
+	}
+
+	if (chunks.empty())
+		return;
+
+	size_t threadCount = ThreadCount ? ThreadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	threadCount = std::min(threadCount, chunks.size());
+
+	//
+	// Workers claim chunks in ascending order, but never run more than a few chunks
+	// ahead of the caller. That bounds the memory held by chunks (and results) which
+	// haven't been handed to the callback yet.
+	//
+	std::mutex lock;
+	std::condition_variable changed;
+
+	// Every chunk is scanned with the tables in use when the scan started
+	FindcryptMatcherPtr matcher = FindcryptGetMatcher();
+
+	const size_t maxInFlight	= threadCount * 4;
+	const size_t overlap		= matcher->Overlap();
+	size_t nextChunk			= 0;
+	size_t delivered			= 0;
+
+	auto worker = [&]()
+	{
+		std::vector<uint8_t> buffer;
+
+		for (;;)
+		{
+			size_t index;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				changed.wait(guard, [&] { return nextChunk >= chunks.size() || nextChunk < (delivered + maxInFlight); });
+
+				if (nextChunk >= chunks.size())
+					return;
+
+				index = nextChunk++;
+			}
+
+			FINDCRYPT_CHUNK& chunk = chunks[index];
+			size_t size = (size_t)((chunk.End - chunk.Start) + std::min<uint64_t>(overlap, chunk.RangeEnd - chunk.End));
+
+			buffer.resize(size);
+
+			// Matches starting in the overlap belong to the next chunk
+			std::vector<FINDCRYPT_MATCH> matches;
+
+			auto scan = [&](size_t Offset, size_t Size)
+			{
+				if (Size == 0 || Offset >= (chunk.End - chunk.Start))
+					return;
+
+				FindcryptScanBuffer(*matcher, buffer.data() + Offset, Size, chunk.Start + Offset, [&](const FINDCRYPT_MATCH& Match)
+				{
+					if (Match.Address < chunk.End)
+						matches.push_back(Match);
+				}, nullptr);
+			};
+
+			// Only fall back to single pages when the full read fails
+			if (Read(chunk.Start, buffer.data(), size))
+			{
+				scan(0, size);
+			}
+			else
+			{
+				size_t runStart = 0;
+
+				for (size_t offset = 0; offset < size;)
+				{
+					uint64_t address	= chunk.Start + offset;
+					size_t piece		= (size_t)std::min<uint64_t>(FindcryptPageSize - (address % FindcryptPageSize), size - offset);
+
+					if (!Read(address, buffer.data() + offset, piece))
+					{
+						scan(runStart, offset - runStart);
+						runStart = offset + piece;
+					}
+
+					offset += piece;
+				}
+
+				scan(runStart, size - runStart);
+			}
+
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				chunk.Matches.swap(matches);
+				chunk.Done = true;
+			}
+
+			changed.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < threadCount; i++)
+		threads.emplace_back(worker);
+
+	auto lastProgress = std::chrono::steady_clock::now();
+
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		std::vector<FINDCRYPT_MATCH> matches;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			changed.wait(guard, [&] { return chunks[i].Done; });
+
+			matches.swap(chunks[i].Matches);
+			delivered = i + 1;
+		}
+
+		changed.notify_all();
+
+		for (auto& match : matches)
+			Match(match);
+
+		if (Progress)
+		{
+			auto now = std::chrono::steady_clock::now();
+
+			if (now - lastProgress >= std::chrono::milliseconds(FindcryptProgressInterval))
+			{
+				lastProgress = now;
+				Progress(chunks[i].End);
+			}
+		}
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+const array_info_t *FindcryptFindDuplicate(const array_info_t *Consts)
+{
+	std::set<std::string> myset;
+
+	// Verifies that all algorithm entries are different
+	for (const array_info_t *ptr = Consts; ptr->size != 0; ptr++)
+	{
+		std::string s((const char *)ptr->array, ptr->size);
+
+		if (!myset.insert(s).second)
+			return ptr;
+	}
+
+	return nullptr;
+}
+
+#include "findcrypt-test.h"
\ No newline at end of file
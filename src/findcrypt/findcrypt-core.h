@@ -0,0 +1,175 @@
+#pragma once
+
+//
+// The constant and AES-NI matchers behind Findcrypt. They only look at a local buffer;
+// the plugin and the command line scanner both report through the callbacks.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+#include <memory>
+
+#define IS_LITTLE_ENDIAN
+
+#if defined(__GNUC__) || defined(__MWERKS__)
+	#define WORD64_AVAILABLE
+	typedef unsigned long long word64;
+	typedef unsigned int word32;
+	typedef unsigned char byte;
+	#define W64LIT(x) x##LL
+#elif defined(_MSC_VER) || defined(__BCPLUSPLUS__)
+	#define WORD64_AVAILABLE
+	typedef unsigned __int64 word64;
+	typedef unsigned __int32 word32;
+	typedef unsigned __int8 byte;
+	#define W64LIT(x) x##ui64
+#endif
+
+struct array_info_t
+{
+	const void *array;
+	size_t size;
+	size_t elsize;
+	const char *name;
+	const char *algorithm;
+	size_t window;		// Sparse sets: bytes searched for each next word (0 = FindcryptSparseWindow)
+};
+
+// Default number of bytes after a sparse word that the next one may start in
+const size_t FindcryptSparseWindow = 64;
+
+extern const array_info_t non_sparse_consts[];
+extern const array_info_t sparse_consts[];
+
+#define ARR(x)  x, (sizeof(x) / sizeof(x[0])), sizeof(x[0]), #x
+
+enum FINDCRYPT_MATCH_TYPE
+{
+	FINDCRYPT_MATCH_ARRAY,
+	FINDCRYPT_MATCH_SPARSE,
+	FINDCRYPT_MATCH_AESNI,
+};
+
+struct FINDCRYPT_MATCH
+{
+	uint64_t Address;
+	FINDCRYPT_MATCH_TYPE Type;
+	const char *Name;		// Array name, or the instruction for AES-NI matches
+	const char *Algorithm;	// nullptr for AES-NI matches
+};
+
+typedef std::function<void(const FINDCRYPT_MATCH& Match)> FindcryptMatchCallback;
+typedef std::function<void(uint64_t Address)> FindcryptProgressCallback;
+
+// Fills Buffer with the Size bytes at Address; false if any of them couldn't be read
+typedef std::function<bool(uint64_t Address, uint8_t *Buffer, size_t Size)> FindcryptReadCallback;
+
+struct FINDCRYPT_RANGE
+{
+	uint64_t Start;
+	uint64_t End;
+};
+
+// Default amount of a range each worker reads and scans at once
+const size_t FindcryptChunkSize = 4 * 1024 * 1024;
+
+// Granularity of readable memory when a chunk can't be read in one go
+const size_t FindcryptPageSize = 0x1000;
+
+// Minimum time in milliseconds between two progress callbacks
+const uint32_t FindcryptProgressInterval = 250;
+
+//
+// Reports every constant array, sparse constant set and AES-NI instruction in Data in
+// address order, with Address being the address of Data[0]. Constants come from the
+// tables currently in use (FindcryptGetMatcher), looked up by their first four bytes,
+// so the cost per byte doesn't grow with the number of constants. Both searches run in
+// a single pass over 64KB blocks. Progress (optional) gets the address scanned up to,
+// at most every FindcryptProgressInterval milliseconds.
+//
+void FindcryptScanBuffer(const uint8_t *Data, size_t Size, uint64_t Address, const FindcryptMatchCallback& Match, const FindcryptProgressCallback& Progress);
+
+//
+// Scans Ranges (sorted, not overlapping) on a pool of threads. Every range is split
+// into chunks that workers claim in order and read with Read, each extended by the
+// overlap of the tables in use so matches crossing into the next chunk are still found.
+// A chunk that fails to read is read again page by page and only the runs of readable
+// pages are scanned, so nothing is reported in (or across) unreadable memory.
+// Match and Progress are only called on the calling thread, with matches in the same
+// order FindcryptScanBuffer would report them range by range. ThreadCount 0 uses one
+// thread per core.
+//
+void FindcryptScanRanges(const std::vector<FINDCRYPT_RANGE>& Ranges, const FindcryptReadCallback& Read, const FindcryptMatchCallback& Match,
+	const FindcryptProgressCallback& Progress, size_t ChunkSize = FindcryptChunkSize, size_t ThreadCount = 0);
+
+struct FINDCRYPT_CANDIDATE
+{
+	uint32_t Prefix;			// First four bytes in memory
+	uint32_t Order;				// Table position; the first matching array wins
+	bool Sparse;
+	const array_info_t *Info;
+};
+
+//
+// A set of constant tables (both terminated by an entry with size 0) compiled into one
+// hash index over the first four bytes of each entry, so an offset costs a single
+// bucket lookup no matter how many constants there are. Owner keeps whatever holds the
+// tables alive for as long as the matcher is around.
+//
+class FindcryptMatcher
+{
+public:
+	FindcryptMatcher(const array_info_t *Arrays, const array_info_t *Sparse, const std::shared_ptr<const void>& Owner);
+
+	// Prefix is the (zero-padded) four bytes at Offset
+	void Scan(const uint8_t *Data, size_t Size, size_t Offset, uint32_t Prefix, uint64_t Address, const FindcryptMatchCallback& Match) const;
+
+	const array_info_t *Arrays() const
+	{
+		return m_Arrays;
+	}
+
+	const array_info_t *Sparse() const
+	{
+		return m_Sparse;
+	}
+
+	// Bytes past its start that a match can depend on, minus one
+	size_t Overlap() const
+	{
+		return m_Overlap;
+	}
+
+private:
+	static uint32_t Bucket(uint32_t Prefix);
+
+	const array_info_t *m_Arrays;
+	const array_info_t *m_Sparse;
+	std::shared_ptr<const void> m_Owner;
+	size_t m_Overlap;
+
+	std::vector<uint32_t> m_BucketStarts;
+	std::vector<FINDCRYPT_CANDIDATE> m_Candidates;
+	std::vector<FINDCRYPT_CANDIDATE> m_ShortArrays;
+};
+
+typedef std::shared_ptr<const FindcryptMatcher> FindcryptMatcherPtr;
+
+//
+// The tables every scan uses: the built-in ones until others are installed. Scans that
+// are already running keep the matcher they started with.
+//
+FindcryptMatcherPtr FindcryptGetMatcher();
+void FindcryptSetMatcher(const FindcryptMatcherPtr& Matcher);
+
+// FindcryptScanBuffer with a specific set of tables
+void FindcryptScanBuffer(const FindcryptMatcher& Matcher, const uint8_t *Data, size_t Size, uint64_t Address, const FindcryptMatchCallback& Match, const FindcryptProgressCallback& Progress);
+
+// Overlap() of the tables currently in use
+size_t FindcryptOverlap();
+
+// Returns the first entry with the same contents as an earlier one, nullptr if there are none
+const array_info_t *FindcryptFindDuplicate(const array_info_t *Consts);
+
+bool FindcryptSelfTest();
\ No newline at end of file
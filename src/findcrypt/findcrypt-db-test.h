@@ -0,0 +1,214 @@
+#pragma once
+
+//
+// Compiles a C++ source in the style of consts.cpp and a YAML list into a database,
+// loads it back and scans a buffer with every table planted: zero-filled and negative
+// elements, both byte orders and a sparse set spread wider than the default window.
+// Duplicates, bad sources and damaged files have to be rejected, and installing the
+// tables has to change what FindcryptScanBuffer finds until the old ones are restored.
+//
+bool FindcryptDatabaseSelfTest()
+{
+	const char cpp[] =
+		"#include \"findcrypt-core.h\"\n"
+		"/* Block\n   comment */\n"
+		"static const word32 Test_words[4] = {\n"
+		"#ifdef IS_LITTLE_ENDIAN // Only this branch\n"
+		"  0x11223344L, 0x55667788, /* 2 */ 0x99AABBCC,\n"
+		"#elif 1\n"
+		"  0x44332211L,\n"
+		"#else\n"
+		"  0x44332211L,\n"
+		"#endif\n"
+		"};\n"
+		"#if !defined(IS_LITTLE_ENDIAN)\n"
+		"static const byte Test_hidden[] = { 1 };\n"
+		"#endif\n"
+		"static const word64 Test_wide[] = { W64LIT(0x0102030405060708), W64LIT(0x1112131415161718) };\n"
+		"static const byte Test_bytes[2*3] = { 1, 2, 3, 4, 5, 250 };\n"
+		"static const signed char Test_signed[] = { -1, -2, 3, 4, 'A' };\n"
+		"static const word32 Test_sparse[] = { 0xCAFEBABE, 0xDEADBEEF, 0x0BADF00D };\n"
+		"static const byte Test_unused[] = { 9, 9, 9, 9 };\n"
+		"const array_info_t non_sparse_consts[] =\n"
+		"{\n"
+		"  { ARR(Test_words),  \"Words\"  },\n"
+		"  { ARR(Test_wide),   \"Wide\"   },\n"
+		"  { ARR(Test_bytes),  \"Bytes\"  },\n"
+		"  { ARR(Test_signed), \"Signed\" },\n"
+		"  { nullptr, 0, 0, nullptr }\n"
+		"};\n"
+		"const array_info_t sparse_consts[] =\n"
+		"{\n"
+		"  { ARR(Test_sparse), \"Sparse\" },\n"
+		"  { nullptr, 0, 0, nullptr }\n"
+		"};\n";
+
+	const char yaml[] =
+		"# Comment\n"
+		"- name: Test_both\n"
+		"  algorithm: \"Both # orders\"\n"
+		"  element: 2\n"
+		"  endian: both\n"
+		"  values: [0x1234, 0x5678,\n"
+		"           0x9ABC, -2]\n"
+		"\n"
+		"- name: Test_wide_sparse\n"
+		"  algorithm: Wide sparse\n"
+		"  type: sparse\n"
+		"  window: 200\n"
+		"  values:\n"
+		"    - 0x13579BDF\n"
+		"    - 0x2468ACE0\n";
+
+	std::vector<FINDCRYPT_CONSTANT> constants;
+	std::string error;
+
+	if (!FindcryptParseCpp(cpp, sizeof(cpp) - 1, constants, error) || constants.size() != 5)
+		return false;
+
+	// One #if branch, zero filled to the declared size, two's complement for negative values
+	if (constants[0].Values != std::vector<uint64_t>({ 0x11223344, 0x55667788, 0x99AABBCC, 0 }) || constants[1].ElementSize != 8 ||
+		constants[3].Values != std::vector<uint64_t>({ 0xFF, 0xFE, 3, 4, 'A' }) || constants[4].Type != FINDCRYPT_DB_SPARSE ||
+		constants[2].Algorithm != "Bytes")
+		return false;
+
+	if (!FindcryptParseYaml(yaml, sizeof(yaml) - 1, constants, error) || constants.size() != 7)
+		return false;
+
+	if (constants[5].Algorithm != "Both # orders" || constants[5].Values != std::vector<uint64_t>({ 0x1234, 0x5678, 0x9ABC, 0xFFFE }) ||
+		constants[6].Window != 200 || constants[6].Values.size() != 2)
+		return false;
+
+	std::vector<uint8_t> database;
+
+	if (!FindcryptCompileDatabase(constants, database, error))
+		return false;
+
+	FindcryptMatcherPtr matcher = FindcryptLoadDatabase(database.data(), database.size(), nullptr);
+
+	if (!matcher)
+		return false;
+
+	// Five arrays (one in both byte orders) and two sparse sets
+	size_t arrays = 0;
+	size_t sparse = 0;
+
+	for (const array_info_t *ptr = matcher->Arrays(); ptr->size != 0; ptr++)
+		arrays++;
+
+	for (const array_info_t *ptr = matcher->Sparse(); ptr->size != 0; ptr++)
+		sparse++;
+
+	if (arrays != 6 || sparse != 2 || matcher->Overlap() < (4 + 199 + 4 - 1))
+		return false;
+
+	// Every table in a buffer of filler
+	std::vector<uint8_t> data(4096, 0x90);
+	std::vector<std::pair<size_t, std::string>> expected;
+
+	auto plant = [&](size_t Offset, const std::vector<uint8_t>& Bytes, const char *Name)
+	{
+		memcpy(&data[Offset], Bytes.data(), Bytes.size());
+		expected.push_back({ Offset, Name });
+	};
+
+	plant(100, { 0x44, 0x33, 0x22, 0x11, 0x88, 0x77, 0x66, 0x55, 0xCC, 0xBB, 0xAA, 0x99, 0, 0, 0, 0 }, "Test_words");
+	plant(200, { 8, 7, 6, 5, 4, 3, 2, 1, 0x18, 0x17, 0x16, 0x15, 0x14, 0x13, 0x12, 0x11 }, "Test_wide");
+	plant(300, { 1, 2, 3, 4, 5, 250 }, "Test_bytes");
+	plant(400, { 0xFF, 0xFE, 3, 4, 'A' }, "Test_signed");
+	plant(500, { 0x34, 0x12, 0x78, 0x56, 0xBC, 0x9A, 0xFE, 0xFF }, "Test_both");
+	plant(600, { 0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xFF, 0xFE }, "Test_both");
+
+	// Sparse sets with their words apart
+	plant(700, { 0xBE, 0xBA, 0xFE, 0xCA }, "Test_sparse");
+	memcpy(&data[740], "\xEF\xBE\xAD\xDE", 4);
+	memcpy(&data[780], "\x0D\xF0\xAD\x0B", 4);
+
+	plant(1000, { 0xDF, 0x9B, 0x57, 0x13 }, "Test_wide_sparse");
+	memcpy(&data[1150], "\xE0\xAC\x68\x24", 4);
+
+	std::vector<std::pair<size_t, std::string>> found;
+
+	auto collect = [&](const FINDCRYPT_MATCH& Match)
+	{
+		if (Match.Type != FINDCRYPT_MATCH_AESNI)
+			found.push_back({ (size_t)Match.Address, Match.Name });
+	};
+
+	FindcryptScanBuffer(*matcher, data.data(), data.size(), 0, collect, nullptr);
+
+	if (found != expected)
+		return false;
+
+	// Installed for every scan, then back to the previous tables
+	FindcryptMatcherPtr previous = FindcryptGetMatcher();
+	FindcryptSetMatcher(matcher);
+
+	found.clear();
+	FindcryptScanBuffer(data.data(), data.size(), 0, collect, nullptr);
+
+	bool installed = found == expected && FindcryptOverlap() == matcher->Overlap();
+	FindcryptSetMatcher(previous);
+
+	found.clear();
+	FindcryptScanBuffer(data.data(), data.size(), 0, collect, nullptr);
+
+	if (!installed || !found.empty())
+		return false;
+
+	// Damaged or different files
+	for (size_t size = 0; size < database.size(); size++)
+	{
+		if (FindcryptLoadDatabase(database.data(), size, nullptr))
+			return false;
+	}
+
+	std::vector<uint8_t> other(database);
+	other[8]++;
+
+	if (FindcryptLoadDatabase(other.data(), other.size(), nullptr))
+		return false;
+
+	// The same contents twice, values that don't fit and broken sources
+	std::vector<FINDCRYPT_CONSTANT> duplicate(constants);
+	duplicate.push_back(constants[2]);
+	duplicate.back().Name = "Test_copy";
+
+	if (FindcryptCompileDatabase(duplicate, database, error))
+		return false;
+
+	const char *badCpp[] =
+	{
+		"static const byte Test[2] = { 1, 2, 3 };",
+		"static const byte Test[] = { 256 };",
+		"static const float Test[] = { 1 };",
+		"static const byte Test[] = { 1 }; const array_info_t t[] = { { ARR(Other), \"X\" }, };",
+	};
+
+	for (const char *text : badCpp)
+	{
+		std::vector<FINDCRYPT_CONSTANT> ignored;
+
+		if (FindcryptParseCpp(text, strlen(text), ignored, error))
+			return false;
+	}
+
+	const char *badYaml[] =
+	{
+		"name: Test\n",
+		"- name: Test\n  algorithm: X\n",
+		"- name: Test\n  algorithm: X\n  element: 1\n  values: [256]\n",
+		"- name: Test\n  algorithm: X\n  endian: middle\n  values: [1]\n",
+		"- name: Test\n  algorithm: X\n  values: [1,\n",
+	};
+
+	for (const char *text : badYaml)
+	{
+		std::vector<FINDCRYPT_CONSTANT> ignored;
+
+		if (FindcryptParseYaml(text, strlen(text), ignored, error))
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
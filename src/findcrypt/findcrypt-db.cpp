@@ -0,0 +1,923 @@
+#include "findcrypt-db.h"
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <set>
+#include <algorithm>
+
+// Largest sparse window, which keeps the overlap between scanned chunks bounded
+const uint32_t FindcryptDatabaseMaxWindow = 4096;
+
+struct FINDCRYPT_TOKEN
+{
+	std::string Text;
+	int Line;
+};
+
+static std::string FindcryptLineError(int Line, const std::string& Message)
+{
+	return "line " + std::to_string(Line) + ": " + Message;
+}
+
+static bool FindcryptParseNumber(std::string Text, uint64_t& Value)
+{
+	// Integer suffixes (0x726a8f3bL, 1000u, 5ULL)
+	while (!Text.empty() && strchr("uUlL", Text.back()))
+		Text.pop_back();
+
+	if (Text.empty() || !isdigit((unsigned char)Text[0]))
+		return false;
+
+	char *end = nullptr;
+	Value = strtoull(Text.c_str(), &end, 0);
+
+	return *end == '\0';
+}
+
+static bool FindcryptFits(uint64_t Value, uint32_t ElementSize)
+{
+	return ElementSize >= sizeof(uint64_t) || (Value >> (ElementSize * 8)) == 0;
+}
+
+static uint64_t FindcryptTruncate(int64_t Value, uint32_t ElementSize)
+{
+	// Negative values are stored in two's complement, like the compiler would
+	if (ElementSize >= sizeof(uint64_t))
+		return (uint64_t)Value;
+
+	return (uint64_t)Value & ((1ull << (ElementSize * 8)) - 1);
+}
+
+struct FINDCRYPT_CONDITION
+{
+	bool ParentActive;
+	bool Taken;				// A branch of this #if was already active
+	bool Active;
+};
+
+//
+// Evaluates #ifdef, #ifndef and the simple forms of #if (a number, "defined X" or
+// "!defined X") against the macros defined so far. Anything else counts as false.
+//
+static bool FindcryptEvaluateCondition(const std::string& Directive, const std::string& Expression, const std::set<std::string>& Defines)
+{
+	std::string text;
+
+	for (char c : Expression)
+	{
+		if (!isspace((unsigned char)c) && c != '(' && c != ')')
+			text += c;
+	}
+
+	if (Directive == "ifdef")
+		return Defines.count(text) > 0;
+
+	if (Directive == "ifndef")
+		return Defines.count(text) == 0;
+
+	bool negate = !text.empty() && text[0] == '!';
+
+	if (negate)
+		text.erase(0, 1);
+
+	bool value = false;
+
+	if (text.compare(0, 7, "defined") == 0)
+		value = Defines.count(text.substr(7)) > 0;
+	else if (!text.empty() && isdigit((unsigned char)text[0]))
+		value = strtoull(text.c_str(), nullptr, 0) != 0;
+
+	return value != negate;
+}
+
+//
+// Splits C++ source into identifiers/numbers, string and character literals and single
+// punctuation characters. Comments are dropped and so is code in inactive #if branches,
+// starting from the macros findcrypt-core.h defines.
+//
+static void FindcryptTokenize(const char *Text, size_t Size, std::vector<FINDCRYPT_TOKEN>& Tokens)
+{
+	int line = 1;
+	bool lineStart = true;
+
+	std::set<std::string> defines = { "IS_LITTLE_ENDIAN", "WORD64_AVAILABLE" };
+	std::vector<FINDCRYPT_CONDITION> conditions;
+	bool active = true;
+
+	for (size_t i = 0; i < Size;)
+	{
+		char c = Text[i];
+
+		if (c == '\n')
+		{
+			line++;
+			lineStart = true;
+			i++;
+		}
+		else if (isspace((unsigned char)c))
+		{
+			i++;
+		}
+		else if (c == '#' && lineStart)
+		{
+			size_t start = ++i;
+
+			while (i < Size && Text[i] != '\n' && !(Text[i] == '/' && (i + 1) < Size && (Text[i + 1] == '/' || Text[i + 1] == '*')))
+				i++;
+
+			std::string directive(Text + start, i - start);
+			size_t nameStart = directive.find_first_not_of(" \t");
+			size_t nameEnd = directive.find_first_of(" \t(", nameStart);
+
+			std::string name = (nameStart != std::string::npos) ? directive.substr(nameStart, nameEnd - nameStart) : "";
+			std::string rest = (nameEnd != std::string::npos) ? directive.substr(nameEnd) : "";
+
+			if (name == "if" || name == "ifdef" || name == "ifndef")
+			{
+				bool value = active && FindcryptEvaluateCondition(name, rest, defines);
+				conditions.push_back({ active, value, value });
+			}
+			else if ((name == "elif" || name == "else") && !conditions.empty())
+			{
+				FINDCRYPT_CONDITION& condition = conditions.back();
+				condition.Active = condition.ParentActive && !condition.Taken && (name == "else" || FindcryptEvaluateCondition(name, rest, defines));
+				condition.Taken = condition.Taken || condition.Active;
+			}
+			else if (name == "endif" && !conditions.empty())
+			{
+				conditions.pop_back();
+			}
+			else if (active && (name == "define" || name == "undef"))
+			{
+				size_t macroStart = rest.find_first_not_of(" \t");
+				size_t macroEnd = rest.find_first_of(" \t(", macroStart);
+
+				if (macroStart != std::string::npos)
+				{
+					std::string macro = rest.substr(macroStart, macroEnd - macroStart);
+
+					if (name == "define")
+						defines.insert(macro);
+					else
+						defines.erase(macro);
+				}
+			}
+
+			active = conditions.empty() || conditions.back().Active;
+
+			// Whatever is left of the line (a comment) goes through the loop again
+			while (i < Size && Text[i] != '\n' && Text[i] != '/')
+				i++;
+		}
+		else if (c == '/' && (i + 1) < Size && Text[i + 1] == '/')
+		{
+			while (i < Size && Text[i] != '\n')
+				i++;
+		}
+		else if (c == '/' && (i + 1) < Size && Text[i + 1] == '*')
+		{
+			for (i += 2; i < Size && !(Text[i] == '*' && (i + 1) < Size && Text[i + 1] == '/'); i++)
+				line += (Text[i] == '\n') ? 1 : 0;
+
+			i = std::min(i + 2, Size);
+		}
+		else
+		{
+			size_t start = i;
+			lineStart = false;
+
+			if (c == '"' || c == '\'')
+			{
+				for (i++; i < Size && Text[i] != c && Text[i] != '\n'; i++)
+					i += (Text[i] == '\\') ? 1 : 0;
+
+				i = std::min(i + 1, Size);
+			}
+			else if (isalnum((unsigned char)c) || c == '_')
+			{
+				while (i < Size && (isalnum((unsigned char)Text[i]) || Text[i] == '_'))
+					i++;
+			}
+			else
+			{
+				i++;
+			}
+
+			if (active)
+				Tokens.push_back({ std::string(Text + start, i - start), line });
+		}
+	}
+}
+
+static uint32_t FindcryptTypeSize(const std::vector<std::string>& Words)
+{
+	auto has = [&](const char *Word)
+	{
+		return std::count(Words.begin(), Words.end(), Word);
+	};
+
+	// Sizes on the plugin's targets, where long is 32 bits
+	if (has("word64") || has("uint64_t") || has("int64_t") || has("__int64") || has("long") >= 2)
+		return 8;
+
+	if (has("word16") || has("uint16_t") || has("int16_t") || has("short") || has("WORD"))
+		return 2;
+
+	if (has("byte") || has("uint8_t") || has("int8_t") || has("char") || has("BYTE"))
+		return 1;
+
+	if (has("word32") || has("uint32_t") || has("int32_t") || has("int") || has("long") || has("unsigned") || has("DWORD"))
+		return 4;
+
+	return 0;
+}
+
+bool FindcryptParseCpp(const char *Text, size_t Size, std::vector<FINDCRYPT_CONSTANT>& Constants, std::string& Error)
+{
+	std::vector<FINDCRYPT_TOKEN> tokens;
+	FindcryptTokenize(Text, Size, tokens);
+
+	// Arrays by name, in the order the tables list them
+	std::map<std::string, FINDCRYPT_CONSTANT> arrays;
+	std::vector<FINDCRYPT_CONSTANT> listed;
+
+	size_t i = 0;
+
+	auto at = [&](size_t Index) -> const std::string&
+	{
+		static const std::string end;
+		return (Index < tokens.size()) ? tokens[Index].Text : end;
+	};
+
+	auto lineAt = [&](size_t Index)
+	{
+		return tokens.empty() ? 1 : tokens[std::min(Index, tokens.size() - 1)].Line;
+	};
+
+	// Skips to the end of the current statement, including any braces in it
+	auto skipStatement = [&]()
+	{
+		for (int depth = 0; i < tokens.size(); i++)
+		{
+			if (at(i) == "{")
+				depth++;
+			else if (at(i) == "}" && --depth <= 0 && at(i + 1) != ";")
+			{
+				i++;
+				return;
+			}
+			else if (at(i) == ";" && depth == 0)
+			{
+				i++;
+				return;
+			}
+		}
+	};
+
+	while (i < tokens.size())
+	{
+		size_t start = i;
+
+		// The declarator: everything up to '=' in a statement
+		size_t equals = i;
+
+		while (equals < tokens.size() && at(equals) != "=" && at(equals) != ";" && at(equals) != "{")
+			equals++;
+
+		size_t bracket = start;
+
+		while (bracket < equals && at(bracket) != "[")
+			bracket++;
+
+		if (at(equals) != "=" || bracket == equals || bracket == start || at(equals + 1) != "{")
+		{
+			skipStatement();
+			continue;
+		}
+
+		std::string name = at(bracket - 1);
+		std::vector<std::string> type;
+
+		for (size_t j = start; j + 1 < bracket; j++)
+		{
+			if (at(j) != "static" && at(j) != "const" && at(j) != "extern")
+				type.push_back(at(j));
+		}
+
+		// Dimensions: products of numbers, or empty to take the number of values
+		uint64_t dimension = 1;
+		bool sized = false;
+
+		for (size_t j = bracket; j < equals; j++)
+		{
+			uint64_t number;
+
+			if (at(j) == "[" || at(j) == "]" || at(j) == "*")
+				continue;
+
+			if (!FindcryptParseNumber(at(j), number))
+			{
+				Error = FindcryptLineError(lineAt(j), "unsupported array size in " + name);
+				return false;
+			}
+
+			dimension *= number;
+			sized = true;
+		}
+
+		i = equals + 1;
+
+		if (type.size() == 1 && type[0] == "array_info_t")
+		{
+			// { { ARR(name), "Algorithm" }, ..., { nullptr, 0, 0, nullptr } };
+			bool sparse = name.compare(0, 6, "sparse") == 0;
+			int depth = 0;
+
+			for (; i < tokens.size(); i++)
+			{
+				if (at(i) == "{")
+					depth++;
+				else if (at(i) == "}" && --depth == 0)
+					break;
+				else if (at(i) == "ARR" && depth == 2)
+				{
+					if (at(i + 1) != "(" || at(i + 3) != ")" || at(i + 4) != "," || at(i + 5).size() < 2 || at(i + 5)[0] != '"')
+					{
+						Error = FindcryptLineError(lineAt(i), "expected ARR(name), \"algorithm\"");
+						return false;
+					}
+
+					auto array = arrays.find(at(i + 2));
+
+					if (array == arrays.end())
+					{
+						Error = FindcryptLineError(lineAt(i), at(i + 2) + " isn't defined before its table");
+						return false;
+					}
+
+					FINDCRYPT_CONSTANT constant = array->second;
+					constant.Algorithm	= at(i + 5).substr(1, at(i + 5).size() - 2);
+					constant.Type		= sparse ? FINDCRYPT_DB_SPARSE : FINDCRYPT_DB_ARRAY;
+
+					listed.push_back(constant);
+					i += 5;
+				}
+			}
+
+			if (at(i) != "}" || at(i + 1) != ";")
+			{
+				Error = FindcryptLineError(lineAt(i), "unterminated table " + name);
+				return false;
+			}
+
+			i += 2;
+			continue;
+		}
+
+		FINDCRYPT_CONSTANT constant;
+		constant.Name			= name;
+		constant.Type			= FINDCRYPT_DB_ARRAY;
+		constant.ElementSize	= FindcryptTypeSize(type);
+		constant.Endian			= FINDCRYPT_DB_LITTLE_ENDIAN;
+		constant.Window			= 0;
+
+		if (constant.ElementSize == 0)
+		{
+			Error = FindcryptLineError(lineAt(start), "unknown element type of " + name);
+			return false;
+		}
+
+		// Values; nested braces (multidimensional arrays) are flattened
+		int depth = 0;
+
+		for (; i < tokens.size(); i++)
+		{
+			const std::string& token = at(i);
+			uint64_t value;
+
+			if (token == "{")
+				depth++;
+			else if (token == "}")
+			{
+				if (--depth == 0)
+					break;
+			}
+			else if (token == ",")
+				continue;
+			else if (token == "W64LIT" && at(i + 1) == "(" && at(i + 3) == ")" && FindcryptParseNumber(at(i + 2), value))
+			{
+				constant.Values.push_back(value);
+				i += 3;
+			}
+			else if (token == "-" && FindcryptParseNumber(at(i + 1), value))
+			{
+				constant.Values.push_back(FindcryptTruncate(-(int64_t)value, constant.ElementSize));
+				i++;
+			}
+			else if (FindcryptParseNumber(token, value))
+			{
+				constant.Values.push_back(value);
+			}
+			else if (token.size() == 3 && token[0] == '\'')
+			{
+				constant.Values.push_back((uint8_t)token[1]);
+			}
+			else
+			{
+				Error = FindcryptLineError(lineAt(i), "unsupported value '" + token + "' in " + name);
+				return false;
+			}
+
+			if (!constant.Values.empty() && !FindcryptFits(constant.Values.back(), constant.ElementSize))
+			{
+				Error = FindcryptLineError(lineAt(i), "value '" + token + "' doesn't fit in " + name);
+				return false;
+			}
+		}
+
+		if (at(i) != "}" || at(i + 1) != ";")
+		{
+			Error = FindcryptLineError(lineAt(i), "unterminated array " + name);
+			return false;
+		}
+
+		i += 2;
+
+		// Missing elements are zero, as in C
+		if (sized)
+		{
+			if (constant.Values.size() > dimension)
+			{
+				Error = FindcryptLineError(lineAt(start), "too many values in " + name);
+				return false;
+			}
+
+			constant.Values.resize((size_t)dimension, 0);
+		}
+
+		arrays[name] = constant;
+	}
+
+	Constants.insert(Constants.end(), listed.begin(), listed.end());
+	return true;
+}
+
+static std::string FindcryptTrim(const std::string& Text)
+{
+	size_t start = Text.find_first_not_of(" \t\r");
+	size_t end = Text.find_last_not_of(" \t\r");
+
+	if (start == std::string::npos)
+		return std::string();
+
+	std::string result = Text.substr(start, end - start + 1);
+
+	// Quoted scalars
+	if (result.size() >= 2 && (result[0] == '"' || result[0] == '\'') && result.back() == result[0])
+		result = result.substr(1, result.size() - 2);
+
+	return result;
+}
+
+bool FindcryptParseYaml(const char *Text, size_t Size, std::vector<FINDCRYPT_CONSTANT>& Constants, std::string& Error)
+{
+	std::vector<FINDCRYPT_CONSTANT> parsed;
+
+	// Set while the values of the current entry are still being read
+	bool blockValues = false;
+	bool flowValues = false;
+	std::string flow;
+	int entryLine = 0;
+
+	auto addValues = [&](const std::string& List, int Line)
+	{
+		size_t start = 0;
+
+		while (start <= List.size())
+		{
+			size_t comma = List.find(',', start);
+			std::string item = FindcryptTrim(List.substr(start, (comma == std::string::npos) ? std::string::npos : comma - start));
+			uint64_t value;
+
+			start = (comma == std::string::npos) ? List.size() + 1 : comma + 1;
+
+			// Trailing commas, and the ones added between lines
+			if (item.empty())
+				continue;
+
+			bool negative = !item.empty() && item[0] == '-';
+
+			if (!FindcryptParseNumber(negative ? item.substr(1) : item, value))
+			{
+				Error = FindcryptLineError(Line, "invalid value '" + item + "'");
+				return false;
+			}
+
+			parsed.back().Values.push_back(negative ? (uint64_t)-(int64_t)value : value);
+		}
+
+		return true;
+	};
+
+	// Element sizes can come after the values, so they are checked at the end
+	auto finish = [&]()
+	{
+		if (parsed.empty())
+			return true;
+
+		FINDCRYPT_CONSTANT& constant = parsed.back();
+
+		if (flowValues)
+		{
+			Error = FindcryptLineError(entryLine, "unterminated value list");
+			return false;
+		}
+
+		if (constant.Name.empty() || constant.Algorithm.empty() || constant.Values.empty())
+		{
+			Error = FindcryptLineError(entryLine, "entries need a name, an algorithm and values");
+			return false;
+		}
+
+		for (uint64_t& value : constant.Values)
+		{
+			// Negative values were kept in 64-bit two's complement
+			int64_t signedValue = (int64_t)value;
+
+			if (signedValue < 0 && constant.ElementSize < sizeof(uint64_t) && signedValue >= -(int64_t)(1ull << (constant.ElementSize * 8 - 1)))
+				value = FindcryptTruncate(signedValue, constant.ElementSize);
+
+			if (!FindcryptFits(value, constant.ElementSize))
+			{
+				Error = FindcryptLineError(entryLine, "a value doesn't fit in " + constant.Name);
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	int line = 0;
+
+	for (size_t i = 0; i < Size;)
+	{
+		size_t end = i;
+
+		while (end < Size && Text[end] != '\n')
+			end++;
+
+		std::string text(Text + i, end - i);
+		i = end + 1;
+		line++;
+
+		// Comments (outside quotes)
+		char quote = 0;
+
+		for (size_t j = 0; j < text.size(); j++)
+		{
+			if (quote)
+				quote = (text[j] == quote) ? 0 : quote;
+			else if (text[j] == '"' || text[j] == '\'')
+				quote = text[j];
+			else if (text[j] == '#')
+			{
+				text.resize(j);
+				break;
+			}
+		}
+
+		if (FindcryptTrim(text).empty())
+			continue;
+
+		if (flowValues)
+		{
+			size_t close = text.find(']');
+			flow += "," + text.substr(0, close);
+
+			if (close != std::string::npos)
+			{
+				flowValues = false;
+
+				if (!addValues(flow, line))
+					return false;
+			}
+
+			continue;
+		}
+
+		size_t indent = text.find_first_not_of(' ');
+		std::string content = text.substr(indent);
+
+		if (content[0] == '-' && (content.size() == 1 || content[1] == ' '))
+		{
+			std::string item = FindcryptTrim(content.substr(1));
+
+			// "- value" inside a values block
+			if (blockValues && indent > 0 && item.find(':') == std::string::npos)
+			{
+				if (!addValues(item, line))
+					return false;
+
+				continue;
+			}
+
+			if (!finish())
+				return false;
+
+			// "- key: value" starts the next entry
+			FINDCRYPT_CONSTANT constant;
+			constant.Type			= FINDCRYPT_DB_ARRAY;
+			constant.ElementSize	= 4;
+			constant.Endian			= FINDCRYPT_DB_LITTLE_ENDIAN;
+			constant.Window			= 0;
+
+			parsed.push_back(constant);
+			blockValues = false;
+			entryLine = line;
+
+			content = content.substr(1);
+		}
+		else if (parsed.empty())
+		{
+			Error = FindcryptLineError(line, "expected '- ' to start an entry");
+			return false;
+		}
+
+		size_t colon = content.find(':');
+
+		if (colon == std::string::npos)
+		{
+			Error = FindcryptLineError(line, "expected 'key: value'");
+			return false;
+		}
+
+		std::string key = FindcryptTrim(content.substr(0, colon));
+		std::string value = FindcryptTrim(content.substr(colon + 1));
+		FINDCRYPT_CONSTANT& constant = parsed.back();
+		uint64_t number = 0;
+
+		blockValues = false;
+
+		if (key == "name")
+			constant.Name = value;
+		else if (key == "algorithm")
+			constant.Algorithm = value;
+		else if (key == "type" && (value == "array" || value == "sparse"))
+			constant.Type = (value == "sparse") ? FINDCRYPT_DB_SPARSE : FINDCRYPT_DB_ARRAY;
+		else if (key == "element" && FindcryptParseNumber(value, number))
+			constant.ElementSize = (uint32_t)number;
+		else if (key == "endian" && (value == "little" || value == "big" || value == "both"))
+		{
+			constant.Endian = (value == "little") ? FINDCRYPT_DB_LITTLE_ENDIAN :
+				(value == "big") ? FINDCRYPT_DB_BIG_ENDIAN : (FINDCRYPT_DB_LITTLE_ENDIAN | FINDCRYPT_DB_BIG_ENDIAN);
+		}
+		else if (key == "window" && FindcryptParseNumber(value, number) && number <= FindcryptDatabaseMaxWindow)
+			constant.Window = (uint32_t)number;
+		else if (key == "values" && value.empty())
+			blockValues = true;
+		else if (key == "values" && value[0] == '[')
+		{
+			size_t close = value.find(']');
+			flow = value.substr(1, (close == std::string::npos) ? std::string::npos : close - 1);
+
+			if (close == std::string::npos)
+				flowValues = true;
+			else if (!addValues(flow, line))
+				return false;
+		}
+		else
+		{
+			Error = FindcryptLineError(line, "invalid " + key + " '" + value + "'");
+			return false;
+		}
+	}
+
+	if (!finish())
+		return false;
+
+	Constants.insert(Constants.end(), parsed.begin(), parsed.end());
+	return true;
+}
+
+template<typename T>
+static void FindcryptAppend(std::vector<uint8_t>& Output, const T& Value)
+{
+	Output.insert(Output.end(), (const uint8_t *)&Value, (const uint8_t *)&Value + sizeof(T));
+}
+
+bool FindcryptCompileDatabase(const std::vector<FINDCRYPT_CONSTANT>& Constants, std::vector<uint8_t>& Output, std::string& Error)
+{
+	struct COMPILED
+	{
+		const FINDCRYPT_CONSTANT *Constant;
+		uint8_t Endian;
+		std::vector<uint8_t> Bytes;
+	};
+
+	std::vector<COMPILED> compiled[2];
+	std::map<std::pair<int, std::vector<uint8_t>>, const FINDCRYPT_CONSTANT *> contents;
+
+	for (auto& constant : Constants)
+	{
+		uint32_t size = constant.ElementSize;
+
+		if (constant.Name.empty() || constant.Algorithm.empty() || constant.Values.empty())
+		{
+			Error = "entries need a name, an algorithm and values";
+			return false;
+		}
+
+		if ((size != 1 && size != 2 && size != 4 && size != 8) || (constant.Type == FINDCRYPT_DB_SPARSE && size != sizeof(word32)))
+		{
+			Error = constant.Name + ": unsupported element size " + std::to_string(size);
+			return false;
+		}
+
+		if ((constant.Endian & (FINDCRYPT_DB_LITTLE_ENDIAN | FINDCRYPT_DB_BIG_ENDIAN)) == 0 || constant.Window > FindcryptDatabaseMaxWindow ||
+			(constant.Window != 0 && constant.Window < sizeof(word32)))
+		{
+			Error = constant.Name + ": invalid byte order or window";
+			return false;
+		}
+
+		// Byte order doesn't matter for single bytes
+		for (uint8_t endian : { FINDCRYPT_DB_LITTLE_ENDIAN, FINDCRYPT_DB_BIG_ENDIAN })
+		{
+			if (!(constant.Endian & endian) || (size == 1 && endian == FINDCRYPT_DB_BIG_ENDIAN && (constant.Endian & FINDCRYPT_DB_LITTLE_ENDIAN)))
+				continue;
+
+			COMPILED entry;
+			entry.Constant	= &constant;
+			entry.Endian	= endian;
+
+			for (uint64_t value : constant.Values)
+			{
+				if (!FindcryptFits(value, size))
+				{
+					Error = constant.Name + ": a value doesn't fit in " + std::to_string(size) + " bytes";
+					return false;
+				}
+
+				for (uint32_t j = 0; j < size; j++)
+				{
+					uint32_t shift = (endian == FINDCRYPT_DB_LITTLE_ENDIAN) ? j : (size - 1 - j);
+					entry.Bytes.push_back((uint8_t)(value >> (shift * 8)));
+				}
+			}
+
+			auto inserted = contents.insert({ { constant.Type, entry.Bytes }, &constant });
+
+			if (!inserted.second)
+			{
+				Error = constant.Name + " has the same contents as " + inserted.first->second->Name;
+				return false;
+			}
+
+			compiled[constant.Type].push_back(std::move(entry));
+		}
+	}
+
+	// Strings are shared, which mostly saves on algorithm names
+	std::vector<uint8_t> strings;
+	std::map<std::string, uint32_t> stringOffsets;
+
+	auto addString = [&](const std::string& Text)
+	{
+		auto inserted = stringOffsets.insert({ Text, (uint32_t)strings.size() });
+
+		if (inserted.second)
+			strings.insert(strings.end(), Text.c_str(), Text.c_str() + Text.size() + 1);
+
+		return inserted.first->second;
+	};
+
+	std::vector<FINDCRYPT_DB_ENTRY> entries;
+	std::vector<uint8_t> data;
+
+	for (auto& table : compiled)
+	{
+		for (auto& entry : table)
+		{
+			FINDCRYPT_DB_ENTRY header;
+			memset(&header, 0, sizeof(header));
+
+			// Elements stay naturally aligned in a mapped view
+			data.resize((data.size() + 7) & ~(size_t)7, 0);
+
+			header.Name			= addString(entry.Constant->Name);
+			header.Algorithm	= addString(entry.Constant->Algorithm);
+			header.Data			= (uint32_t)data.size();
+			header.Count		= (uint32_t)entry.Constant->Values.size();
+			header.ElementSize	= (uint8_t)entry.Constant->ElementSize;
+			header.Type			= (uint8_t)entry.Constant->Type;
+			header.Endian		= entry.Endian;
+			header.Window		= entry.Constant->Window;
+
+			entries.push_back(header);
+			data.insert(data.end(), entry.Bytes.begin(), entry.Bytes.end());
+		}
+	}
+
+	FINDCRYPT_DB_HEADER header;
+	memcpy(header.Magic, FindcryptDatabaseMagic, sizeof(header.Magic));
+
+	size_t stringsOffset	= sizeof(FINDCRYPT_DB_HEADER) + (entries.size() * sizeof(FINDCRYPT_DB_ENTRY));
+	size_t dataOffset		= (stringsOffset + strings.size() + 7) & ~(size_t)7;
+
+	if ((dataOffset + data.size()) > UINT32_MAX)
+	{
+		Error = "the database is too large";
+		return false;
+	}
+
+	header.Version		= FindcryptDatabaseVersion;
+	header.EntryCount	= (uint32_t)entries.size();
+	header.StringsOffset	= (uint32_t)stringsOffset;
+	header.StringsSize	= (uint32_t)strings.size();
+	header.DataOffset	= (uint32_t)dataOffset;
+	header.DataSize		= (uint32_t)data.size();
+
+	Output.clear();
+	FindcryptAppend(Output, header);
+
+	for (auto& entry : entries)
+		FindcryptAppend(Output, entry);
+
+	Output.insert(Output.end(), strings.begin(), strings.end());
+	Output.resize(dataOffset, 0);
+	Output.insert(Output.end(), data.begin(), data.end());
+	return true;
+}
+
+struct FINDCRYPT_DB_TABLES
+{
+	std::vector<array_info_t> Arrays;
+	std::vector<array_info_t> Sparse;
+	std::shared_ptr<const void> Owner;
+};
+
+FindcryptMatcherPtr FindcryptLoadDatabase(const uint8_t *Data, size_t Size, const std::shared_ptr<const void>& Owner)
+{
+	FINDCRYPT_DB_HEADER header;
+
+	if (Size < sizeof(header))
+		return nullptr;
+
+	memcpy(&header, Data, sizeof(header));
+
+	if (memcmp(header.Magic, FindcryptDatabaseMagic, sizeof(header.Magic)) != 0 || header.Version != FindcryptDatabaseVersion)
+		return nullptr;
+
+	// Every section has to be inside the file and the string table has to end with a terminator
+	uint64_t entriesEnd = sizeof(header) + ((uint64_t)header.EntryCount * sizeof(FINDCRYPT_DB_ENTRY));
+
+	if (entriesEnd > header.StringsOffset || ((uint64_t)header.StringsOffset + header.StringsSize) > header.DataOffset ||
+		((uint64_t)header.DataOffset + header.DataSize) != Size)
+		return nullptr;
+
+	if (header.StringsSize == 0 || Data[header.StringsOffset + header.StringsSize - 1] != '\0')
+		return nullptr;
+
+	auto tables = std::make_shared<FINDCRYPT_DB_TABLES>();
+	tables->Owner = Owner;
+
+	const char *strings = (const char *)Data + header.StringsOffset;
+
+	for (uint32_t i = 0; i < header.EntryCount; i++)
+	{
+		FINDCRYPT_DB_ENTRY entry;
+		memcpy(&entry, Data + sizeof(header) + (i * sizeof(FINDCRYPT_DB_ENTRY)), sizeof(entry));
+
+		uint32_t size = entry.ElementSize;
+
+		if ((size != 1 && size != 2 && size != 4 && size != 8) || entry.Type > FINDCRYPT_DB_SPARSE || entry.Count == 0 ||
+			(entry.Type == FINDCRYPT_DB_SPARSE && size != sizeof(word32)) || entry.Window > FindcryptDatabaseMaxWindow ||
+			(entry.Window != 0 && entry.Window < sizeof(word32)))
+			return nullptr;
+
+		if (entry.Name >= header.StringsSize || entry.Algorithm >= header.StringsSize ||
+			((uint64_t)entry.Data + ((uint64_t)entry.Count * size)) > header.DataSize)
+			return nullptr;
+
+		array_info_t info;
+		info.array		= Data + header.DataOffset + entry.Data;
+		info.size		= entry.Count;
+		info.elsize		= size;
+		info.name		= strings + entry.Name;
+		info.algorithm	= strings + entry.Algorithm;
+		info.window		= entry.Window;
+
+		((entry.Type == FINDCRYPT_DB_SPARSE) ? tables->Sparse : tables->Arrays).push_back(info);
+	}
+
+	// Both tables end with an empty entry
+	array_info_t terminator;
+	memset(&terminator, 0, sizeof(terminator));
+
+	tables->Arrays.push_back(terminator);
+	tables->Sparse.push_back(terminator);
+
+	return std::make_shared<const FindcryptMatcher>(tables->Arrays.data(), tables->Sparse.data(), tables);
+}
+
+#include "findcrypt-db-test.h"
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+//
+// Findcrypt constant databases: tables compiled from C++ sources (consts.cpp style) or
+// YAML lists into one versioned file, which is used in place without copying, e.g.
+// straight from a memory mapped view.
+//
+// File layout (little endian):
+//   FINDCRYPT_DB_HEADER
+//   FINDCRYPT_DB_ENTRY[EntryCount]	in table order, arrays first
+//   String table					NUL terminated names and algorithms
+//   Data							element bytes of every entry, as found in memory
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "findcrypt-core.h"
+
+const char FindcryptDatabaseMagic[8]	= { 'S', 'A', 'K', 'F', 'C', 'D', 'B', '\0' };
+const uint32_t FindcryptDatabaseVersion	= 1;
+
+enum FINDCRYPT_DB_TYPE : uint8_t
+{
+	FINDCRYPT_DB_ARRAY,
+	FINDCRYPT_DB_SPARSE,
+};
+
+// Byte orders an entry is compiled in; each one becomes its own entry
+enum FINDCRYPT_DB_ENDIAN : uint8_t
+{
+	FINDCRYPT_DB_LITTLE_ENDIAN	= 1,
+	FINDCRYPT_DB_BIG_ENDIAN		= 2,
+};
+
+struct FINDCRYPT_DB_HEADER
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t StringsOffset;
+	uint32_t StringsSize;
+	uint32_t DataOffset;
+	uint32_t DataSize;
+};
+
+struct FINDCRYPT_DB_ENTRY
+{
+	uint32_t Name;			// Offsets into the string table
+	uint32_t Algorithm;
+	uint32_t Data;			// Offset into the data
+	uint32_t Count;			// Elements
+	uint8_t ElementSize;
+	uint8_t Type;			// FINDCRYPT_DB_TYPE
+	uint8_t Endian;			// The FINDCRYPT_DB_ENDIAN the data is in
+	uint8_t Reserved;
+	uint32_t Window;		// Sparse sets: see array_info_t::window
+};
+
+// One table as written in a source file
+struct FINDCRYPT_CONSTANT
+{
+	std::string Name;
+	std::string Algorithm;
+	FINDCRYPT_DB_TYPE Type;
+	uint32_t ElementSize;			// 1, 2, 4 or 8 (sparse sets: 4)
+	uint32_t Endian;				// FINDCRYPT_DB_ENDIAN flags
+	uint32_t Window;
+	std::vector<uint64_t> Values;
+};
+
+//
+// Sources. C++ files define static const arrays of integers and list them in
+// array_info_t tables with ARR(); a table whose name starts with "sparse" holds sparse
+// sets. YAML files are a list of entries:
+//
+//   - name: ChaCha_sigma
+//     algorithm: ChaCha/Salsa20
+//     type: sparse             # array (default) or sparse
+//     element: 4               # bytes per value (default 4)
+//     endian: both             # little (default), big or both
+//     window: 64               # sparse sets only
+//     values: [0x61707865, 0x3320646e, 0x79622d32, 0x6b206574]
+//
+// Values can also be given as a block list ("- value" lines). Errors name the line.
+//
+bool FindcryptParseCpp(const char *Text, size_t Size, std::vector<FINDCRYPT_CONSTANT>& Constants, std::string& Error);
+bool FindcryptParseYaml(const char *Text, size_t Size, std::vector<FINDCRYPT_CONSTANT>& Constants, std::string& Error);
+
+// Fails on invalid entries and on two entries with the same type and contents
+bool FindcryptCompileDatabase(const std::vector<FINDCRYPT_CONSTANT>& Constants, std::vector<uint8_t>& Output, std::string& Error);
+
+//
+// Checks a compiled database and builds tables that point into Data, which has to stay
+// valid (and unchanged) for as long as the returned matcher is used. Owner is kept
+// alive along with it. Returns nullptr if the file is damaged or of another version.
+//
+FindcryptMatcherPtr FindcryptLoadDatabase(const uint8_t *Data, size_t Size, const std::shared_ptr<const void>& Owner);
+
+bool FindcryptDatabaseSelfTest();
\ No newline at end of file
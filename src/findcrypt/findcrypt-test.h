@@ -0,0 +1,254 @@
+#pragma once
+
+//
+// Compares FindcryptScanBuffer with a plain loop over both constant tables (one entry
+// at a time, as the scanner used to) and a separate AES-NI pass, on random data with
+// every array and sparse set planted. Includes entries that share their first bytes,
+// ones cut off by the end of the buffer and instructions straddling block boundaries.
+// The parallel scan over several ranges has to report exactly what scanning each
+// range on its own does, for any chunk size and thread count.
+//
+static void FindcryptTestReference(const uint8_t *Data, size_t Size, uint64_t Address, std::vector<FINDCRYPT_MATCH>& Matches)
+{
+	for (size_t i = 0; i < Size; i++)
+	{
+		for (const array_info_t *ptr = non_sparse_consts; ptr->size != 0; ptr++)
+		{
+			if (Data[i] == FindcryptFirstByte(ptr) && FindcryptMatchArray(Data, Size, i, ptr))
+			{
+				Matches.push_back({ Address + i, FINDCRYPT_MATCH_ARRAY, ptr->name, ptr->algorithm });
+				break;
+			}
+		}
+
+		for (const array_info_t *ptr = sparse_consts; ptr->size != 0; ptr++)
+		{
+			if (Data[i] == FindcryptFirstByte(ptr) && FindcryptMatchSparse(Data, Size, i, ptr))
+			{
+				Matches.push_back({ Address + i, FINDCRYPT_MATCH_SPARSE, ptr->name, ptr->algorithm });
+				break;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < Size; i++)
+	{
+		if (const char *instruction = FindcryptAESNI(Data, Size, i))
+			Matches.push_back({ Address + i, FINDCRYPT_MATCH_AESNI, instruction, nullptr });
+	}
+
+	// Address order; constants stay ahead of an instruction at the same address
+	std::stable_sort(Matches.begin(), Matches.end(), [](const FINDCRYPT_MATCH& A, const FINDCRYPT_MATCH& B)
+	{
+		return A.Address < B.Address;
+	});
+}
+
+bool FindcryptSelfTest()
+{
+	uint32_t state = 0x1B873593;
+
+	auto random = [&state]()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	std::vector<uint8_t> data;
+
+	auto fill = [&](size_t Count)
+	{
+		for (size_t i = 0; i < Count; i++)
+			data.push_back((uint8_t)random());
+	};
+
+	for (const array_info_t *ptr = non_sparse_consts; ptr->size != 0; ptr++)
+	{
+		fill(random() % 64);
+		data.insert(data.end(), (const uint8_t *)ptr->array, (const uint8_t *)ptr->array + (ptr->size * ptr->elsize));
+	}
+
+	// Sparse sets with their words spread out, some too far apart to match
+	for (const array_info_t *ptr = sparse_consts; ptr->size != 0; ptr++)
+	{
+		for (int copy = 0; copy < 2; copy++)
+		{
+			const word32 *words = (const word32 *)ptr->array;
+			fill(random() % 64);
+
+			for (size_t i = 0; i < ptr->size; i++)
+			{
+				if (i > 0)
+					fill((copy == 0) ? (random() % 16) : 70);
+
+				data.insert(data.end(), (const uint8_t *)&words[i], (const uint8_t *)&words[i] + sizeof(word32));
+			}
+		}
+	}
+
+	// A few AES-NI instructions and prefixes that only look like them
+	const uint8_t instructions[] = { 0x66, 0x0F, 0x38, 0xDC, 0x66, 0x0F, 0x3A, 0xDF, 0x66, 0x0F, 0x38, 0xDA, 0x66, 0x0F, 0x3A, 0xDE };
+	data.insert(data.end(), instructions, instructions + sizeof(instructions));
+
+	fill(4096);
+
+	// Instructions on both sides of and across the first few block boundaries
+	data.resize(std::max(data.size(), (FindcryptBlockSize * 4) + 64));
+
+	for (size_t block = 1; block < 4; block++)
+	{
+		for (size_t offset : { FindcryptBlockSize * block - block, FindcryptBlockSize * block + 8 * block })
+		{
+			// AESENC, AESENCLAST, AESKEYGENASSIST
+			memcpy(&data[offset], instructions + ((block == 3) ? 4 : 0), 4);
+			data[offset + 3] += (block == 2) ? 1 : 0;
+		}
+	}
+
+	// Zeros match the start of some arrays, and the last one is cut off
+	data.insert(data.end(), 256, 0);
+	data.insert(data.end(), (const uint8_t *)non_sparse_consts[0].array, (const uint8_t *)non_sparse_consts[0].array + 7);
+
+	const uint64_t address = 0x7FF600000000ull;
+
+	std::vector<FINDCRYPT_MATCH> expected;
+	FindcryptTestReference(data.data(), data.size(), address, expected);
+
+	std::vector<FINDCRYPT_MATCH> matches;
+	FindcryptScanBuffer(data.data(), data.size(), address, [&](const FINDCRYPT_MATCH& Match)
+	{
+		matches.push_back(Match);
+	}, nullptr);
+
+	if (matches.size() != expected.size())
+		return false;
+
+	for (size_t i = 0; i < matches.size(); i++)
+	{
+		if (matches[i].Address != expected[i].Address || matches[i].Type != expected[i].Type || strcmp(matches[i].Name, expected[i].Name) != 0)
+			return false;
+	}
+
+	// Every array has to be found, and both copies of every sparse set only once
+	size_t arrays = 0;
+	size_t sparse = 0;
+
+	for (auto& match : matches)
+	{
+		arrays += (match.Type == FINDCRYPT_MATCH_ARRAY) ? 1 : 0;
+		sparse += (match.Type == FINDCRYPT_MATCH_SPARSE) ? 1 : 0;
+	}
+
+	size_t arrayCount = 0;
+	size_t sparseCount = 0;
+
+	for (const array_info_t *ptr = non_sparse_consts; ptr->size != 0; ptr++)
+		arrayCount++;
+
+	for (const array_info_t *ptr = sparse_consts; ptr->size != 0; ptr++)
+		sparseCount++;
+
+	size_t aesni = matches.size() - arrays - sparse;
+
+	if (aesni < 8 || arrays < arrayCount || sparse < sparseCount || sparse >= (sparseCount * 2))
+		return false;
+
+	// Adjacent ranges, a gap and one running to the end
+	std::vector<FINDCRYPT_RANGE> ranges =
+	{
+		{ address, address + 5000 },
+		{ address + 5000, address + 70001 },
+		{ address + 80000, address + data.size() },
+	};
+
+	expected.clear();
+
+	for (auto& range : ranges)
+	{
+		FindcryptScanBuffer(&data[range.Start - address], (size_t)(range.End - range.Start), range.Start, [&](const FINDCRYPT_MATCH& Match)
+		{
+			expected.push_back(Match);
+		}, nullptr);
+	}
+
+	std::set<uint64_t> unreadable;
+
+	auto read = [&](uint64_t Address, uint8_t *Buffer, size_t Size)
+	{
+		memcpy(Buffer, &data[Address - address], Size);
+
+		for (uint64_t page = Address / FindcryptPageSize; page <= (Address + Size - 1) / FindcryptPageSize; page++)
+		{
+			if (unreadable.count(page))
+				return false;
+		}
+
+		return true;
+	};
+
+	auto compare = [&]()
+	{
+		for (size_t chunkSize : { 1000, 4096, 65543, 1024 * 1024 })
+		{
+			for (size_t threadCount : { 1, 3, 8 })
+			{
+				matches.clear();
+
+				FindcryptScanRanges(ranges, read, [&](const FINDCRYPT_MATCH& Match)
+				{
+					matches.push_back(Match);
+				}, nullptr, chunkSize, threadCount);
+
+				if (matches.size() != expected.size())
+					return false;
+
+				for (size_t i = 0; i < matches.size(); i++)
+				{
+					if (matches[i].Address != expected[i].Address || matches[i].Type != expected[i].Type || strcmp(matches[i].Name, expected[i].Name) != 0)
+						return false;
+				}
+			}
+		}
+
+		return true;
+	};
+
+	if (!compare())
+		return false;
+
+	//
+	// Pages holding every third match become unreadable. Their bytes are still copied, so
+	// anything found there (or across them) means a failed read was scanned anyway. Only
+	// the runs of readable pages in each range can have matches.
+	//
+	for (size_t i = 0; i < expected.size(); i += 3)
+		unreadable.insert(expected[i].Address / FindcryptPageSize);
+
+	expected.clear();
+
+	for (auto& range : ranges)
+	{
+		for (uint64_t start = range.Start; start < range.End;)
+		{
+			uint64_t end = start;
+
+			while (end < range.End && !unreadable.count(end / FindcryptPageSize))
+				end = std::min((end / FindcryptPageSize + 1) * FindcryptPageSize, range.End);
+
+			if (end > start)
+			{
+				FindcryptScanBuffer(&data[start - address], (size_t)(end - start), start, [&](const FINDCRYPT_MATCH& Match)
+				{
+					expected.push_back(Match);
+				}, nullptr);
+			}
+
+			start = std::min((end / FindcryptPageSize + 1) * FindcryptPageSize, range.End);
+		}
+	}
+
+	return !unreadable.empty() && compare();
+}
\ No newline at end of file
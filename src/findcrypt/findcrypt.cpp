@@ -10,233 +10,103 @@
 
 // Version 2-with-mmx
 // Adapted to x64dbg
-#include <set>
-#include <thread>
+#include <time.h>
+#include <chrono>
 #include "findcrypt.h"
 
 Findcrypt::Findcrypt(duint VirtualStart, duint VirtualEnd)
 {
-	// Sanity check: make sure there are no duplicate entries anywhere
-	static bool initOnce = false;
-
-	if (!initOnce)
-	{
-		initOnce = true;
-		VerifyConstants(non_sparse_consts);
-		VerifyConstants(sparse_consts);
-	}
-
-	// Real class constructor code
 	m_StartAddress	= VirtualStart;
 	m_EndAddress	= VirtualEnd;
-	m_DataSize		= VirtualEnd - VirtualStart;
-	m_Data			= (PBYTE)malloc(m_DataSize);
 
 	m_AESNICount	= 0;
 	m_CryptoCount	= 0;
-
-	// Read the remote memory into the local buffer
-	if (!DbgMemRead(VirtualStart, m_Data, m_DataSize))
-		memset(m_Data, 0, m_DataSize);
-}
-
-Findcrypt::~Findcrypt()
-{
-	if (m_Data)
-		free(m_Data);
 }
 
-void Findcrypt::VerifyConstants(const array_info_t *consts)
+void Findcrypt::ApplyMatch(const FINDCRYPT_MATCH& Match, int& AESNICount, int& CryptoCount)
 {
-	std::set<std::string> myset;
+	duint ea = (duint)Match.Address;
 
-	// Verifies that all algorithm entries are different
-	for (const array_info_t *ptr = consts; ptr->size != 0; ptr++)
+	switch (Match.Type)
 	{
-		std::string s((const char*)ptr->array, ptr->size);
-
-		if (!myset.insert(s).second)
-		{
-			dprintf("duplicate array %s!", ptr->name);
-			__debugbreak();
-		}
+	case FINDCRYPT_MATCH_ARRAY:
+		dprintf("%p: Found const array %s (used in %s)\n", ea, Match.Name, Match.Algorithm);
+		DbgSetAutoCommentAt(ea, Match.Algorithm);
+		DbgSetAutoLabelAt(ea, Match.Name);
+		CryptoCount++;
+		break;
+
+	case FINDCRYPT_MATCH_SPARSE:
+		dprintf("%p: Found sparse constants for %s\n", ea, Match.Algorithm);
+		DbgSetAutoCommentAt(ea, Match.Algorithm);
+		CryptoCount++;
+		break;
+
+	case FINDCRYPT_MATCH_AESNI:
+		dprintf("%p: May be %s\n", ea, Match.Name);
+		AESNICount++;
+		break;
 	}
 }
 
 void Findcrypt::ScanConstants()
 {
-	for (duint ea = m_StartAddress; ea < m_EndAddress; ea = ea + 1)
-	{
-		// Update the status bar every 65k bytes
-		if ((ea % 0x10000) == 0)
-			ShowAddress(ea);
+	auto lastProgress = std::chrono::steady_clock::now();
 
-		// Check against normal constants
-		BYTE b = GetByte(ea);
+	// The same tables for the whole range, even if a database is loaded meanwhile
+	FindcryptMatcherPtr matcher = FindcryptGetMatcher();
 
-		for (const array_info_t *ptr = non_sparse_consts; ptr->size != 0; ptr++)
+	//
+	// The range is streamed through a fixed window, overlapping by the longest constant
+	// so nothing is missed at the seams. Matches in the overlap belong to the next run.
+	//
+	DbgStreamMemory(m_StartAddress, m_EndAddress, matcher->Overlap(), [&](uint64_t Address, const uint8_t *Data, size_t Size, size_t Count)
+	{
+		FindcryptScanBuffer(*matcher, Data, Size, Address, [&](const FINDCRYPT_MATCH& Match)
 		{
-			if (b != GetFirstByte(ptr))
-				continue;
+			if (Match.Address < Address + Count)
+				ApplyMatch(Match, m_AESNICount, m_CryptoCount);
+		}, nullptr);
 
-			if (MatchArrayPattern(ea, ptr))
-			{
-				dprintf("%p: Found const array %s (used in %s)\n", ea, ptr->name, ptr->algorithm);
-				DbgSetAutoCommentAt(ea, ptr->algorithm);
-				DbgSetAutoLabelAt(ea, ptr->name);
-				m_CryptoCount++;
-				break;
-			}
-		}
+		auto now = std::chrono::steady_clock::now();
 
-		// Check against sparse constants
-		for (const array_info_t *ptr = sparse_consts; ptr->size != 0; ptr++)
+		if (now - lastProgress >= std::chrono::milliseconds(FindcryptProgressInterval))
 		{
-			if (b != GetFirstByte(ptr))
-				continue;
-
-			if (MatchSparsePattern(ea, ptr))
-			{
-				dprintf("%p: Found sparse constants for %s\n", ea, ptr->algorithm);
-				DbgSetAutoCommentAt(ea, ptr->algorithm);
-				m_CryptoCount++;
-				break;
-			}
+			lastProgress = now;
+			ShowAddress((duint)(Address + Count));
 		}
-	}
-
-	for (duint ea = m_StartAddress; ea < m_EndAddress; ea = ea + 1)
-	{
-		// Update the status bar every 65k bytes
-		if ((ea % 0x10000) == 0)
-			ShowAddress(ea);
-
-		if (GetByte(ea) == 0x66 && GetByte(ea + 1) == 0x0f)
-		{
-			char *instruction = nullptr;
-
-			if (GetByte(ea + 2) == 0x38)
-			{
-				switch (GetByte(ea + 3))
-				{
-				case 0xdb: instruction = "AESIMC";		break;
-				case 0xdc: instruction = "AESENC";		break;
-				case 0xdd: instruction = "AESENCLAST";	break;
-				case 0xde: instruction = "AESDEC";		break;
-				case 0xdf: instruction = "AESDECLAST";	break;
-				}
-			}
-			else if (GetByte(ea + 2) == 0x3a && GetByte(ea + 3) == 0xdf)
-				instruction = "AESKEYGENASSIST";
 
-			if (instruction)
-			{
-				dprintf("%p: May be %s\n", ea, instruction);
-				m_AESNICount++;
-			}
-		}
-	}
+		return true;
+	});
 }
 
-BYTE Findcrypt::GetFirstByte(const array_info_t *ai)
+void Findcrypt::ShowAddress(duint Address)
 {
-	const BYTE *ptr = (const BYTE *)ai->array;
-
-#ifndef IS_LITTLE_ENDIAN
-	if (!inf.mf)
-		return ptr[0];
-#endif // IS_LITTLE_ENDIAN
+	char buf[64];
 
-	return ptr[ai->elsize - 1];
+	sprintf_s(buf, "\nAddress: %p\n", Address);
+	GuiAddStatusBarMessage(buf);
 }
 
-bool Findcrypt::MatchArrayPattern(duint Address, const array_info_t *ai)
+static bool FindcryptReadMemory(uint64_t Address, uint8_t *Buffer, size_t Size)
 {
-	BYTE *ptr = (BYTE *)ai->array;
-
-	for (size_t i = 0; i < ai->size; i++)
-	{
-		switch (ai->elsize)
-		{
-		case 1:
-			if (GetByte(Address) != *(BYTE *)ptr)
-				return false;
-			break;
-		case 2:
-			if (GetWord(Address) != *(WORD *)ptr)
-				return false;
-			break;
-		case 4:
-			if (GetLong(Address) != *(ULONG *)ptr)
-				return false;
-			break;
-		case 8:
-			if (GetQword(Address) != *(UINT64 *)ptr)
-				return false;
-			break;
-		default:
-			dprintf("interr: unexpected array '%s' element size %d\n",
-				ai->name, ai->elsize);
-			__debugbreak();
-		}
-
-		ptr		+= ai->elsize;
-		Address += ai->elsize;
-	}
-
-	return true;
+	// FindcryptScanRanges retries failed chunks page by page and skips unreadable pages
+	return DbgMemRead((duint)Address, Buffer, (duint)Size);
 }
 
-bool Findcrypt::MatchSparsePattern(duint Address, const array_info_t *ai)
+static void FindcryptShowSpeed(clock_t StartTime, duint TotalSize)
 {
-	const unsigned int *ptr = (const unsigned int *)ai->array;
-
-	// Match first 4 bytes
-	if (GetLong(Address) != *ptr++)
-		return false;
+	// Tell the user how long it took
+	double time = double(clock() - StartTime) / CLOCKS_PER_SEC;
+	const double MB = 1024.0 * 1024.0;
 
-	Address += 4;
-
-	// Continue with looping the remaining pattern
-	for (size_t i = 1; i < ai->size; i++)
-	{
-		unsigned int c = *ptr++;
-
-#ifndef IS_LITTLE_ENDIAN
-		if (inf.mf)
-			c = swap32(c);
-#endif // IS_LITTLE_ENDIAN
-
-		// Look for the constant in the next N bytes
-		const size_t N = 64;
-		BYTE mem[N + 4];
-		GetManyBytes(Address, mem, sizeof(mem));
-		int j;
-		for (j = 0; j < N; j++)
-		{
-			if (*(ULONG*)(mem + j) == c)
-				break;
-		}
-
-		if (j == N)
-			return false;
-
-		Address += j + 4;
-	}
-
-	return true;
-}
-
-void Findcrypt::ShowAddress(duint Address)
-{
-	char buf[64];
-
-	sprintf_s(buf, "\nAddress: %p\n", Address);
-	GuiAddStatusBarMessage(buf);
+	dprintf("Processed %.2f MB, speed = %.2f MB/s.\n", TotalSize / MB, (time > 0) ? (TotalSize / MB / time) : 0.0);
 }
 
 void FindcryptScanRange(duint Start, duint End)
 {
+	clock_t startTime = clock();
+
 	dprintf("Starting a crypto scan of range %p to %p...\n", Start, End);
 
 	// Run on this thread (which should be a command thread)
@@ -244,6 +114,7 @@ void FindcryptScanRange(duint Start, duint End)
 	scanner.ScanConstants();
 
 	dprintf("Found %d possible AES-NI instructions and %d constant arrays.\n", scanner.AESNICount(), scanner.CryptoCount());
+	FindcryptShowSpeed(startTime, End - Start);
 }
 
 void FindcryptScanModule()
@@ -256,34 +127,122 @@ void FindcryptScanModule()
 
 void FindcryptScanAll()
 {
-	int totalAES	= 0;
-	int totalCrypto	= 0;
+	// Performance counting
+	clock_t startTime	= clock();
+	duint totalSize		= 0;
+	int totalAES		= 0;
+	int totalCrypto		= 0;
 
 	dprintf("Starting a crypto scan for all memory ranges...\n");
 
+	std::vector<FINDCRYPT_RANGE> ranges;
+
 	DbgEnumMemoryRanges([&](duint Start, duint End)
 	{
-		Findcrypt scanner(Start, End);
-		scanner.ScanConstants();
-
-		// Increment counters
-		totalAES	+= scanner.AESNICount();
-		totalCrypto += scanner.CryptoCount();
-
+		ranges.push_back({ Start, End });
+		totalSize += (End - Start);
 		return true;
 	});
 
+	//
+	// Chunks of every range are read and scanned on all cores while this (command)
+	// thread labels the results in address order as soon as they are ready
+	//
+	FindcryptScanRanges(ranges, FindcryptReadMemory, [&](const FINDCRYPT_MATCH& Match)
+	{
+		Findcrypt::ApplyMatch(Match, totalAES, totalCrypto);
+	}, [](uint64_t Address)
+	{
+		Findcrypt::ShowAddress((duint)Address);
+	});
+
 	dprintf("Found %d possible AES-NI instructions and %d constant arrays.\n", totalAES, totalCrypto);
+	FindcryptShowSpeed(startTime, totalSize);
+}
+
+bool FindcryptLoadDatabaseFile(const char *Path)
+{
+	HANDLE file = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.QuadPart <= MAXDWORD)
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	CloseHandle(file);
+
+	if (!mapping)
+		return false;
+
+	// The view stays mapped for as long as any scan uses the tables pointing into it
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+
+	if (!view)
+		return false;
+
+	std::shared_ptr<const void> owner(view, [](const void *View)
+	{
+		UnmapViewOfFile(View);
+	});
+
+	FindcryptMatcherPtr matcher = FindcryptLoadDatabase((const uint8_t *)view, (size_t)size.QuadPart, owner);
+
+	if (!matcher)
+		return false;
+
+	FindcryptSetMatcher(matcher);
+	return true;
+}
+
+static void FindcryptLoadDefaultDatabase()
+{
+	//
+	// findcrypt.fcdb next to the plugin, if there is one. The CMake build generates it
+	// (sak-cli fcdb) and the plugin's post-build step copies it here; see README.
+	//
+	char path[MAX_PATH];
+	DWORD length = GetModuleFileNameA(g_LocalDllHandle, path, ARRAYSIZE(path));
+
+	if (length == 0 || length >= ARRAYSIZE(path))
+		return;
+
+	char *fileName = strrchr(path, '\\');
+
+	if (!fileName || (size_t)(fileName + 1 - path) + strlen(FindcryptDatabaseFileName) >= ARRAYSIZE(path))
+		return;
+
+	strcpy_s(fileName + 1, ARRAYSIZE(path) - (fileName + 1 - path), FindcryptDatabaseFileName);
+
+	if (GetFileAttributesA(path) == INVALID_FILE_ATTRIBUTES)
+		return;
+
+	if (FindcryptLoadDatabaseFile(path))
+		dprintf("Loaded constants from %s\n", path);
+	else
+		dprintf("Unable to load %s, using the built-in constants\n", path);
 }
 
 void Plugin_FindcryptLogo()
 {
 	dprintf("---- Findcrypt v2 with AES-NI extensions ----\n");
+
+	// Run by "sak-cli selftest" in release builds (see pluginit)
+#ifdef _DEBUG
 	dprintf("Executing self test...\n");
 
-	Findcrypt test(0, 1);
-	test.VerifyConstants(non_sparse_consts);
-	test.VerifyConstants(sparse_consts);
+	if (!FindcryptSelfTest())
+		dprintf("Findcrypt self test failed!\n");
+
+	if (!FindcryptDatabaseSelfTest())
+		dprintf("Findcrypt database self test failed!\n");
+#endif // _DEBUG
+
+	FindcryptLoadDefaultDatabase();
 
 	//
 	// Displays the startup information for this build of findcrypt
@@ -306,8 +265,10 @@ void Plugin_FindcryptLogo()
 		}
 	};
 
+	FindcryptMatcherPtr matcher = FindcryptGetMatcher();
+
 	dprintf("Available constant checking:\n\t");
-	DisplayArray(non_sparse_consts);
-	DisplayArray(sparse_consts);
+	DisplayArray(matcher->Arrays());
+	DisplayArray(matcher->Sparse());
 	dprintf("\n");
 }
\ No newline at end of file
@@ -1,4 +1,4 @@
-#include "findcrypt.h"
+#include "findcrypt-core.h"
 
 // Various constants used in crypto algorithms
 // They were copied from public domain codes
@@ -117,5 +117,5 @@ const array_info_t sparse_consts[] =
   { ARR(MD5),        "MD5"       },
   { ARR(MD4),        "MD4"       },
   { ARR(HAVAL),      "HAVAL"     },
-  { NULL, 0, NULL, NULL }
+  { nullptr, 0, 0, nullptr }
 };
\ No newline at end of file
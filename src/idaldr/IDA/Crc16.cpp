@@ -1,4 +1,4 @@
-#include "../stdafx.h"
+#include "Crc16.h"
 
 #define POLY 0x8408
 
@@ -11,7 +11,7 @@
 // represent the 17 bit value.
 */
 
-unsigned short crc16(unsigned char *data_p, size_t length)
+unsigned short crc16(const unsigned char *data_p, size_t length)
 {
 	if (length <= 0)
 		return 0;
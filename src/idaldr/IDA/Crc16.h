@@ -1,3 +1,5 @@
 #pragma once
 
-unsigned short crc16(unsigned char *data_p, size_t length);
\ No newline at end of file
+#include <stddef.h>
+
+unsigned short crc16(const unsigned char *data_p, size_t length);
\ No newline at end of file
@@ -1,54 +1,69 @@
-#include "../stdafx.h"
+#include "Sig.h"
+#include "Crc16.h"
+#include "../../sigmake/PackedDescriptor.h"
+#include <stdio.h>
+#include <algorithm>
 #include "../../zlib/zlib.h"
 
 IDASig::IDASig()
 {
 	memset(&Header, 0, sizeof(IDASigHeader));
+	memset(SignatureName, 0, sizeof(SignatureName));
 
-	m_LegacyIDB		= false;
-	m_FileHandle	= INVALID_HANDLE_VALUE;
-	m_FileData		= nullptr;
+	SignatureVersion	= 0;
+	m_LegacyIDB			= false;
+	m_FileData			= nullptr;
+	m_FileEnd			= nullptr;
 }
 
 IDASig::~IDASig()
 {
-	if (m_FileHandle != INVALID_HANDLE_VALUE)
-		CloseHandle(m_FileHandle);
-
-	if (m_FileData)
-		VirtualFree(m_FileData, 0, MEM_RELEASE);
 }
 
 bool IDASig::Load(const char *Path)
 {
-	m_FileHandle = CreateFileA(Path, GENERIC_READ, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	FILE *file = nullptr;
+
+#ifdef _MSC_VER
+	fopen_s(&file, Path, "rb");
+#else
+	file = fopen(Path, "rb");
+#endif // _MSC_VER
 
-	if (m_FileHandle == INVALID_HANDLE_VALUE)
+	if (!file)
 	{
-		_plugin_logprintf("Unable to open file\n");
+		SetError("Unable to open file");
 		return false;
 	}
 
-	m_FileSize = GetFileSize(m_FileHandle, nullptr);
+	// Read the file
+	char buf[4096];
 
-	if (m_FileSize <= 0)
-	{
-		_plugin_logprintf("No data in file\n");
-		return false;
-	}
+	for (size_t count; (count = fread(buf, 1, sizeof(buf), file)) > 0;)
+		m_FileBuffer.insert(m_FileBuffer.end(), buf, buf + count);
+
+	fclose(file);
+
+	return LoadBuffer();
+}
 
-	m_FileDataBase	= (char *)VirtualAlloc(nullptr, m_FileSize, MEM_COMMIT, PAGE_READWRITE);
-	m_FileData		= m_FileDataBase;
+bool IDASig::Load(const uint8_t *Data, size_t Size)
+{
+	m_FileBuffer.assign(Data, Data + Size);
+
+	return LoadBuffer();
+}
 
-	if (!m_FileDataBase)
+bool IDASig::LoadBuffer()
+{
+	if (m_FileBuffer.size() < sizeof(IDASigHeader))
 	{
-		_plugin_logprintf("Failed to allocate memory\n");
+		SetError("No data in file");
 		return false;
 	}
 
-	// Read the file
-	if (!ReadFile(m_FileHandle, m_FileDataBase, m_FileSize, &m_FileSize, nullptr))
-		return false;
+	m_FileData	= m_FileBuffer.data();
+	m_FileEnd	= m_FileData + m_FileBuffer.size();
 
 	// Copy the header into its own struct
 	memcpy(&Header, m_FileData, sizeof(IDASigHeader));
@@ -57,7 +72,7 @@ bool IDASig::Load(const char *Path)
 	// Integrity check
 	if (memcmp(Header.Magic, "IDASGN", 6) != 0)
 	{
-		_plugin_logprintf("Invalid signature header\n");
+		SetError("Invalid signature header");
 		return false;
 	}
 
@@ -68,11 +83,17 @@ bool IDASig::Load(const char *Path)
 
 	if (Header.Version != IDASIG_VERSION_NEWEST)
 	{
-		_plugin_logprintf("Unsupported signature version %d\n", Header.Version);
+		SetError("Unsupported signature version");
 		return false;
 	}
 
 	// Read the signature name (stored directly after the header)
+	if (Header.SigNameLength > (m_FileEnd - m_FileData))
+	{
+		SetError("Truncated signature name");
+		return false;
+	}
+
 	memcpy(SignatureName, m_FileData, Header.SigNameLength);
 	SignatureName[Header.SigNameLength] = '\0';
 
@@ -82,14 +103,11 @@ bool IDASig::Load(const char *Path)
 	if (Header.SigFlags & IDASIG_FLAG_COMPRESSED)
 	{
 		if (!Decompress())
-		{
-			_plugin_logprintf("A fatal error occurred while decompressing\n");
 			return false;
-		}
 	}
 
 	BuildTree(&BaseNode);
-	return true;
+	return m_Error.empty();
 }
 
 bool IDASig::Support32Bit()
@@ -142,35 +160,29 @@ bool IDASig::Decompress()
 	//
 	// ZLIB
 	// 	
-	DWORD inflatedOffset = m_FileData - m_FileDataBase;
-	DWORD inflatedSize = m_FileSize - inflatedOffset;
-	_plugin_logprintf("Compressed data at offset 0x%X with size 0x%X\n", inflatedOffset, inflatedSize);
+	size_t inflatedSize = m_FileEnd - m_FileData;
 
 	std::vector<unsigned char> inflatedData;
 	inflatedData.resize(inflatedSize * 3);
+	uLongf destLen;
 	while (true)
 	{
-		uLongf destLen = inflatedData.size();
-		int err = uncompress((Bytef*)inflatedData.data(), &destLen, (Bytef*)m_FileData, inflatedSize);
+		destLen = (uLongf)inflatedData.size();
+		int err = uncompress((Bytef*)inflatedData.data(), &destLen, (const Bytef*)m_FileData, (uLong)inflatedSize);
 		if (err == Z_OK) //all good
 			break;
-		else if (err == Z_BUF_ERROR) //ouput buffer too small
+		else if (err == Z_BUF_ERROR && inflatedData.size() < (1u << 30)) //ouput buffer too small
 			inflatedData.resize(inflatedData.size() * 2);
 		else
 		{
-			_plugin_logprintf("Decompression error %d!\n", err);
+			SetError("A fatal error occurred while decompressing");
 			return false;
 		}
 	}
 
-	VirtualFree(m_FileData, 0, MEM_RELEASE);
-	m_FileData = (char *)VirtualAlloc(nullptr, inflatedData.size(), MEM_COMMIT, PAGE_READWRITE);
-	if (!m_FileData)
-	{
-		_plugin_logprintf("Failed to allocate memory!\n");
-		return false;
-	}
-	memcpy(m_FileData, inflatedData.data(), inflatedData.size());
+	m_FileBuffer.assign(inflatedData.begin(), inflatedData.begin() + destLen);
+	m_FileData	= m_FileBuffer.data();
+	m_FileEnd	= m_FileData + m_FileBuffer.size();
 	return true;
 }
 
@@ -195,8 +207,8 @@ void IDASig::BuildTree(IDASigNode *Node)
 	}
 	else
 	{
-		__debugbreak();
 		// FIXME..........................
+		SetError("Unsupported signature tree version");
 	}
 }
 
@@ -204,7 +216,7 @@ void IDASig::BuildTreeNode_V7(IDASigNode *Node, int InternalNodeCount)
 {
 	uint32_t relocationBitmask;
 
-	for (int i = 0; i < InternalNodeCount; ++i)
+	for (int i = 0; i < InternalNodeCount && m_Error.empty(); ++i)
 	{
 		uint32_t nodeByteCount = ReadByte();
 		IDASigNode childNode;
@@ -212,11 +224,11 @@ void IDASig::BuildTreeNode_V7(IDASigNode *Node, int InternalNodeCount)
 		// Only 32 bytes are allowed
 		if (nodeByteCount > IDASIG_MAX_NODE_BYTES)
 		{
-			printf("Too many bytes\n");
-			exit(1);
+			SetError("Too many bytes in a node");
+			return;
 		}
 
-		uint32_t curRelocationBitmask = 1 << (nodeByteCount - 1);
+		uint32_t curRelocationBitmask = (nodeByteCount > 0) ? (1u << (nodeByteCount - 1)) : 0;
 
 		if (nodeByteCount >= 16)
 			relocationBitmask = ReadRelocationBit();
@@ -281,8 +293,8 @@ void IDASig::BuildLeafNode_V7(IDASigNode *Node)
 				{
 					if (i >= 1024)
 					{
-						printf("reference length exceeded\n");
-						exit(1);
+						SetError("Reference length exceeded");
+						return;
 					}
 
 					if (readFlags < 32)
@@ -297,11 +309,10 @@ void IDASig::BuildLeafNode_V7(IDASigNode *Node)
 
 				refCurOffset += delta;
 
-				if (refCurOffset == 0)
-					printf(" ");
-
 				IDASigLeaf leaf;
-				strcpy_s(leaf.Symbol, name.c_str());
+				size_t nameLength = std::min(name.length(), sizeof(leaf.Symbol) - 1);
+				memcpy(leaf.Symbol, name.c_str(), nameLength);
+				leaf.Symbol[nameLength] = '\0';
 				leaf.CrcOffset = treeBlockLen;
 				leaf.Crc16 = crc16;
 				Node->Leaves.push_back(leaf);
@@ -325,6 +336,12 @@ void IDASig::BuildLeafNode_V7(IDASigNode *Node)
 				if (ref_name_len <= 0)
 					ref_name_len = ReadBitshift();
 
+				if (ref_name_len <= 0 || ref_name_len > (uint32_t)(m_FileEnd - m_FileData))
+				{
+					SetError("Truncated reference name");
+					return;
+				}
+
 				std::string ref_name = std::string(m_FileData, ref_name_len);
 
 				// If last char is 0, we have a special flag set
@@ -338,13 +355,34 @@ void IDASig::BuildLeafNode_V7(IDASigNode *Node)
 	} while (readFlags & 0x10);
 }
 
+void IDASig::SetError(const char *Error)
+{
+	// The first error is the one worth reporting
+	if (m_Error.empty())
+		m_Error = Error;
+}
+
 void IDASig::IncrementPos(int Size)
 {
+	if (Size > (m_FileEnd - m_FileData))
+	{
+		SetError("Unexpected end of file");
+		m_FileData = m_FileEnd;
+		return;
+	}
+
 	m_FileData += Size;
 }
 
 uint32_t IDASig::ReadByte()
 {
+	// Reads past the end return zero, which ends every loop in the tree
+	if (m_FileData >= m_FileEnd)
+	{
+		SetError("Unexpected end of file");
+		return 0;
+	}
+
 	uint8_t val = *m_FileData;
 
 	IncrementPos(sizeof(uint8_t));
@@ -354,7 +392,10 @@ uint32_t IDASig::ReadByte()
 
 uint32_t IDASig::ReadWord()
 {
-	return (ReadByte() << 8) + ReadByte();
+	// Big endian, and the reads have to happen in order
+	uint32_t upper = ReadByte();
+
+	return (upper << 8) + ReadByte();
 }
 
 uint32_t IDASig::ReadBitshift()
@@ -383,5 +424,75 @@ uint32_t IDASig::ReadRelocationBit()
 		return ReadWord() + (upper << 16);
 	}
 
-	return ReadWord() + (ReadWord() << 16);
+	uint32_t upper = ReadWord();
+
+	return ReadWord() + (upper << 16);
+}
+
+bool IDASig::MatchSignatureSymbol(IDASigNode *Base, const uint8_t *Data, size_t Size, size_t& Length, std::string& Name)
+{
+	if (Base->Nodes.size() > 0)
+	{
+		// Check each node
+		for (auto& node : Base->Nodes)
+		{
+			// Does this node match? Relocation bytes don't matter.
+			if (Size < (size_t)node.m_DataIndex || !PackedMatch(Data, node.Values, &node.RelocationMask, node.m_DataIndex))
+				continue;
+
+			// It does match, increment the input pointer and decrease length
+			Data	+= node.m_DataIndex;
+			Size	-= node.m_DataIndex;
+			Length	+= node.m_DataIndex;
+
+			// Recurse
+			return MatchSignatureSymbol(&node, Data, Size, Length, Name);
+		}
+	}
+	else if (Base->Leaves.size() > 0)
+	{
+		// Leaves only depend on the CRC16, so the first one decides
+		auto itr = Base->Leaves.begin();
+
+		Length += itr->CrcOffset;
+
+		// Check the CRC16 if there was one
+		if (itr->Crc16 != 0)
+		{
+			if (Size < itr->CrcOffset || crc16(Data, itr->CrcOffset) != itr->Crc16)
+				return false;
+		}
+
+		// This entry has now been used, so remove it
+		Name = itr->Symbol;
+		Base->Leaves.erase(itr);
+		return true;
+	}
+
+	return false;
+}
+
+uint32_t IDASig::Scan(const uint8_t *Data, size_t Size, const IDASigMatchCallback& Callback)
+{
+	uint32_t count = 0;
+	std::string name;
+
+	for (size_t offset = 0; offset < Size;)
+	{
+		size_t length = 0;
+
+		if (MatchSignatureSymbol(&BaseNode, Data + offset, Size - offset, length, name))
+		{
+			Callback(offset, name.c_str());
+
+			offset += length;
+			count++;
+		}
+		else
+		{
+			offset++;
+		}
+	}
+
+	return count;
 }
\ No newline at end of file
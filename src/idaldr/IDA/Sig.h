@@ -1,5 +1,14 @@
 #pragma once
 
+//
+// IDA FLIRT signature (.sig) files. Loading and matching only use local buffers.
+//
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <functional>
+
 #define IDASIG_VERSION_4 4	// ???
 #define IDASIG_VERSION_5 5	// ???
 #define IDASIG_VERSION_6 6	// ???
@@ -28,25 +37,25 @@
 struct IDASigHeader
 {
 	char	Magic[6];		//0x0000 Default: IDASGN
-	BYTE	Version;		//0x0006 Default: VER_XX
-	BYTE	ProcessorId;	//0x0007
-	DWORD	FiletypeFlags;	//0x0008
-	WORD	OSTypes;		//0x000C
-	WORD	AppTypes;		//0x000E
-	BYTE	SigFlags;		//0x0010
+	uint8_t	Version;		//0x0006 Default: VER_XX
+	uint8_t	ProcessorId;	//0x0007
+	uint32_t	FiletypeFlags;	//0x0008
+	uint16_t	OSTypes;		//0x000C
+	uint16_t	AppTypes;		//0x000E
+	uint8_t	SigFlags;		//0x0010
 
 	char _0x0011[1];
 
-	WORD	OldModuleCount;	//0x0012
+	uint16_t	OldModuleCount;	//0x0012
 
-	WORD	CTypeCRC;		//0x0014
+	uint16_t	CTypeCRC;		//0x0014
 	char	CTypeName[12];	//0x0016
 
-	BYTE	SigNameLength;	//0x0022
-	WORD	AltCTypeCrc;	//0x0023
-	DWORD	ModuleCount;	//0x0025
+	uint8_t	SigNameLength;	//0x0022
+	uint16_t	AltCTypeCrc;	//0x0023
+	uint32_t	ModuleCount;	//0x0025
 
-	//WORD	NBytePatterns;	//0x0029 VER_8
+	//uint16_t	NBytePatterns;	//0x0029 VER_8
 };
 
 static_assert(sizeof(IDASigHeader) == 0x29, "Invalid signature header size");
@@ -56,19 +65,17 @@ class IDASigLeaf
 {
 public:
 	char Symbol[1024];
-	WORD CrcOffset;
-	WORD Crc16;
+	uint16_t CrcOffset;
+	uint16_t Crc16;
 	bool Used;
 };
 
 class IDASigNode
 {
 public:
-	struct
-	{
-		BYTE Type;
-		BYTE Value;
-	} Data[IDASIG_MAX_NODE_BYTES];
+	// Packed like PackedDescriptor: relocations are wildcards with a zero value
+	uint8_t Values[IDASIG_MAX_NODE_BYTES];
+	uint32_t RelocationMask;
 
 	std::vector<IDASigNode> Nodes;
 	std::vector<IDASigLeaf> Leaves;
@@ -80,44 +87,47 @@ private:
 public:
 	IDASigNode()
 	{
-		memset(Data, 0, sizeof(Data));
+		memset(Values, 0, sizeof(Values));
+		RelocationMask = 0;
 		Nodes.clear();
 		Leaves.clear();
 
 		m_DataIndex = 0;
 	}
 
-	void WriteByte(BYTE Value)
+	void WriteByte(uint8_t Value)
 	{
-		Data[m_DataIndex].Type	= 0xFF;
-		Data[m_DataIndex].Value	= Value;
+		Values[m_DataIndex] = Value;
 
 		m_DataIndex++;
 	}
 
 	void WriteRelocation()
 	{
-		Data[m_DataIndex].Type	= 0x00;
-		Data[m_DataIndex].Value = 0x00;
+		Values[m_DataIndex]	= 0x00;
+		RelocationMask		|= 1u << m_DataIndex;
 
 		m_DataIndex++;
 	}
 };
 
+// Receives the offset of each matched function in the scanned buffer and its name
+typedef std::function<void(size_t Offset, const char *Name)> IDASigMatchCallback;
+
 class IDASig
 {
 public:
 	IDASigHeader	Header;
-	BYTE			SignatureVersion;
+	uint8_t			SignatureVersion;
 	char			SignatureName[256];
 
 	IDASigNode		BaseNode;
 
 private:
-	HANDLE	m_FileHandle;
-	char	*m_FileDataBase; //only a reference buffer, don't touch this
-	char	*m_FileData;
-	DWORD	m_FileSize;
+	std::vector<char>	m_FileBuffer;
+	const char			*m_FileData;
+	const char			*m_FileEnd;
+	std::string			m_Error;
 
 	// Kept for consistency
 	bool m_LegacyIDB;
@@ -127,10 +137,25 @@ public:
 	~IDASig();
 
 	bool Load(const char *Path);
+	bool Load(const uint8_t *Data, size_t Size);
 	bool Support32Bit();
 	bool Support64Bit();
 
+	// Why Load failed
+	const char *Error() const
+	{
+		return m_Error.c_str();
+	}
+
+	//
+	// Walks Data once, reporting every function that matches. Each leaf is only
+	// used for its first match, so a signature can be scanned once. Returns the
+	// number of matches.
+	//
+	uint32_t Scan(const uint8_t *Data, size_t Size, const IDASigMatchCallback& Callback);
+
 private:
+	bool LoadBuffer();
 	void FixupVersion();
 	bool Decompress();
 
@@ -138,6 +163,9 @@ private:
 	void BuildTreeNode_V7(IDASigNode *Node, int InternalNodeCount);
 	void BuildLeafNode_V7(IDASigNode *Node);
 
+	bool MatchSignatureSymbol(IDASigNode *Base, const uint8_t *Data, size_t Size, size_t& Length, std::string& Name);
+
+	void SetError(const char *Error);
 	void IncrementPos(int Size);
 	uint32_t ReadByte();
 	uint32_t ReadWord();
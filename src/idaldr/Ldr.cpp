@@ -1,122 +1,5 @@
 #include "stdafx.h"
 
-int MatchNodeData(IDASigNode *Node, BYTE *Input, size_t Length)
-{
-	//
-	// Matches a pattern of bytes with an input value
-	//
-	// Returns false when:
-	//  Input buffer is too short
-	//  Pattern does not match
-	//
-	// Returns true when:
-	//  Pattern and buffer match
-	//
-	for (int i = 0; i < Node->m_DataIndex; i++)
-	{
-		// Check if the buffer was too short
-		if (Length <= 0)
-			return false;
-
-		if (Node->Data[i].Type == 0xFF)
-		{
-			if (*Input != Node->Data[i].Value)
-			{
-				// Invalid
-				return false;
-			}
-
-			Input++;
-			Length--;
-		}
-		else if (Node->Data[i].Type == 0x00)
-		{
-			//
-			// Relocation
-			//
-			// The bytes here don't matter
-			//
-			Input++;
-			Length--;
-		}
-	}
-
-	return true;
-}
-
-bool MatchSignatureLeaf(IDASigLeaf *Leaf, BYTE *Input, size_t Length)
-{
-	// Leaves depend on the CRC16
-	if (Leaf->Crc16 == 0)
-		return true;
-
-	return true;
-}
-
-struct SignatureLookup
-{
-	// IN
-	BYTE	*InputBuffer;
-	size_t	InputSize;
-
-	// OUT
-	char	Name[256];
-	int		Length;
-};
-
-bool MatchSignatureSymbol(IDASigNode *Base, SignatureLookup *Info)
-{
-	if (Base->Nodes.size() > 0)
-	{
-		// Check each node
-		for (auto& node : Base->Nodes)
-		{
-			// Does this node match?
-			if (MatchNodeData(&node, Info->InputBuffer, Info->InputSize))
-			{
-				// It does match, increment the input pointer and decrease length
-				Info->InputBuffer	+= node.m_DataIndex;
-				Info->InputSize		-= node.m_DataIndex;
-				Info->Length		+= node.m_DataIndex;
-
-				// Recurse
-				return MatchSignatureSymbol(&node, Info);
-			}
-		}
-	}
-	else if (Base->Leaves.size() > 0)
-	{
-		// Check each leaf
-		for (auto itr = Base->Leaves.begin(); itr != Base->Leaves.end(); itr++)
-		{
-			IDASigLeaf& leaf = *itr;
-
-			// Does this leaf match?
-			if (MatchSignatureLeaf(&leaf, Info->InputBuffer, Info->InputSize))
-			{
-				Info->Length += leaf.CrcOffset;
-
-				// Check the CRC16 if there was one
-				if (leaf.Crc16 != 0)
-				{
-					WORD calc = crc16(Info->InputBuffer, leaf.CrcOffset);
-
-					if (calc != leaf.Crc16)
-						return false;
-				}
-
-				// This entry has now been used, so remove it
-				Base->Leaves.erase(itr);
-
-				strcpy_s(Info->Name, leaf.Symbol);
-				return true;
-			}
-		}
-	}
-
-	return false;
-}
-
 bool ApplySignatureSymbols(char *Path, duint ModuleBase)
 {
 	_plugin_logprintf("Opening sig file '%s'\n", Path);
@@ -125,7 +8,10 @@ bool ApplySignatureSymbols(char *Path, duint ModuleBase)
 	IDASig signature;
 
 	if (!signature.Load(Path))
+	{
+		_plugin_logprintf("%s\n", signature.Error());
 		return false;
+	}
 
 	_plugin_logprintf("Loading signatures in '%s' (Version %d)\n", signature.SignatureName, (int)signature.SignatureVersion);
 
@@ -144,57 +30,24 @@ bool ApplySignatureSymbols(char *Path, duint ModuleBase)
 	}
 #endif // _WIN64
 
-	// Get the module size
-	duint moduleSize = DbgFunctions()->ModSizeFromAddr(ModuleBase);
+	// Get a local copy of the entire image for scanning
+	SnapshotPtr module = SnapshotModule(ModuleBase);
 
-	if (moduleSize <= 0)
+	if (!module)
 	{
-		_plugin_logprintf("Couldn't get module size from adress 0x%llX\n", ModuleBase);
-		return false;
-	}
-
-	// Read the entire image to a local buffer for scanning
-	PBYTE imageCopy = (PBYTE)VirtualAlloc(nullptr, moduleSize, MEM_COMMIT, PAGE_READWRITE);
-
-	if (!imageCopy || !DbgMemRead(ModuleBase, imageCopy, moduleSize))
-	{
-		_plugin_logprintf("Failed to make a copy of the remote image\n", ModuleBase);
-
-		if (imageCopy)
-			VirtualFree(imageCopy, 0, MEM_RELEASE);
-
+		_plugin_logprintf("Failed to make a copy of the remote image at 0x%llX\n", ModuleBase);
 		return false;
 	}
 
 	// Scan memory
-	UINT32 count = 0;
-
-	for (PBYTE va = imageCopy; va < (imageCopy + moduleSize);)
+	UINT32 count = signature.Scan(module->Data(), module->Size(), [ModuleBase](size_t Offset, const char *Name)
 	{
-		SignatureLookup info;
-		memset(&info, 0, sizeof(SignatureLookup));
-
-		info.InputBuffer	= va;
-		info.InputSize		= (va - imageCopy);
+		duint remoteVA = ModuleBase + Offset;
 
-		if (MatchSignatureSymbol(&signature.BaseNode, &info))
-		{
-			duint remoteVA	= ModuleBase + (size_t)(va - imageCopy);
-			va				+= info.Length;
-
-			//_plugin_logprintf("VA: 0x%llx - %s\n", (ULONGLONG)remoteVA, info.Name);
-
-			DbgSetAutoLabelAt(remoteVA, info.Name);
-			count++;
-		}
-		else
-		{
-			va++;
-		}
-	}
+		//_plugin_logprintf("VA: 0x%llx - %s\n", (ULONGLONG)remoteVA, Name);
 
-	// Free memory
-	VirtualFree(imageCopy, 0, MEM_RELEASE);
+		DbgSetAutoLabelAt(remoteVA, Name);
+	});
 
 	_plugin_logprintf("Applied %d signatures(s)\n", count);
 	return true;
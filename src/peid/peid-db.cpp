@@ -0,0 +1,144 @@
+#include "peid-db.h"
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include "../sigmake/DescriptorText.h"
+
+#ifndef _MSC_VER
+#include <strings.h>
+#define _strnicmp strncasecmp
+#endif // _MSC_VER
+
+static void PEiDRemoveAll(std::string& Subject, const char *Search)
+{
+	size_t length = strlen(Search);
+
+	for (size_t pos; (pos = Subject.find(Search)) != std::string::npos;)
+		Subject.erase(pos, length);
+}
+
+bool PEiDLoadDatabase(const char *Path, PEID_DATABASE& Database)
+{
+	Database.Signatures.clear();
+	Database.Invalid = 0;
+
+	FILE *dbFile = nullptr;
+
+#ifdef _MSC_VER
+	fopen_s(&dbFile, Path, "r");
+#else
+	dbFile = fopen(Path, "r");
+#endif // _MSC_VER
+
+	if (!dbFile)
+		return false;
+
+	// Signature entries
+	char buf[4096];
+	std::string name;
+	std::string pattern;
+
+	// Read the file line-by-line
+	while (fgets(buf, sizeof(buf), dbFile) != nullptr)
+	{
+		if (buf[0] == ';')
+		{
+			// Comment line
+			continue;
+		}
+		if (buf[0] == '[')
+		{
+			// '[' indicates the start of a signature
+			name = buf + 1;
+
+			// Trim the ending bracket
+			name = name.substr(0, name.find_last_of(']'));
+		}
+		else if (_strnicmp(buf, "ep_only", 7) == 0)
+		{
+			// 'ep_only' indicates the end of a signature
+			bool isEntry = strstr(buf, "true") ? true : false;
+
+			// Replace bad characters
+			PEiDRemoveAll(pattern, "\r");
+			PEiDRemoveAll(pattern, "\n");
+			PEiDRemoveAll(pattern, "signature = ");
+
+			// Compile
+			PackedDescriptor packed;
+
+			if (PackedFromPEiD(pattern.c_str(), packed))
+				Database.Signatures.push_back({ name, isEntry, ScanPattern(packed) });
+			else
+				Database.Invalid++;
+
+			// Reset everything
+			name.clear();
+			pattern.clear();
+		}
+		else
+		{
+			// Anything else is appended to the signature
+			pattern += buf;
+		}
+	}
+
+	fclose(dbFile);
+	return true;
+}
+
+void PEiDScanDatabase(const PEID_DATABASE& Database, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize, const PEiDMatchCallback& Callback, PEID_SCAN_STATS& Stats)
+{
+	Stats.Tested	= (int)Database.Signatures.size() + Database.Invalid;
+	Stats.Invalid	= Database.Invalid;
+	Stats.Matched	= 0;
+
+	std::vector<size_t> offsets;
+
+	for (auto& signature : Database.Signatures)
+	{
+		// Only the first match is used. Offsets rather than PEiDPatternScan, where a match
+		// at the start of a module based at 0 (a raw file) would look like no match.
+		offsets.clear();
+
+		if (signature.Pattern.Scan(ModuleCopy, ModuleSize, offsets, 1) == 0)
+			continue;
+
+		Callback(ModuleBase + offsets[0], signature.Name.c_str());
+		Stats.Matched++;
+	}
+}
+
+uint64_t PEiDPatternScan(const char *Pattern, bool EntryPoint, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize)
+{
+	// Parse the signature as a PEiD type
+	PackedDescriptor packed;
+
+	if (!PackedFromPEiD(Pattern, packed))
+		return 0;
+
+	return PEiDPatternScan(packed, EntryPoint, ModuleCopy, ModuleBase, ModuleSize);
+}
+
+uint64_t PEiDPatternScan(const PackedDescriptor& Descriptor, bool EntryPoint, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize)
+{
+	return PEiDPatternScan(ScanPattern(Descriptor), EntryPoint, ModuleCopy, ModuleBase, ModuleSize);
+}
+
+uint64_t PEiDPatternScan(const ScanPattern& Pattern, bool EntryPoint, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize)
+{
+	// Check if only the entry point should be scanned
+	if (EntryPoint)
+	{
+		//ModuleBase = ep_start;
+		//ModuleSize = ep_size;
+	}
+
+	// Only the first match is used
+	std::vector<size_t> offsets;
+
+	if (Pattern.Scan(ModuleCopy, ModuleSize, offsets, 1) <= 0)
+		return 0;
+
+	return ModuleBase + offsets[0];
+}
\ No newline at end of file
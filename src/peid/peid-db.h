@@ -0,0 +1,47 @@
+#pragma once
+
+//
+// PEiD signature databases (userdb.txt and friends) scanned against a local copy of a
+// module.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../sigmake/Scanner.h"
+
+struct PEID_SIGNATURE
+{
+	std::string Name;
+	bool EntryPoint;		// ep_only
+	ScanPattern Pattern;
+};
+
+// Every entry compiled once, so any number of modules can be scanned without parsing it again
+struct PEID_DATABASE
+{
+	std::vector<PEID_SIGNATURE> Signatures;
+	int Invalid;			// Entries skipped because their signature couldn't be parsed
+};
+
+struct PEID_SCAN_STATS
+{
+	int Tested;		// Entries that were scanned for
+	int Invalid;	// Entries skipped because their signature couldn't be parsed
+	int Matched;
+};
+
+// Receives the first match of every entry that matched
+typedef std::function<void(uint64_t Address, const char *Name)> PEiDMatchCallback;
+
+// Fails only if the database can't be opened
+bool PEiDLoadDatabase(const char *Path, PEID_DATABASE& Database);
+
+// Safe to call from several threads at once with the same Database
+void PEiDScanDatabase(const PEID_DATABASE& Database, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize, const PEiDMatchCallback& Callback, PEID_SCAN_STATS& Stats);
+
+// Return the address of the first match, 0 if there is none (or the signature is invalid)
+uint64_t PEiDPatternScan(const char *Pattern, bool EntryPoint, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize);
+uint64_t PEiDPatternScan(const PackedDescriptor& Descriptor, bool EntryPoint, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize);
+uint64_t PEiDPatternScan(const ScanPattern& Pattern, bool EntryPoint, const uint8_t *ModuleCopy, uint64_t ModuleBase, size_t ModuleSize);
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 
 #include "../idaldr/stdafx.h"
+#include "peid-db.h"
 
-bool ApplyPEiDSymbols(char *Path, duint ModuleBase);
-duint PEiDPatternScan(const char *Pattern, bool EntryPoint, PBYTE ModuleCopy, duint ModuleBase, duint ModuleSize);
\ No newline at end of file
+bool ApplyPEiDSymbols(char *Path, duint ModuleBase);
\ No newline at end of file
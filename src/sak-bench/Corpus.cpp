@@ -0,0 +1,311 @@
+#include "Corpus.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "../idaldr/IDA/Crc16.h"
+
+// Planted items of each random kind
+const size_t BenchKeyScheduleCount	= 64;
+const size_t BenchStringCount		= 64;
+
+static uint8_t BenchSbox(uint8_t Value)
+{
+	// Multiplicative inverse in GF(2^8), then the affine transform
+	uint8_t inverse = 0;
+
+	for (int i = 1; i < 256 && Value; i++)
+	{
+		uint8_t a = Value;
+		uint8_t b = (uint8_t)i;
+		uint8_t product = 0;
+
+		while (b)
+		{
+			if (b & 1)
+				product ^= a;
+
+			a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+			b >>= 1;
+		}
+
+		if (product == 1)
+		{
+			inverse = (uint8_t)i;
+			break;
+		}
+	}
+
+	uint8_t result = 0x63;
+
+	for (int i = 0; i < 5; i++)
+		result ^= (uint8_t)((inverse << i) | (inverse >> (8 - i)));
+
+	return result;
+}
+
+static void BenchExpandKey(const uint8_t *Key, size_t KeyLength, std::vector<uint8_t>& Schedule)
+{
+	static uint8_t sbox[256];
+
+	if (sbox[0] == 0)
+	{
+		for (int i = 0; i < 256; i++)
+			sbox[i] = BenchSbox((uint8_t)i);
+	}
+
+	// FIPS-197 key expansion, stored in byte order
+	size_t words		= KeyLength / 4;
+	size_t totalWords	= 4 * (words + 7);
+	uint8_t rcon		= 1;
+
+	Schedule.assign(Key, Key + KeyLength);
+
+	for (size_t i = words; i < totalWords; i++)
+	{
+		uint8_t temp[4];
+		memcpy(temp, &Schedule[(i - 1) * 4], 4);
+
+		if ((i % words) == 0)
+		{
+			uint8_t first = temp[0];
+
+			temp[0] = sbox[temp[1]] ^ rcon;
+			temp[1] = sbox[temp[2]];
+			temp[2] = sbox[temp[3]];
+			temp[3] = sbox[first];
+
+			rcon = (uint8_t)((rcon << 1) ^ ((rcon & 0x80) ? 0x1B : 0));
+		}
+		else if (words > 6 && (i % words) == 4)
+		{
+			for (auto& b : temp)
+				b = sbox[b];
+		}
+
+		for (int j = 0; j < 4; j++)
+			Schedule.push_back(Schedule[(i - words) * 4 + j] ^ temp[j]);
+	}
+}
+
+static void BenchEmitFunction(BenchRandom& Random, std::vector<uint8_t>& Code)
+{
+	auto emit = [&Code](std::initializer_list<uint8_t> Bytes)
+	{
+		Code.insert(Code.end(), Bytes);
+	};
+
+	auto emit32 = [&](uint32_t Value)
+	{
+		for (int i = 0; i < 4; i++)
+			Code.push_back((uint8_t)(Value >> (i * 8)));
+	};
+
+	// Prologue
+	if (Random.Next(2))
+		emit({ 0x55, 0x48, 0x89, 0xE5 });
+	else
+		emit({ 0x48, 0x89, 0x5C, 0x24, (uint8_t)(8 * (1 + Random.Next(4))), 0x57 });
+
+	emit({ 0x48, 0x83, 0xEC, (uint8_t)(16 * (1 + Random.Next(8))) });
+
+	// Body: the usual mix of stack accesses, RIP-relative loads, calls and short branches
+	for (uint32_t count = 8 + Random.Next(48); count > 0; count--)
+	{
+		switch (Random.Next(10))
+		{
+		case 0: emit({ 0x48, 0x8B, 0x05 }); emit32(Random.Next(0x100000)); break;
+		case 1: emit({ 0xE8 }); emit32(Random.Next()); break;
+		case 2: emit({ 0x48, 0x8D, 0x4C, 0x24, (uint8_t)(8 * Random.Next(16)) }); break;
+		case 3: emit({ 0x89, 0x44, 0x24, (uint8_t)(8 * Random.Next(16)) }); break;
+		case 4: emit({ 0x48, 0x85, 0xC0 }); break;
+		case 5: emit({ (uint8_t)(0x74 + Random.Next(2)), (uint8_t)Random.Next(0x40) }); break;
+		case 6: emit({ 0xB9 }); emit32(Random.Next(0x1000)); break;
+		case 7: emit({ 0x33, 0xC0 }); break;
+		case 8: emit({ 0x48, 0x8B, (uint8_t)(0xC8 + Random.Next(8)) }); break;
+		case 9: emit({ 0x8B, 0x54, 0x24, (uint8_t)(8 * Random.Next(16)) }); break;
+		}
+	}
+
+	// Epilogue and alignment
+	emit({ 0x48, 0x83, 0xC4, 0x20, 0x5F, 0xC3 });
+
+	while (Code.size() % 16)
+		Code.push_back(0xCC);
+}
+
+void BenchBuildCorpus(size_t Size, uint32_t Seed, BENCH_CORPUS& Corpus)
+{
+	BenchRandom random(Seed);
+
+	Corpus = BENCH_CORPUS();
+	Corpus.Data.reserve(Size + 4096);
+
+	while (Corpus.Data.size() < Size)
+	{
+		Corpus.Functions.push_back(Corpus.Data.size());
+		BenchEmitFunction(random, Corpus.Data);
+	}
+
+	Corpus.Data.resize(Size);
+
+	while (!Corpus.Functions.empty() && Corpus.Functions.back() >= Size)
+		Corpus.Functions.pop_back();
+
+	// Every plant gets its own slot so none of them overlap
+	std::vector<const array_info_t *> constants;
+
+	for (const array_info_t *ptr = non_sparse_consts; ptr->size != 0; ptr++)
+		constants.push_back(ptr);
+
+	size_t plantCount	= BenchKeyScheduleCount + constants.size() + BenchStringCount;
+	size_t slotSize		= (Size / plantCount) & ~(size_t)15;
+	size_t slot			= 0;
+
+	auto place = [&](size_t PlantSize) -> size_t
+	{
+		if (slotSize < PlantSize + 16)
+			return (size_t)-1;
+
+		size_t start = (slot++) * slotSize;
+		return start + (random.Next((uint32_t)((slotSize - PlantSize) / 16)) * 16);
+	};
+
+	for (size_t i = 0; i < BenchKeyScheduleCount; i++)
+	{
+		size_t keyLength = 16 + 8 * (i % 3);
+		uint8_t key[32];
+
+		for (size_t j = 0; j < keyLength; j++)
+			key[j] = (uint8_t)random.Next();
+
+		std::vector<uint8_t> schedule;
+		BenchExpandKey(key, keyLength, schedule);
+
+		size_t offset = place(schedule.size());
+
+		if (offset == (size_t)-1)
+			break;
+
+		memcpy(&Corpus.Data[offset], schedule.data(), schedule.size());
+
+		char hex[65];
+
+		for (size_t j = 0; j < keyLength; j++)
+			snprintf(&hex[j * 2], 3, "%02x", key[j]);
+
+		Corpus.KeySchedules.push_back({ offset, hex });
+	}
+
+	for (const array_info_t *ai : constants)
+	{
+		size_t arraySize	= ai->size * ai->elsize;
+		size_t offset		= place(arraySize);
+
+		if (offset == (size_t)-1)
+			break;
+
+		memcpy(&Corpus.Data[offset], ai->array, arraySize);
+		Corpus.Constants.push_back({ offset, ai->name });
+	}
+
+	for (size_t i = 0; i < BenchStringCount; i++)
+	{
+		size_t offset = place(BenchPlantSize);
+
+		if (offset == (size_t)-1)
+			break;
+
+		for (size_t j = 0; j < BenchPlantSize; j++)
+			Corpus.Data[offset + j] = (uint8_t)random.Next();
+
+		char name[32];
+		snprintf(name, sizeof(name), "bench_function_%02u", (unsigned int)i);
+
+		Corpus.Strings.push_back({ offset, name });
+	}
+}
+
+std::vector<uint8_t> BenchBuildFlirt(const BENCH_CORPUS& Corpus)
+{
+	std::vector<uint8_t> file;
+
+	auto put = [&file](uint64_t Value, size_t Size)
+	{
+		for (size_t i = 0; i < Size; i++)
+			file.push_back((i < 8) ? (uint8_t)(Value >> (i * 8)) : 0);
+	};
+
+	auto putBitshift = [&file](uint32_t Value)
+	{
+		if (Value >= 0x80)
+			file.push_back((uint8_t)(0x80 | (Value >> 8)));
+
+		file.push_back((uint8_t)Value);
+	};
+
+	const char name[] = "sak-bench";
+
+	// Header (IDASigHeader, 0x29 bytes)
+	file.insert(file.end(), { 'I', 'D', 'A', 'S', 'G', 'N' });
+	put(7, 1);							// Version
+	put(0, 1);							// ProcessorId
+	put(0, 4);							// FiletypeFlags
+	put(0, 2);							// OSTypes
+	put(0x300, 2);						// AppTypes: 32 and 64-bit
+	put(0, 1);							// SigFlags: not compressed
+	put(0, 1);
+	put(0, 2);							// OldModuleCount
+	put(0, 2);							// CTypeCRC
+	put(0, 12);							// CTypeName
+	put(sizeof(name) - 1, 1);			// SigNameLength
+	put(0, 2);							// AltCTypeCrc
+	put(Corpus.Strings.size(), 4);		// ModuleCount
+
+	file.insert(file.end(), name, name + sizeof(name) - 1);
+
+	// One internal node per function: the 32-byte prefix with its last 4 bytes as
+	// relocations, then a leaf checking the CRC16 of the rest
+	putBitshift((uint32_t)Corpus.Strings.size());
+
+	for (auto& plant : Corpus.Strings)
+	{
+		const uint8_t *data = &Corpus.Data[plant.Offset];
+
+		put(BenchPlantPrefix, 1);
+		put(0x0F, 1);
+
+		file.insert(file.end(), data, data + BenchPlantPrefix - 4);
+
+		uint16_t crc = crc16(data + BenchPlantPrefix, BenchPlantSize - BenchPlantPrefix);
+
+		putBitshift(0);										// No more internal nodes
+		put(BenchPlantSize - BenchPlantPrefix, 1);			// CRC length
+		file.push_back((uint8_t)(crc >> 8));				// CRC16, big endian
+		file.push_back((uint8_t)crc);
+		putBitshift((uint32_t)BenchPlantSize);				// Function length
+		putBitshift(0);										// Name offset
+		file.insert(file.end(), plant.Name.begin(), plant.Name.end());
+		put(0, 1);											// Flags: last name, last leaf
+	}
+
+	return file;
+}
+
+std::string BenchPEiDPattern(const BENCH_CORPUS& Corpus, size_t Index)
+{
+	const uint8_t *data = &Corpus.Data[Corpus.Strings[Index].Offset];
+	std::string pattern;
+
+	for (size_t i = 0; i < BenchPlantSize; i++)
+	{
+		char text[4];
+		snprintf(text, sizeof(text), "%02X", data[i]);
+
+		if (!pattern.empty())
+			pattern += ' ';
+
+		pattern += ((i % 5) == 4) ? "??" : text;
+	}
+
+	return pattern;
+}
\ No newline at end of file
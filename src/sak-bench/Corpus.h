@@ -0,0 +1,67 @@
+#pragma once
+
+//
+// Synthetic inputs for sak-bench: x86-64 style functions with AES key schedules,
+// Findcrypt constant arrays and random byte strings (used as PEiD patterns and FLIRT
+// functions) planted at known offsets. The same size and seed always produce the
+// same corpus, so results from different commits are comparable.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <string>
+#include "../findcrypt/findcrypt-core.h"
+
+// Bytes of each planted random string: a 32-byte FLIRT prefix, then the CRC16 block
+const size_t BenchPlantSize		= 48;
+const size_t BenchPlantPrefix	= 32;
+
+struct BENCH_PLANT
+{
+	size_t Offset;
+	std::string Name;
+};
+
+struct BENCH_CORPUS
+{
+	std::vector<uint8_t> Data;
+
+	std::vector<size_t> Functions;				// Starts of the generated functions
+	std::vector<BENCH_PLANT> KeySchedules;		// Name is the key in hex
+	std::vector<BENCH_PLANT> Constants;			// Name is the array name
+	std::vector<BENCH_PLANT> Strings;			// BenchPlantSize random bytes each
+};
+
+class BenchRandom
+{
+public:
+	explicit BenchRandom(uint32_t Seed)
+	{
+		m_State = Seed ? Seed : 0x6B43A9B5;
+	}
+
+	// xorshift32
+	uint32_t Next()
+	{
+		m_State ^= m_State << 13;
+		m_State ^= m_State >> 17;
+		m_State ^= m_State << 5;
+		return m_State;
+	}
+
+	uint32_t Next(uint32_t Range)
+	{
+		return Next() % Range;
+	}
+
+private:
+	uint32_t m_State;
+};
+
+void BenchBuildCorpus(size_t Size, uint32_t Seed, BENCH_CORPUS& Corpus);
+
+// An uncompressed version 7 IDA signature file with one function per planted string
+std::vector<uint8_t> BenchBuildFlirt(const BENCH_CORPUS& Corpus);
+
+// PEiD text for the planted string at Index, with every fifth byte wildcarded
+std::string BenchPEiDPattern(const BENCH_CORPUS& Corpus, size_t Index);
\ No newline at end of file
@@ -0,0 +1,593 @@
+//
+// sak-bench: throughput, latency percentiles and peak memory of every scanning engine
+// on a synthetic corpus. Each result is one JSON line with a stable name, so the
+// output of two commits can be compared line by line. Every benchmark also checks
+// that the planted items were found, so a fast but broken engine doesn't pass as
+// an improvement.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Corpus.h"
+#include "../sak-cli/JsonLine.h"
+#include "../sigmake/Scanner.h"
+#include "../sigmake/CrcPattern.h"
+#include "../sigmake/DescriptorText.h"
+#include "../findcrypt/findcrypt-core.h"
+#include "../aes-finder/aes-finder-keys.h"
+#include "../peid/peid-db.h"
+#include "../idaldr/IDA/Sig.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif // _WIN32
+
+struct BENCH_OPTIONS
+{
+	size_t Size;
+	uint32_t Seed;
+	uint32_t Iterations;
+	std::string Filter;
+	std::string Label;
+};
+
+struct BENCH_CONTEXT
+{
+	const BENCH_OPTIONS *Options;
+	const BENCH_CORPUS *Corpus;
+	int Failures;
+};
+
+// Runs one iteration and returns false if the planted items weren't all found
+typedef std::function<bool()> BenchIteration;
+
+static uint64_t BenchPeakMemory()
+{
+#ifndef _WIN32
+	struct rusage usage;
+
+	// Kilobytes on Linux
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		return (uint64_t)usage.ru_maxrss * 1024;
+#endif // _WIN32
+
+	return 0;
+}
+
+static double BenchPercentile(const std::vector<double>& Sorted, double Percentile)
+{
+	// Nearest rank
+	size_t rank = (size_t)((Percentile / 100.0) * Sorted.size() + 0.999999);
+	return Sorted[std::min(std::max<size_t>(rank, 1), Sorted.size()) - 1];
+}
+
+//
+// Bytes is the amount of input one iteration processes. Runs one untimed warm-up
+// iteration, then Options.Iterations timed ones.
+//
+static void BenchRun(BENCH_CONTEXT& Context, const char *Name, const char *Engine, uint64_t Bytes, const BenchIteration& Iteration)
+{
+	if (!Context.Options->Filter.empty() && !strstr(Name, Context.Options->Filter.c_str()))
+		return;
+
+	fprintf(stderr, "%s...\n", Name);
+
+	bool verified = Iteration();
+	std::vector<double> latencies;
+
+	for (uint32_t i = 0; i < Context.Options->Iterations; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		verified = Iteration() && verified;
+		auto end = std::chrono::steady_clock::now();
+
+		latencies.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+	}
+
+	std::sort(latencies.begin(), latencies.end());
+
+	double median = BenchPercentile(latencies, 50);
+	double total = 0;
+
+	for (double latency : latencies)
+		total += latency;
+
+	std::string output;
+	JsonLine line;
+	line.AddString("benchmark", Name);
+	line.AddString("engine", Engine);
+	line.AddNumber("bytes", Bytes);
+	line.AddNumber("iterations", latencies.size());
+	line.AddDouble("mb_per_s", (Bytes / (1024.0 * 1024.0)) / (median / 1000.0));
+	line.AddDouble("mean_ms", total / latencies.size());
+	line.AddDouble("p50_ms", median);
+	line.AddDouble("p90_ms", BenchPercentile(latencies, 90));
+	line.AddDouble("p99_ms", BenchPercentile(latencies, 99));
+	line.AddDouble("max_ms", latencies.back());
+	line.AddNumber("peak_memory", BenchPeakMemory());
+	line.AddBool("verified", verified);
+	line.Finish(output);
+
+	fwrite(output.data(), 1, output.size(), stdout);
+	fflush(stdout);
+
+	if (!verified)
+		Context.Failures++;
+}
+
+static void BenchPatternScan(BENCH_CONTEXT& Context)
+{
+	const BENCH_CORPUS& corpus = *Context.Corpus;
+	BenchRandom random(Context.Options->Seed ^ 0x5CA9);
+
+	// Function prologues with every fourth byte wildcarded, like a typical code signature
+	std::vector<std::pair<size_t, ScanPattern>> patterns;
+
+	for (int i = 0; i < 8 && !corpus.Functions.empty(); i++)
+	{
+		size_t offset = corpus.Functions[random.Next((uint32_t)corpus.Functions.size())];
+		size_t length = std::min<size_t>(24, corpus.Data.size() - offset);
+
+		std::vector<uint8_t> wildcards(length);
+
+		for (size_t j = 0; j < length; j++)
+			wildcards[j] = (j % 4) == 3;
+
+		patterns.emplace_back(offset, ScanPattern(&corpus.Data[offset], wildcards.data(), length));
+	}
+
+	auto scanAll = [&](std::function<void(const ScanPattern& Pattern, std::vector<size_t>& Offsets)> Scan)
+	{
+		return [&corpus, &patterns, Scan]()
+		{
+			bool found = true;
+
+			for (auto& pattern : patterns)
+			{
+				std::vector<size_t> offsets;
+				Scan(pattern.second, offsets);
+
+				found = found && std::binary_search(offsets.begin(), offsets.end(), pattern.first);
+			}
+
+			return found;
+		};
+	};
+
+	uint64_t bytes = corpus.Data.size() * patterns.size();
+	const char *levelNames[] = { "pattern_scan/scalar", "pattern_scan/sse2", "pattern_scan/avx2" };
+
+	for (int level = SCAN_LEVEL_SCALAR; level <= ScanGetBestLevel(); level++)
+	{
+		BenchRun(Context, levelNames[level], "PatternScan", bytes, scanAll([&corpus, level](const ScanPattern& Pattern, std::vector<size_t>& Offsets)
+		{
+			Pattern.Scan(corpus.Data.data(), corpus.Data.size(), Offsets, SIZE_MAX, (SCAN_LEVEL)level);
+		}));
+	}
+
+	BenchRun(Context, "pattern_scan/parallel", "PatternScan", bytes, scanAll([&corpus](const ScanPattern& Pattern, std::vector<size_t>& Offsets)
+	{
+		Pattern.ScanParallel(corpus.Data.data(), corpus.Data.size(), [&Offsets](size_t Offset)
+		{
+			Offsets.push_back(Offset);
+			return true;
+		});
+	}));
+
+	//
+	// The same prologues as CRC signatures, and longer ones with two displacements
+	// wildcarded, which are rolled instead of checksummed at every position
+	//
+	std::vector<std::pair<size_t, CrcPattern>> crcPatterns;
+	std::vector<std::pair<size_t, CrcPattern>> crcLongPatterns;
+
+	for (auto& pattern : patterns)
+	{
+		size_t length = pattern.second.Count();
+		std::vector<uint8_t> wildcards(length);
+
+		for (size_t j = 0; j < length; j++)
+			wildcards[j] = (j % 4) == 3;
+
+		crcPatterns.emplace_back(pattern.first, CrcPattern(PackedDescriptor(&corpus.Data[pattern.first], wildcards.data(), length)));
+
+		length = std::min<size_t>(256, corpus.Data.size() - pattern.first);
+		wildcards.assign(length, 0);
+
+		for (size_t j = 0; j < length; j++)
+			wildcards[j] = (j >= 7 && j < 11) || (j >= 100 && j < 104);
+
+		crcLongPatterns.emplace_back(pattern.first, CrcPattern(PackedDescriptor(&corpus.Data[pattern.first], wildcards.data(), length)));
+	}
+
+	const char *methods[] = { "table", "hardware", "rolling" };
+
+	for (auto set : { &crcPatterns, &crcLongPatterns })
+	{
+		for (auto method : { CRC_SCAN_TABLE, CRC_SCAN_HARDWARE, CRC_SCAN_ROLLING })
+		{
+			if (method == CRC_SCAN_HARDWARE && !CrcHardwareSupported())
+				continue;
+
+			std::string name = std::string((set == &crcPatterns) ? "crc_scan/" : "crc_scan_long/") + methods[method];
+
+			BenchRun(Context, name.c_str(), "CrcPattern", bytes, [&corpus, set, method]()
+			{
+				bool found = true;
+
+				for (auto& pattern : *set)
+				{
+					std::vector<size_t> offsets;
+					pattern.second.Scan(corpus.Data.data(), corpus.Data.size(), offsets, SIZE_MAX, method);
+
+					found = found && std::binary_search(offsets.begin(), offsets.end(), pattern.first);
+				}
+
+				return found;
+			});
+		}
+	}
+}
+
+static void BenchPEiD(BENCH_CONTEXT& Context)
+{
+	const BENCH_CORPUS& corpus = *Context.Corpus;
+	std::vector<std::string> patterns;
+
+	for (size_t i = 0; i < corpus.Strings.size(); i++)
+		patterns.push_back(BenchPEiDPattern(corpus, i));
+
+	// Parsing is part of PEiDPatternScan, just like when a database is applied
+	BenchRun(Context, "peid/patterns", "PEiDPatternScan", corpus.Data.size() * patterns.size(), [&corpus, &patterns]()
+	{
+		bool found = true;
+
+		for (size_t i = 0; i < patterns.size(); i++)
+		{
+			uint64_t address = PEiDPatternScan(patterns[i].c_str(), false, corpus.Data.data(), 0, corpus.Data.size());
+			found = found && address == corpus.Strings[i].Offset;
+		}
+
+		return found;
+	});
+}
+
+static void BenchFindcrypt(BENCH_CONTEXT& Context)
+{
+	const BENCH_CORPUS& corpus = *Context.Corpus;
+
+	// Some arrays start with another one, so only the position is checked
+	auto verify = [&corpus](std::vector<uint64_t>& Arrays)
+	{
+		std::sort(Arrays.begin(), Arrays.end());
+
+		for (auto& plant : corpus.Constants)
+		{
+			if (!std::binary_search(Arrays.begin(), Arrays.end(), plant.Offset))
+				return false;
+		}
+
+		return true;
+	};
+
+	BenchRun(Context, "findcrypt/scan", "Findcrypt::ScanConstants", corpus.Data.size(), [&corpus, &verify]()
+	{
+		std::vector<uint64_t> arrays;
+
+		FindcryptScanBuffer(corpus.Data.data(), corpus.Data.size(), 0, [&arrays](const FINDCRYPT_MATCH& Match)
+		{
+			if (Match.Type == FINDCRYPT_MATCH_ARRAY)
+				arrays.push_back(Match.Address);
+		}, nullptr);
+
+		return verify(arrays);
+	});
+
+	BenchRun(Context, "findcrypt/parallel", "FindcryptScanAll", corpus.Data.size(), [&corpus, &verify]()
+	{
+		std::vector<uint64_t> arrays;
+		std::vector<FINDCRYPT_RANGE> ranges = { { 0, corpus.Data.size() } };
+
+		auto read = [&corpus](uint64_t Address, uint8_t *Buffer, size_t Size)
+		{
+			memcpy(Buffer, &corpus.Data[(size_t)Address], Size);
+			return true;
+		};
+
+		FindcryptScanRanges(ranges, read, [&arrays](const FINDCRYPT_MATCH& Match)
+		{
+			if (Match.Type == FINDCRYPT_MATCH_ARRAY)
+				arrays.push_back(Match.Address);
+		}, nullptr);
+
+		return verify(arrays);
+	});
+}
+
+static void BenchAESFinder(BENCH_CONTEXT& Context)
+{
+	const BENCH_CORPUS& corpus = *Context.Corpus;
+
+	BenchRun(Context, "aes_finder/scan", "find_keys", corpus.Data.size(), [&corpus]()
+	{
+		std::vector<uint64_t> keys;
+
+		find_keys(corpus.Data.data(), corpus.Data.size(), 0, [&keys](uint64_t Address, bool Encryption, const uint8_t *Key, int Length)
+		{
+			if (Encryption)
+				keys.push_back(Address);
+		});
+
+		std::sort(keys.begin(), keys.end());
+
+		for (auto& plant : corpus.KeySchedules)
+		{
+			if (!std::binary_search(keys.begin(), keys.end(), plant.Offset))
+				return false;
+		}
+
+		return true;
+	});
+}
+
+static void BenchIDASig(BENCH_CONTEXT& Context)
+{
+	const BENCH_CORPUS& corpus = *Context.Corpus;
+	std::vector<uint8_t> file = BenchBuildFlirt(corpus);
+
+	IDASig signature;
+
+	if (!signature.Load(file.data(), file.size()))
+	{
+		fprintf(stderr, "Generated signature file failed to load: %s\n", signature.Error());
+		Context.Failures++;
+		return;
+	}
+
+	// Scanning uses up leaves, so every iteration works on a fresh copy (copied outside
+	// of the timing, which only covers IDASig::Scan)
+	std::vector<IDASig> copies(Context.Options->Iterations + 1, signature);
+	size_t next = 0;
+
+	BenchRun(Context, "flirt/scan", "MatchSignatureSymbol", corpus.Data.size(), [&]()
+	{
+		std::vector<size_t> matches;
+
+		copies[next++].Scan(corpus.Data.data(), corpus.Data.size(), [&matches](size_t Offset, const char *Name)
+		{
+			matches.push_back(Offset);
+		});
+
+		std::sort(matches.begin(), matches.end());
+
+		for (auto& plant : corpus.Strings)
+		{
+			if (!std::binary_search(matches.begin(), matches.end(), plant.Offset))
+				return false;
+		}
+
+		return true;
+	});
+}
+
+static void BenchCodecs(BENCH_CONTEXT& Context)
+{
+	const BENCH_CORPUS& corpus = *Context.Corpus;
+	BenchRandom random(Context.Options->Seed ^ 0xC0DE);
+
+	// 64-byte signatures taken from the code with a quarter of the bytes wildcarded
+	const size_t signatureCount		= 4096;
+	const size_t signatureLength	= 64;
+
+	std::vector<PackedDescriptor> signatures;
+
+	for (size_t i = 0; i < signatureCount; i++)
+	{
+		size_t offset = random.Next((uint32_t)(corpus.Data.size() - signatureLength));
+		uint8_t wildcards[signatureLength];
+
+		for (size_t j = 0; j < signatureLength; j++)
+			wildcards[j] = random.Next(4) == 0;
+
+		signatures.emplace_back(&corpus.Data[offset], wildcards, signatureLength);
+	}
+
+	std::vector<char> data(std::max(CodeDataTextSize(signatureLength), IDATextSize(signatureLength)));
+	std::vector<char> mask(CodeMaskTextSize(signatureLength));
+
+	// Encoded text for the decoders
+	std::vector<std::string> code, codeMasks, ida, peid, crc, crcMasks;
+
+	for (auto& signature : signatures)
+	{
+		PackedToCode(signature, data.data(), mask.data());
+		code.push_back(data.data());
+		codeMasks.push_back(mask.data());
+
+		PackedToIDA(signature, data.data());
+		ida.push_back(data.data());
+
+		PackedToPEiD(signature, data.data());
+		peid.push_back(data.data());
+
+		std::vector<char> crcData(CRCDataTextSize());
+		PackedToCRC(signature, crcData.data(), mask.data());
+		crc.push_back(crcData.data());
+		crcMasks.push_back(mask.data());
+	}
+
+	uint64_t bytes = signatureCount * signatureLength;
+
+	BenchRun(Context, "codec/encode_code", "PackedToCode", bytes, [&]()
+	{
+		for (auto& signature : signatures)
+			PackedToCode(signature, data.data(), mask.data());
+
+		return code.back() == data.data();
+	});
+
+	BenchRun(Context, "codec/encode_ida", "PackedToIDA", bytes, [&]()
+	{
+		for (auto& signature : signatures)
+			PackedToIDA(signature, data.data());
+
+		return ida.back() == data.data();
+	});
+
+	BenchRun(Context, "codec/encode_peid", "PackedToPEiD", bytes, [&]()
+	{
+		for (auto& signature : signatures)
+			PackedToPEiD(signature, data.data());
+
+		return peid.back() == data.data();
+	});
+
+	BenchRun(Context, "codec/decode_code", "PackedFromCode", bytes, [&]()
+	{
+		bool same = true;
+
+		for (size_t i = 0; i < signatureCount; i++)
+		{
+			PackedDescriptor decoded;
+			same = PackedFromCode(code[i].c_str(), codeMasks[i].c_str(), decoded) && decoded == signatures[i] && same;
+		}
+
+		return same;
+	});
+
+	BenchRun(Context, "codec/decode_ida", "PackedFromIDA", bytes, [&]()
+	{
+		bool same = true;
+
+		for (size_t i = 0; i < signatureCount; i++)
+		{
+			PackedDescriptor decoded;
+			same = PackedFromIDA(ida[i].c_str(), decoded) && decoded == signatures[i] && same;
+		}
+
+		return same;
+	});
+
+	BenchRun(Context, "codec/decode_peid", "PackedFromPEiD", bytes, [&]()
+	{
+		bool same = true;
+
+		for (size_t i = 0; i < signatureCount; i++)
+		{
+			PackedDescriptor decoded;
+			same = PackedFromPEiD(peid[i].c_str(), decoded) && decoded == signatures[i] && same;
+		}
+
+		return same;
+	});
+
+	BenchRun(Context, "codec/decode_crc", "PackedFromCRC", bytes, [&]()
+	{
+		bool same = true;
+
+		for (size_t i = 0; i < signatureCount; i++)
+		{
+			PackedDescriptor layout;
+			uint32_t checksum;
+
+			same = PackedFromCRC(crc[i].c_str(), crcMasks[i].c_str(), layout, checksum) && layout.Count() == signatureLength && same;
+		}
+
+		return same;
+	});
+}
+
+static void Usage()
+{
+	fprintf(stderr,
+		"Usage: sak-bench [options]\n"
+		"\n"
+		"  --size <MB>          Corpus size (default 16)\n"
+		"  --seed <number>      Corpus seed (default 1)\n"
+		"  --iterations <n>     Timed iterations per benchmark (default 5)\n"
+		"  --filter <text>      Only run benchmarks whose name contains text\n"
+		"  --label <text>       Stored in the first line, e.g. a commit id\n");
+}
+
+int main(int argc, char **argv)
+{
+	BENCH_OPTIONS options;
+	options.Size		= 16;
+	options.Seed		= 1;
+	options.Iterations	= 5;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		if (!value)
+		{
+			Usage();
+			return 2;
+		}
+
+		if (strcmp(argv[i], "--size") == 0)
+			options.Size = (size_t)strtoull(value, nullptr, 0);
+		else if (strcmp(argv[i], "--seed") == 0)
+			options.Seed = (uint32_t)strtoul(value, nullptr, 0);
+		else if (strcmp(argv[i], "--iterations") == 0)
+			options.Iterations = (uint32_t)strtoul(value, nullptr, 0);
+		else if (strcmp(argv[i], "--filter") == 0)
+			options.Filter = value;
+		else if (strcmp(argv[i], "--label") == 0)
+			options.Label = value;
+		else
+		{
+			Usage();
+			return 2;
+		}
+
+		i++;
+	}
+
+	if (options.Size == 0 || options.Iterations == 0)
+	{
+		Usage();
+		return 2;
+	}
+
+	BENCH_CORPUS corpus;
+	BenchBuildCorpus(options.Size * 1024 * 1024, options.Seed, corpus);
+
+	const char *levelNames[] = { "scalar", "sse2", "avx2" };
+
+	std::string output;
+	JsonLine header;
+	header.AddString("label", options.Label.c_str());
+	header.AddNumber("corpus_size", corpus.Data.size());
+	header.AddNumber("seed", options.Seed);
+	header.AddNumber("iterations", options.Iterations);
+	header.AddString("scan_level", levelNames[ScanGetBestLevel()]);
+	header.AddBool("crc_hardware", CrcHardwareSupported());
+	header.AddNumber("key_schedules", corpus.KeySchedules.size());
+	header.AddNumber("constants", corpus.Constants.size());
+	header.AddNumber("strings", corpus.Strings.size());
+	header.AddNumber("baseline_memory", BenchPeakMemory());
+	header.Finish(output);
+
+	fwrite(output.data(), 1, output.size(), stdout);
+
+	BENCH_CONTEXT context;
+	context.Options		= &options;
+	context.Corpus		= &corpus;
+	context.Failures	= 0;
+
+	BenchPatternScan(context);
+	BenchPEiD(context);
+	BenchFindcrypt(context);
+	BenchAESFinder(context);
+	BenchIDASig(context);
+	BenchCodecs(context);
+
+	return context.Failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "JsonLine.h"
+#include <stdio.h>
+
+JsonLine::JsonLine()
+{
+	m_Text = "{";
+}
+
+void JsonLine::AddKey(const char *Key)
+{
+	if (m_Text.size() > 1)
+		m_Text += ',';
+
+	m_Text += JsonQuote(Key);
+	m_Text += ':';
+}
+
+JsonLine& JsonLine::AddString(const char *Key, const char *Value)
+{
+	AddKey(Key);
+	m_Text += Value ? JsonQuote(Value) : "null";
+	return *this;
+}
+
+JsonLine& JsonLine::AddNumber(const char *Key, uint64_t Value)
+{
+	AddKey(Key);
+	m_Text += std::to_string(Value);
+	return *this;
+}
+
+JsonLine& JsonLine::AddDouble(const char *Key, double Value)
+{
+	// JSON has no infinity or NaN
+	if (Value != Value || Value > 1e300 || Value < -1e300)
+		return AddString(Key, nullptr);
+
+	char text[32];
+	snprintf(text, sizeof(text), "%.6g", Value);
+
+	AddKey(Key);
+	m_Text += text;
+	return *this;
+}
+
+JsonLine& JsonLine::AddBool(const char *Key, bool Value)
+{
+	AddKey(Key);
+	m_Text += Value ? "true" : "false";
+	return *this;
+}
+
+JsonLine& JsonLine::AddAddress(const char *Key, uint64_t Value)
+{
+	AddKey(Key);
+	m_Text += JsonAddress(Value);
+	return *this;
+}
+
+JsonLine& JsonLine::AddRaw(const char *Key, const std::string& Value)
+{
+	AddKey(Key);
+	m_Text += Value;
+	return *this;
+}
+
+void JsonLine::Finish(std::string& Output)
+{
+	Output += m_Text;
+	Output += "}\n";
+}
+
+std::string JsonQuote(const char *Value)
+{
+	std::string text = "\"";
+
+	for (const char *c = Value; *c; c++)
+	{
+		switch (*c)
+		{
+		case '"':	text += "\\\""; break;
+		case '\\':	text += "\\\\"; break;
+		case '\n':	text += "\\n"; break;
+		case '\r':	text += "\\r"; break;
+		case '\t':	text += "\\t"; break;
+
+		default:
+			// Names in signature databases aren't always UTF-8, so anything outside ASCII is
+			// read as Latin-1 to keep the output valid
+			if ((unsigned char)*c < 0x20 || (unsigned char)*c >= 0x80)
+			{
+				char escape[8];
+				snprintf(escape, sizeof(escape), "\\u%04x", (unsigned int)(unsigned char)*c);
+				text += escape;
+			}
+			else
+			{
+				text += *c;
+			}
+			break;
+		}
+	}
+
+	text += '"';
+	return text;
+}
+
+std::string JsonAddress(uint64_t Value)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "\"0x%llX\"", (unsigned long long)Value);
+	return text;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+//
+// Builds one JSON object per line (JSON Lines). Addresses are written as hex strings
+// so 64-bit values survive parsers that read every number as a double.
+//
+#include <stdint.h>
+#include <string>
+
+class JsonLine
+{
+public:
+	JsonLine();
+
+	JsonLine& AddString(const char *Key, const char *Value);
+	JsonLine& AddNumber(const char *Key, uint64_t Value);
+	JsonLine& AddDouble(const char *Key, double Value);
+	JsonLine& AddBool(const char *Key, bool Value);
+	JsonLine& AddAddress(const char *Key, uint64_t Value);
+
+	// Value must already be valid JSON (e.g. an array built with JsonQuote)
+	JsonLine& AddRaw(const char *Key, const std::string& Value);
+
+	// Closes the object and appends it, with a newline, to Output
+	void Finish(std::string& Output);
+
+private:
+	void AddKey(const char *Key);
+
+	std::string m_Text;
+};
+
+// Quoted and escaped JSON string
+std::string JsonQuote(const char *Value);
+std::string JsonAddress(uint64_t Value);
\ No newline at end of file
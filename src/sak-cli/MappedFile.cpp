@@ -0,0 +1,98 @@
+#include "MappedFile.h"
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+MappedFile::MappedFile()
+{
+	m_Data		= nullptr;
+	m_Size		= 0;
+	m_Mapped	= false;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const char *Path)
+{
+	Close();
+
+#ifndef _WIN32
+	int descriptor = open(Path, O_RDONLY);
+
+	if (descriptor == -1)
+		return false;
+
+	struct stat info;
+
+	if (fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+	{
+		void *view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+		if (view != MAP_FAILED)
+		{
+			m_Data		= (const uint8_t *)view;
+			m_Size		= (size_t)info.st_size;
+			m_Mapped	= true;
+		}
+	}
+
+	// The mapping stays valid without the descriptor
+	close(descriptor);
+
+	if (m_Mapped)
+		return true;
+#endif // _WIN32
+
+	// Empty files, pipes and platforms without mmap
+	FILE *file = nullptr;
+
+#ifdef _MSC_VER
+	fopen_s(&file, Path, "rb");
+#else
+	file = fopen(Path, "rb");
+#endif // _MSC_VER
+
+	if (!file)
+		return false;
+
+	uint8_t buf[65536];
+
+	for (size_t count; (count = fread(buf, 1, sizeof(buf), file)) > 0;)
+		m_Buffer.insert(m_Buffer.end(), buf, buf + count);
+
+	bool failed = ferror(file) != 0;
+	fclose(file);
+
+	if (failed)
+	{
+		m_Buffer.clear();
+		return false;
+	}
+
+	m_Data = m_Buffer.data();
+	m_Size = m_Buffer.size();
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifndef _WIN32
+	if (m_Mapped)
+		munmap((void *)m_Data, m_Size);
+#endif // _WIN32
+
+	m_Buffer.clear();
+	m_Buffer.shrink_to_fit();
+
+	m_Data		= nullptr;
+	m_Size		= 0;
+	m_Mapped	= false;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+//
+// Read-only view of a whole file: memory mapped where the platform allows it, read
+// into a buffer otherwise.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char *Path);
+	void Close();
+
+	const uint8_t *Data() const
+	{
+		return m_Data;
+	}
+
+	size_t Size() const
+	{
+		return m_Size;
+	}
+
+private:
+	const uint8_t *m_Data;
+	size_t m_Size;
+	bool m_Mapped;
+
+	std::vector<uint8_t> m_Buffer;
+};
\ No newline at end of file
@@ -0,0 +1,800 @@
+//
+// sak-cli: the SwissArmyKnife scanners on files instead of a debugged process. Every
+// input is either a PE image (mapped by its section table at its preferred base) or
+// a raw dump (scanned as-is at --base). Results are written as JSON Lines in the order
+// the inputs were given, while the inputs themselves are scanned in parallel.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "MappedFile.h"
+#include "JsonLine.h"
+#include "../sigmake/TextPattern.h"
+#include "../sigmake/BatchSig.h"
+#include "../sigmake/PEImage.h"
+#include "../sigmake/MultiBuild.h"
+#include "../sigmake/MemoryIndex.h"
+#include "../sigmake/CodeStream.h"
+#include "../sigmake/MemoryStream.h"
+#include "../sigmake/SigDatabase.h"
+#include "../findcrypt/findcrypt-core.h"
+#include "../findcrypt/findcrypt-db.h"
+#include "../aes-finder/aes-finder-keys.h"
+#include "../peid/peid-db.h"
+#include "../idaldr/IDA/Sig.h"
+
+struct CLI_OPTIONS
+{
+	std::string Command;
+	std::vector<std::string> Files;
+
+	// Inputs
+	uint64_t Base;			// Load address of raw dumps
+	bool Raw;				// Never parse inputs as PE images
+	bool Is64;				// Instruction set of raw dumps
+	uint32_t Jobs;
+
+	// scan
+	std::string Pattern;
+	std::string Mask;
+	uint64_t MaxResults;
+
+	// peid, idasig and findcrypt
+	std::string Database;
+
+	// sigbuilds
+	uint64_t Address;
+	bool HasAddress;
+	uint32_t MinLength;
+	uint32_t MaxLength;
+	bool Shortest;
+	bool NoTrim;
+	bool NoWildcards;
+
+	// sigexport and fcdb
+	std::string Output;
+};
+
+struct CLI_INPUT
+{
+	const char *Path;
+	const char *Format;		// "pe" or "raw"
+	uint64_t Base;
+	const uint8_t *Data;
+	size_t Size;
+
+	MappedFile File;
+	PEImage Image;
+};
+
+// Appends the result lines for one input; returns false (with Error set) if the input couldn't be scanned
+typedef std::function<bool(CLI_INPUT& Input, std::string& Output, uint64_t& Matches, std::string& Error)> CliCommand;
+
+static void Usage()
+{
+	fprintf(stderr,
+		"Usage: sak-cli <command> [options] <files...>\n"
+		"\n"
+		"Commands:\n"
+		"  scan --pattern <text> [--mask <mask>]   Find a Code, IDA, PEiD or CRC signature\n"
+		"  findcrypt [--db <file.fcdb>]            Find crypto constants and AES-NI instructions\n"
+		"  aesfind                                 Find AES key schedules\n"
+		"  peid --db <userdb.txt>                  Scan with a PEiD signature database\n"
+		"  idasig --sig <file.sig>                 Scan with an IDA FLIRT signature file\n"
+		"  sigbuilds --address <va> <reference> <builds...>\n"
+		"                                          Make a signature unique in every build\n"
+		"  sigexport --out <file.sdb> <image>      Write a signature for every function\n"
+		"  fcdb --out <file.fcdb> <sources...>     Compile Findcrypt constants (.cpp, .yaml)\n"
+		"  selftest                                Run the built-in self tests\n"
+		"\n"
+		"Options:\n"
+		"  --raw              Treat every input as a raw dump, even if it looks like a PE\n"
+		"  --base <address>   Address of the first byte of raw dumps (default 0)\n"
+		"  --32               Decode raw dumps as 32-bit code (sigbuilds)\n"
+		"  --jobs <count>     Inputs scanned at once (default: one per core)\n"
+		"  --max-results <n>  Matches reported per input (scan, default 10000)\n"
+		"  --min <bytes>      Minimum signature length (sigbuilds, sigexport, default 10)\n"
+		"  --max <bytes>      Maximum signature length (sigbuilds, sigexport, default 50)\n"
+		"  --shortest         Cut signatures down to the shortest unique prefix\n"
+		"  --no-trim          Keep trailing wildcards\n"
+		"  --no-wildcards     Keep every instruction byte\n");
+}
+
+static bool ParseNumber(const char *Text, uint64_t& Value)
+{
+	char *end = nullptr;
+	Value = strtoull(Text, &end, 0);
+
+	return end != Text && *end == '\0';
+}
+
+static bool ParseOptions(int argc, char **argv, CLI_OPTIONS& Options)
+{
+	Options.Base		= 0;
+	Options.Raw			= false;
+	Options.Is64		= true;
+	Options.Jobs		= 0;
+	Options.MaxResults	= 10000;
+	Options.Address		= 0;
+	Options.HasAddress	= false;
+	Options.MinLength	= 10;
+	Options.MaxLength	= 50;
+	Options.Shortest	= false;
+	Options.NoTrim		= false;
+	Options.NoWildcards	= false;
+
+	if (argc < 2)
+		return false;
+
+	Options.Command = argv[1];
+
+	for (int i = 2; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		uint64_t number;
+
+		auto takeNumber = [&](uint64_t& Target)
+		{
+			if (!value || !ParseNumber(value, number))
+			{
+				fprintf(stderr, "Expected a number after %s\n", arg);
+				return false;
+			}
+
+			Target = number;
+			i++;
+			return true;
+		};
+
+		auto takeString = [&](std::string& Target)
+		{
+			if (!value)
+			{
+				fprintf(stderr, "Expected a value after %s\n", arg);
+				return false;
+			}
+
+			Target = value;
+			i++;
+			return true;
+		};
+
+		uint64_t temp;
+		bool ok = true;
+
+		if (strcmp(arg, "--raw") == 0)
+			Options.Raw = true;
+		else if (strcmp(arg, "--32") == 0)
+			Options.Is64 = false;
+		else if (strcmp(arg, "--shortest") == 0)
+			Options.Shortest = true;
+		else if (strcmp(arg, "--no-trim") == 0)
+			Options.NoTrim = true;
+		else if (strcmp(arg, "--no-wildcards") == 0)
+			Options.NoWildcards = true;
+		else if (strcmp(arg, "--base") == 0)
+			ok = takeNumber(Options.Base);
+		else if (strcmp(arg, "--max-results") == 0)
+			ok = takeNumber(Options.MaxResults);
+		else if (strcmp(arg, "--pattern") == 0)
+			ok = takeString(Options.Pattern);
+		else if (strcmp(arg, "--mask") == 0)
+			ok = takeString(Options.Mask);
+		else if (strcmp(arg, "--db") == 0 || strcmp(arg, "--sig") == 0)
+			ok = takeString(Options.Database);
+		else if (strcmp(arg, "--out") == 0)
+			ok = takeString(Options.Output);
+		else if (strcmp(arg, "--address") == 0)
+			ok = (Options.HasAddress = takeNumber(Options.Address));
+		else if (strcmp(arg, "--jobs") == 0)
+			ok = takeNumber(temp) && (Options.Jobs = (uint32_t)temp, true);
+		else if (strcmp(arg, "--min") == 0)
+			ok = takeNumber(temp) && (Options.MinLength = (uint32_t)temp, true);
+		else if (strcmp(arg, "--max") == 0)
+			ok = takeNumber(temp) && (Options.MaxLength = (uint32_t)temp, true);
+		else if (arg[0] == '-' && arg[1] == '-')
+		{
+			fprintf(stderr, "Unknown option %s\n", arg);
+			ok = false;
+		}
+		else
+			Options.Files.push_back(arg);
+
+		if (!ok)
+			return false;
+	}
+
+	return true;
+}
+
+static bool LoadInput(const CLI_OPTIONS& Options, CLI_INPUT& Input, std::string& Error)
+{
+	if (!Input.File.Open(Input.Path))
+	{
+		Error = "Unable to open file";
+		return false;
+	}
+
+	// PE images are scanned as the loader would map them
+	if (!Options.Raw && Input.Image.Load(Input.File.Data(), Input.File.Size()))
+	{
+		Input.Format	= "pe";
+		Input.Base		= Input.Image.Base();
+		Input.Data		= Input.Image.Data();
+		Input.Size		= Input.Image.Size();
+
+		Input.File.Close();
+		return true;
+	}
+
+	Input.Format	= "raw";
+	Input.Base		= Options.Base;
+	Input.Data		= Input.File.Data();
+	Input.Size		= Input.File.Size();
+	return true;
+}
+
+static void AddInput(JsonLine& Line, const CLI_OPTIONS& Options, const CLI_INPUT& Input)
+{
+	Line.AddString("file", Input.Path);
+	Line.AddString("command", Options.Command.c_str());
+}
+
+//
+// Scans every input with Command on a pool of threads and prints the output of each
+// input in order as soon as it and everything before it is done. Returns 1 if any
+// input failed.
+//
+static int RunFiles(const CLI_OPTIONS& Options, const CliCommand& Command)
+{
+	size_t fileCount = Options.Files.size();
+
+	std::vector<std::string> outputs(fileCount);
+	std::vector<bool> finished(fileCount, false);
+	std::mutex lock;
+	std::condition_variable finishedEvent;
+
+	std::atomic<size_t> nextFile(0);
+	std::atomic<int> failures(0);
+
+	auto worker = [&]()
+	{
+		for (size_t i; (i = nextFile.fetch_add(1)) < fileCount;)
+		{
+			std::unique_ptr<CLI_INPUT> input(new CLI_INPUT());
+			input->Path = Options.Files[i].c_str();
+
+			std::string output;
+			std::string error;
+			uint64_t matches = 0;
+
+			bool ok = LoadInput(Options, *input, error) && Command(*input, output, matches, error);
+
+			JsonLine summary;
+			AddInput(summary, Options, *input);
+
+			if (ok)
+			{
+				summary.AddBool("summary", true);
+				summary.AddString("format", input->Format);
+				summary.AddAddress("base", input->Base);
+				summary.AddNumber("size", input->Size);
+				summary.AddNumber("matches", matches);
+			}
+			else
+			{
+				summary.AddString("error", error.c_str());
+				failures++;
+			}
+
+			summary.Finish(output);
+
+			std::lock_guard<std::mutex> guard(lock);
+			outputs[i]	= std::move(output);
+			finished[i]	= true;
+			finishedEvent.notify_one();
+		}
+	};
+
+	size_t threadCount = Options.Jobs ? Options.Jobs : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	threadCount = std::max<size_t>(std::min(threadCount, fileCount), 1);
+
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < threadCount; i++)
+		threads.emplace_back(worker);
+
+	for (size_t i = 0; i < fileCount; i++)
+	{
+		std::string output;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			finishedEvent.wait(guard, [&]() { return finished[i]; });
+			output.swap(outputs[i]);
+		}
+
+		fwrite(output.data(), 1, output.size(), stdout);
+		fflush(stdout);
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	return (failures > 0) ? 1 : 0;
+}
+
+static int CommandScan(const CLI_OPTIONS& Options)
+{
+	TextScanFunction scan = TextPatternCompile(Options.Pattern.c_str(), Options.Mask.empty() ? nullptr : Options.Mask.c_str(), (size_t)Options.MaxResults);
+
+	if (!scan)
+	{
+		fprintf(stderr, "Invalid signature\n");
+		return 2;
+	}
+
+	return RunFiles(Options, [&](CLI_INPUT& Input, std::string& Output, uint64_t& Matches, std::string& Error)
+	{
+		std::vector<size_t> offsets;
+		scan(Input.Data, Input.Size, offsets);
+
+		for (size_t offset : offsets)
+		{
+			JsonLine line;
+			AddInput(line, Options, Input);
+			line.AddAddress("address", Input.Base + offset);
+			line.Finish(Output);
+		}
+
+		Matches = offsets.size();
+		return true;
+	});
+}
+
+static int CommandFindcrypt(const CLI_OPTIONS& Options)
+{
+	FindcryptMatcherPtr matcher = FindcryptGetMatcher();
+
+	// The file stays mapped for as long as the tables pointing into it
+	if (!Options.Database.empty())
+	{
+		std::shared_ptr<MappedFile> file(new MappedFile());
+
+		if (!file->Open(Options.Database.c_str()))
+		{
+			fprintf(stderr, "%s: Unable to open file\n", Options.Database.c_str());
+			return 2;
+		}
+
+		matcher = FindcryptLoadDatabase(file->Data(), file->Size(), file);
+
+		if (!matcher)
+		{
+			fprintf(stderr, "%s: Not a Findcrypt database of this version\n", Options.Database.c_str());
+			return 2;
+		}
+	}
+
+	return RunFiles(Options, [&](CLI_INPUT& Input, std::string& Output, uint64_t& Matches, std::string& Error)
+	{
+		FindcryptScanBuffer(*matcher, Input.Data, Input.Size, Input.Base, [&](const FINDCRYPT_MATCH& Match)
+		{
+			static const char *kinds[] = { "array", "sparse", "aesni" };
+
+			JsonLine line;
+			AddInput(line, Options, Input);
+			line.AddAddress("address", Match.Address);
+			line.AddString("kind", kinds[Match.Type]);
+			line.AddString("name", Match.Name);
+
+			if (Match.Algorithm)
+				line.AddString("algorithm", Match.Algorithm);
+
+			line.Finish(Output);
+			Matches++;
+		}, nullptr);
+
+		return true;
+	});
+}
+
+static int CommandAESFind(const CLI_OPTIONS& Options)
+{
+	return RunFiles(Options, [&](CLI_INPUT& Input, std::string& Output, uint64_t& Matches, std::string& Error)
+	{
+		find_keys(Input.Data, Input.Size, Input.Base, [&](uint64_t Address, bool Encryption, const uint8_t *Key, int Length)
+		{
+			char key[65];
+
+			for (int i = 0; i < Length; i++)
+				snprintf(&key[i * 2], 3, "%02x", Key[i]);
+
+			JsonLine line;
+			AddInput(line, Options, Input);
+			line.AddAddress("address", Address);
+			line.AddString("kind", Encryption ? "encryption" : "decryption");
+			line.AddNumber("bits", Length * 8);
+			line.AddString("key", key);
+			line.Finish(Output);
+			Matches++;
+		});
+
+		return true;
+	});
+}
+
+static int CommandPEiD(const CLI_OPTIONS& Options)
+{
+	if (Options.Database.empty())
+	{
+		fprintf(stderr, "peid needs --db\n");
+		return 2;
+	}
+
+	// Parsed and compiled once for every input
+	PEID_DATABASE database;
+
+	if (!PEiDLoadDatabase(Options.Database.c_str(), database))
+	{
+		fprintf(stderr, "%s: Unable to open the PEiD database\n", Options.Database.c_str());
+		return 2;
+	}
+
+	return RunFiles(Options, [&](CLI_INPUT& Input, std::string& Output, uint64_t& Matches, std::string& Error)
+	{
+		PEID_SCAN_STATS stats;
+
+		PEiDScanDatabase(database, Input.Data, Input.Base, Input.Size, [&](uint64_t Address, const char *Name)
+		{
+			JsonLine line;
+			AddInput(line, Options, Input);
+			line.AddAddress("address", Address);
+			line.AddString("name", Name);
+			line.Finish(Output);
+		}, stats);
+
+		Matches = stats.Matched;
+		return true;
+	});
+}
+
+static int CommandIDASig(const CLI_OPTIONS& Options)
+{
+	if (Options.Database.empty())
+	{
+		fprintf(stderr, "idasig needs --sig\n");
+		return 2;
+	}
+
+	// Scanning uses up leaves, so every input gets its own copy of the tree
+	IDASig signature;
+
+	if (!signature.Load(Options.Database.c_str()))
+	{
+		fprintf(stderr, "%s: %s\n", Options.Database.c_str(), signature.Error());
+		return 2;
+	}
+
+	return RunFiles(Options, [&](CLI_INPUT& Input, std::string& Output, uint64_t& Matches, std::string& Error)
+	{
+		IDASig copy(signature);
+
+		Matches = copy.Scan(Input.Data, Input.Size, [&](size_t Offset, const char *Name)
+		{
+			JsonLine line;
+			AddInput(line, Options, Input);
+			line.AddAddress("address", Input.Base + Offset);
+			line.AddString("name", Name);
+			line.Finish(Output);
+		});
+
+		return true;
+	});
+}
+
+static bool LoadBuild(const CLI_OPTIONS& Options, const char *Path, PEImage& Image)
+{
+	MappedFile file;
+
+	if (!file.Open(Path))
+		return false;
+
+	if (!Options.Raw && Image.Load(file.Data(), file.Size()))
+		return true;
+
+	Image.LoadMapped(file.Data(), file.Size(), Options.Base, Options.Is64);
+	return file.Size() > 0;
+}
+
+static int CommandSigBuilds(const CLI_OPTIONS& Options)
+{
+	if (!Options.HasAddress || Options.Files.size() < 2)
+	{
+		fprintf(stderr, "sigbuilds needs --address, a reference and at least one other build\n");
+		return 2;
+	}
+
+	// Every build (and the reference) is loaded up front since all of them are scanned together
+	std::vector<PEImage> images(Options.Files.size());
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		if (!LoadBuild(Options, Options.Files[i].c_str(), images[i]))
+		{
+			fprintf(stderr, "%s: Unable to open file\n", Options.Files[i].c_str());
+			return 1;
+		}
+	}
+
+	PEImage reference = std::move(images[0]);
+	images.erase(images.begin());
+
+	MULTI_BUILD_OPTIONS options;
+	options.MinLength	= Options.MinLength;
+	options.MaxLength	= Options.MaxLength;
+	options.Trim		= !Options.NoTrim;
+	options.Shorten		= Options.Shortest;
+
+	if (!Options.NoWildcards)
+		options.Filter = BatchSigRelocationFilter;
+
+	MULTI_BUILD_RESULT result;
+	bool found = MultiBuildGenerate(reference, Options.Address, images, options, result);
+
+	JsonLine line;
+	line.AddString("file", Options.Files[0].c_str());
+	line.AddString("command", Options.Command.c_str());
+	line.AddAddress("address", Options.Address);
+	line.AddBool("found", found);
+
+	// Where the target was found in each build
+	std::string locations = "[";
+
+	for (size_t i = 0; i < result.Locations.size(); i++)
+	{
+		locations += (i > 0) ? ",{\"file\":" : "{\"file\":";
+		locations += JsonQuote(Options.Files[i + 1].c_str());
+		locations += ",\"address\":";
+		locations += result.Locations[i] ? JsonAddress(result.Locations[i]) : "null";
+		locations += "}";
+	}
+
+	line.AddRaw("builds", locations + "]");
+
+	if (found)
+	{
+		size_t count = result.Signature.Count();
+		std::vector<char> data(std::max(CodeDataTextSize(count), IDATextSize(count)));
+		std::vector<char> mask(CodeMaskTextSize(count));
+
+		PackedToCode(result.Signature, data.data(), mask.data());
+		line.AddString("code", data.data());
+		line.AddString("mask", mask.data());
+
+		PackedToIDA(result.Signature, data.data());
+		line.AddString("ida", data.data());
+
+		PackedToPEiD(result.Signature, data.data());
+		line.AddString("peid", data.data());
+	}
+
+	std::string output;
+	line.Finish(output);
+	fwrite(output.data(), 1, output.size(), stdout);
+
+	return found ? 0 : 1;
+}
+
+static int CommandSigExport(const CLI_OPTIONS& Options)
+{
+	if (Options.Output.empty() || Options.Files.size() != 1)
+	{
+		fprintf(stderr, "sigexport needs --out and exactly one image\n");
+		return 2;
+	}
+
+	PEImage image;
+
+	if (!LoadBuild(Options, Options.Files[0].c_str(), image))
+	{
+		fprintf(stderr, "%s: Unable to open file\n", Options.Files[0].c_str());
+		return 1;
+	}
+
+	BATCH_SIG_OPTIONS options;
+	options.MinLength		= Options.MinLength;
+	options.MaxLength		= Options.MaxLength;
+	options.Trim			= !Options.NoTrim;
+	options.Shorten			= Options.Shortest;
+	options.SearchWindow	= 0;
+
+	if (!Options.NoWildcards)
+		options.Filters.push_back(BatchSigRelocationFilter);
+
+	SIG_DATABASE database;
+	size_t failed = 0;
+	SigDatabaseGenerate(image, options, database, &failed);
+
+	bool saved = SigDatabaseSave(Options.Output.c_str(), database);
+
+	JsonLine line;
+	line.AddString("file", Options.Files[0].c_str());
+	line.AddString("command", Options.Command.c_str());
+	line.AddString("output", Options.Output.c_str());
+	line.AddNumber("functions", database.Entries.size() + failed);
+	line.AddNumber("signatures", database.Entries.size());
+	line.AddNumber("failed", failed);
+
+	if (!saved)
+		line.AddString("error", "Unable to write the database");
+
+	std::string output;
+	line.Finish(output);
+	fwrite(output.data(), 1, output.size(), stdout);
+
+	return saved ? 0 : 1;
+}
+
+static int CommandFindcryptDatabase(const CLI_OPTIONS& Options)
+{
+	if (Options.Output.empty())
+	{
+		fprintf(stderr, "fcdb needs --out\n");
+		return 2;
+	}
+
+	std::vector<FINDCRYPT_CONSTANT> constants;
+	std::string error;
+
+	for (auto& path : Options.Files)
+	{
+		MappedFile file;
+
+		if (!file.Open(path.c_str()))
+		{
+			fprintf(stderr, "%s: Unable to open file\n", path.c_str());
+			return 1;
+		}
+
+		// YAML lists by extension, everything else is read as C++
+		size_t dot = path.find_last_of('.');
+		std::string extension = (dot != std::string::npos) ? path.substr(dot) : "";
+		bool yaml = extension == ".yaml" || extension == ".yml";
+
+		const char *text = (const char *)file.Data();
+		bool parsed = yaml ? FindcryptParseYaml(text, file.Size(), constants, error) : FindcryptParseCpp(text, file.Size(), constants, error);
+
+		if (!parsed)
+		{
+			fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<uint8_t> database;
+
+	if (!FindcryptCompileDatabase(constants, database, error))
+	{
+		fprintf(stderr, "%s: %s\n", Options.Output.c_str(), error.c_str());
+		return 1;
+	}
+
+	FILE *output = fopen(Options.Output.c_str(), "wb");
+	bool saved = output && fwrite(database.data(), 1, database.size(), output) == database.size();
+
+	if (output && fclose(output) != 0)
+		saved = false;
+
+	JsonLine line;
+	line.AddString("file", Options.Output.c_str());
+	line.AddString("command", Options.Command.c_str());
+	line.AddNumber("sources", Options.Files.size());
+	line.AddNumber("constants", constants.size());
+	line.AddNumber("size", database.size());
+
+	if (!saved)
+		line.AddString("error", "Unable to write the database");
+
+	std::string text;
+	line.Finish(text);
+	fwrite(text.data(), 1, text.size(), stdout);
+
+	return saved ? 0 : 1;
+}
+
+static int CommandSelfTest()
+{
+	struct
+	{
+		const char *Name;
+		bool (*Run)();
+	} tests[] =
+	{
+		{ "PatternScan", PatternScanSelfTest },
+		{ "BatchSig", BatchSigSelfTest },
+		{ "CrcPattern", CrcPatternSelfTest },
+		{ "DescriptorText", DescriptorTextSelfTest },
+		{ "PEImage", PEImageSelfTest },
+		{ "MultiBuild", MultiBuildSelfTest },
+		{ "MemoryIndex", MemoryIndexSelfTest },
+		{ "CodeStream", CodeStreamSelfTest },
+		{ "MemoryStream", MemoryStreamSelfTest },
+		{ "SigDatabase", SigDatabaseSelfTest },
+		{ "AESFinder", aes_finder_self_test },
+		{ "Findcrypt", FindcryptSelfTest },
+		{ "FindcryptDatabase", FindcryptDatabaseSelfTest },
+		{ "FindcryptConstants", []() { return !FindcryptFindDuplicate(non_sparse_consts) && !FindcryptFindDuplicate(sparse_consts); } },
+	};
+
+	int failures = 0;
+
+	for (auto& test : tests)
+	{
+		bool passed = test.Run();
+
+		std::string output;
+		JsonLine line;
+		line.AddString("command", "selftest");
+		line.AddString("test", test.Name);
+		line.AddBool("passed", passed);
+		line.Finish(output);
+
+		fwrite(output.data(), 1, output.size(), stdout);
+
+		if (!passed)
+			failures++;
+	}
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	CLI_OPTIONS options;
+
+	if (!ParseOptions(argc, argv, options))
+	{
+		Usage();
+		return 2;
+	}
+
+	if (options.Command == "selftest")
+		return CommandSelfTest() ? 1 : 0;
+
+	if (options.Files.empty())
+	{
+		Usage();
+		return 2;
+	}
+
+	// 0 = success, 1 = an input failed, 2 = bad arguments
+	if (options.Command == "scan")
+		return CommandScan(options);
+	else if (options.Command == "findcrypt")
+		return CommandFindcrypt(options);
+	else if (options.Command == "aesfind")
+		return CommandAESFind(options);
+	else if (options.Command == "peid")
+		return CommandPEiD(options);
+	else if (options.Command == "idasig")
+		return CommandIDASig(options);
+	else if (options.Command == "sigbuilds")
+		return CommandSigBuilds(options);
+	else if (options.Command == "sigexport")
+		return CommandSigExport(options);
+	else if (options.Command == "fcdb")
+		return CommandFindcryptDatabase(options);
+
+	Usage();
+	return 2;
+}
\ No newline at end of file
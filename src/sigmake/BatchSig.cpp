@@ -0,0 +1,281 @@
+#include "BatchSig.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Longest possible x86 instruction
+const uint32_t BatchSigInstructionMax	= 15;
+
+// Uniqueness checks stop tracking matches past this and rescan instead
+const size_t BatchSigCandidateLimit		= 4096;
+
+struct BATCH_SIG_CANDIDATE
+{
+	uint64_t Start;
+	size_t Filter;
+
+	bool Found;
+	size_t Length;	// Before trimming
+	PackedDescriptor Signature;
+};
+
+void BatchSigWildcardFields(const _DInst *Instruction, bool Displacement, bool Immediate, uint8_t *Wildcards)
+{
+	// The offsets come from the same decode, but stay within the instruction regardless
+	auto wildcard = [&](int Offset, int Size)
+	{
+		for (int i = Offset; i < Offset + Size && i < Instruction->size; i++)
+			Wildcards[i] = 1;
+	};
+
+	if (Displacement && Instruction->dispOffset != 0)
+		wildcard(Instruction->dispOffset, Instruction->dispSize / 8);
+
+	if (Immediate && Instruction->immOffset != 0)
+		wildcard(Instruction->immOffset, Instruction->immSize);
+}
+
+void BatchSigRelocationFilter(_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards)
+{
+	if (Instruction->flags == FLAG_NOT_DECODABLE)
+		return;
+
+	// immSize also covers branch offsets and far pointers, and is the encoded size (sign-extended
+	// immediates are reported at the size they extend to)
+	BatchSigWildcardFields(Instruction, Instruction->dispSize >= 32, Instruction->immSize >= 4, Wildcards);
+}
+
+static void BatchSigParallel(size_t Count, const std::function<void(size_t Index, std::vector<_DInst>& Instructions)>& Work)
+{
+	// Every worker owns its decode buffer
+	std::atomic<size_t> nextIndex(0);
+
+	auto worker = [&]()
+	{
+		std::vector<_DInst> instructions;
+
+		for (size_t i; (i = nextIndex.fetch_add(1)) < Count;)
+			Work(i, instructions);
+	};
+
+	size_t threadCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), Count);
+
+	if (threadCount <= 1)
+	{
+		worker();
+		return;
+	}
+
+	std::vector<std::thread> threads;
+
+	for (size_t i = 0; i < threadCount; i++)
+		threads.emplace_back(worker);
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+static bool BatchSigGrow(const BATCH_SIG_MODULE& Module, const BATCH_SIG_OPTIONS& Options, uint64_t Target, std::atomic<size_t>& BestLength, std::vector<_DInst>& Instructions, BATCH_SIG_CANDIDATE& Candidate)
+{
+	const BatchSigFilter *filter = Options.Filters.empty() ? nullptr : &Options.Filters[Candidate.Filter];
+
+	Candidate.Found		= false;
+	Candidate.Signature	= PackedDescriptor();
+
+	// Decode everything a signature could ever use in one go
+	size_t offset		= (size_t)(Candidate.Start - Module.Base);
+	size_t lead			= (size_t)(Target - Candidate.Start);
+	size_t codeSize		= std::min<size_t>(Module.Size - offset, lead + Options.MaxLength + BatchSigInstructionMax);
+	unsigned int count	= 0;
+
+	Instructions.resize(codeSize);
+
+	_CodeInfo info;
+	memset(&info, 0, sizeof(_CodeInfo));
+
+	info.codeOffset	= (_OffsetType)Candidate.Start;
+	info.code		= Module.Data + offset;
+	info.codeLen	= (int)codeSize;
+	info.dt			= Module.Type;
+	info.features	= DF_NONE;
+
+	if (distorm_decompose(&info, Instructions.data(), (unsigned int)Instructions.size(), &count) == DECRES_INPUTERR)
+		return false;
+
+	// Earlier starts only count when their instruction stream lands on the target
+	size_t boundary = 0;
+
+	for (unsigned int i = 0; i < count && boundary < lead; i++)
+		boundary += std::max<int>(Instructions[i].size, 1);
+
+	if (boundary != lead)
+		return false;
+
+	// Signatures only grow by whole instructions, so each pattern refines the previous
+	// one and only the previous matches have to be checked again
+	ScanCandidates candidates(Module.Data, Module.Size, BatchSigCandidateLimit, false);
+
+	PackedDescriptor& signature	= Candidate.Signature;
+	size_t ambiguousLength		= 0;
+	unsigned int next			= 0;
+
+	while (signature.Count() < Options.MaxLength)
+	{
+		// Gather some instructions to meet the minimum length, then one at a time
+		do
+		{
+			if (next >= count)
+				return false;
+
+			_DInst *instruction	= &Instructions[next++];
+			const uint8_t *data	= Module.Data + offset + signature.Count();
+
+			// Default to 1 byte on failure
+			int size = std::max<int>(instruction->size, 1);
+			uint8_t wildcards[BatchSigInstructionMax] = {};
+
+			if (filter)
+				(*filter)(instruction, data, wildcards);
+
+			for (int i = 0; i < size; i++)
+				signature.Append(data[i], wildcards[i] != 0);
+		} while (signature.Count() < Options.MinLength);
+
+		ScanPattern pattern(signature);
+		size_t matchCount = candidates.Update(pattern);
+
+		// The start itself has to match, so zero would mean a broken filter
+		if (matchCount == 0)
+			return false;
+
+		if (matchCount > 1)
+		{
+			// Whatever this ends up as is longer than a signature somebody already found
+			ambiguousLength = signature.Count();
+
+			if (ambiguousLength >= BestLength.load())
+				return false;
+
+			continue;
+		}
+
+		// Anything longer than the last ambiguous prefix still refines it
+		if (Options.Shorten)
+		{
+			size_t low	= ambiguousLength + 1;
+			size_t high	= signature.Count();
+
+			while (low < high)
+			{
+				size_t mid = low + (high - low) / 2;
+
+				pattern.Resize(mid);
+
+				if (candidates.Update(pattern) > 1)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+
+			signature.Resize(high);
+		}
+
+		Candidate.Length = signature.Count();
+
+		if (Options.Trim)
+			signature.Trim();
+
+		// Lower the bar for every other candidate
+		for (size_t best = BestLength.load(); Candidate.Length < best && !BestLength.compare_exchange_weak(best, Candidate.Length);)
+			;
+
+		Candidate.Found = true;
+		return true;
+	}
+
+	return false;
+}
+
+static bool BatchSigSearch(const BATCH_SIG_MODULE& Module, const BATCH_SIG_OPTIONS& Options, BATCH_SIG_RESULT& Result, std::vector<_DInst> *Instructions)
+{
+	Result.Found		= false;
+	Result.TargetOffset	= 0;
+	Result.Signature	= PackedDescriptor();
+
+	if (Result.Address < Module.Base || Result.Address >= (Module.Base + Module.Size))
+		return false;
+
+	// Closest start first, each with every filter
+	std::vector<BATCH_SIG_CANDIDATE> candidates;
+	uint64_t window = std::min<uint64_t>(Options.SearchWindow, Result.Address - Module.Base);
+
+	for (uint64_t lead = 0; lead <= window; lead++)
+	{
+		for (size_t filter = 0; filter < std::max<size_t>(Options.Filters.size(), 1); filter++)
+		{
+			BATCH_SIG_CANDIDATE candidate;
+			candidate.Start		= Result.Address - lead;
+			candidate.Filter	= filter;
+			candidate.Found		= false;
+			candidate.Length	= 0;
+
+			candidates.push_back(candidate);
+		}
+	}
+
+	std::atomic<size_t> bestLength(SIZE_MAX);
+
+	// Callers that already run on a worker pass in its decode buffer
+	if (Instructions)
+	{
+		for (auto& candidate : candidates)
+			BatchSigGrow(Module, Options, Result.Address, bestLength, *Instructions, candidate);
+	}
+	else
+	{
+		BatchSigParallel(candidates.size(), [&](size_t Index, std::vector<_DInst>& Instructions)
+		{
+			BatchSigGrow(Module, Options, Result.Address, bestLength, Instructions, candidates[Index]);
+		});
+	}
+
+	// Candidates are in order of preference; only a strictly shorter one replaces the pick
+	BATCH_SIG_CANDIDATE *best = nullptr;
+
+	for (auto& candidate : candidates)
+	{
+		if (candidate.Found && (!best || candidate.Length < best->Length))
+			best = &candidate;
+	}
+
+	if (!best)
+		return false;
+
+	Result.Found		= true;
+	Result.TargetOffset	= (uint32_t)(Result.Address - best->Start);
+	Result.Signature	= std::move(best->Signature);
+	return true;
+}
+
+bool BatchSigSearch(const BATCH_SIG_MODULE& Module, const BATCH_SIG_OPTIONS& Options, BATCH_SIG_RESULT& Result)
+{
+	return BatchSigSearch(Module, Options, Result, nullptr);
+}
+
+void BatchSigGenerate(const BATCH_SIG_MODULE& Module, const BATCH_SIG_OPTIONS& Options, const std::vector<uint64_t>& Addresses, std::vector<BATCH_SIG_RESULT>& Results)
+{
+	Results.clear();
+	Results.resize(Addresses.size());
+
+	for (size_t i = 0; i < Addresses.size(); i++)
+		Results[i].Address = Addresses[i];
+
+	// Addresses are spread over the workers, so each search stays on its thread
+	BatchSigParallel(Addresses.size(), [&](size_t Index, std::vector<_DInst>& Instructions)
+	{
+		BatchSigSearch(Module, Options, Results[Index], &Instructions);
+	});
+}
+
+#include "BatchSigTest.h"
\ No newline at end of file
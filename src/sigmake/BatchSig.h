@@ -0,0 +1,77 @@
+#pragma once
+
+//
+// Generates signatures for many addresses of one module at once. Everything runs
+// on a local copy of the module: instruction lengths come from distorm and the
+// uniqueness checks from the pattern scanner.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <functional>
+
+extern "C"
+{
+#include "distorm/distorm.h"
+}
+
+#include "Scanner.h"
+
+// Sets Wildcards[i] for every byte of the instruction that becomes a wildcard (Instruction->size entries, zero on entry)
+typedef std::function<void(_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards)> BatchSigFilter;
+
+//
+// Wildcards the displacement and/or the immediate bytes of an instruction, at the
+// positions the decoder reported. Prefixes, opcode, ModRM and SIB bytes are kept.
+//
+void BatchSigWildcardFields(const _DInst *Instruction, bool Displacement, bool Immediate, uint8_t *Wildcards);
+
+//
+// A wildcard policy that only needs the decoded instruction: wildcards the fields that
+// usually change between builds or load addresses, i.e. 32-bit branch targets, far
+// pointers, 32-bit displacements and immediates of 32 bits or more.
+//
+void BatchSigRelocationFilter(_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards);
+
+struct BATCH_SIG_MODULE
+{
+	uint64_t Base;
+	const uint8_t *Data;
+	size_t Size;
+	_DecodeType Type;
+};
+
+struct BATCH_SIG_OPTIONS
+{
+	uint32_t MinLength;		// Instructions are added until this many bytes are used
+	uint32_t MaxLength;		// Give up once a signature would grow past this
+	bool Trim;				// Remove trailing wildcards
+	bool Shorten;			// Cut the unique signature down to the shortest unique prefix
+	uint32_t SearchWindow;	// Also try instruction boundaries up to this many bytes before the address
+
+	// Wildcard policies to try, in order of preference. Empty keeps every byte.
+	std::vector<BatchSigFilter> Filters;
+};
+
+struct BATCH_SIG_RESULT
+{
+	uint64_t Address;
+	bool Found;
+	uint32_t TargetOffset;	// The signature starts this many bytes before Address
+	PackedDescriptor Signature;
+};
+
+//
+// Results[i] belongs to Addresses[i]. Addresses are split between worker threads
+// which each own their decode buffers and only write to their own result slots.
+//
+void BatchSigGenerate(const BATCH_SIG_MODULE& Module, const BATCH_SIG_OPTIONS& Options, const std::vector<uint64_t>& Addresses, std::vector<BATCH_SIG_RESULT>& Results);
+
+//
+// Tries every start offset in the search window with every filter (in parallel) and
+// keeps the shortest unique signature. Ties go to the start closest to the address,
+// then to the earliest filter.
+//
+bool BatchSigSearch(const BATCH_SIG_MODULE& Module, const BATCH_SIG_OPTIONS& Options, BATCH_SIG_RESULT& Result);
+
+bool BatchSigSelfTest();
\ No newline at end of file
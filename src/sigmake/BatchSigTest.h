@@ -0,0 +1,204 @@
+#pragma once
+
+//
+// Runs the batch generator on a generated image with lots of repeated code and
+// checks every signature with a naive search: it must match only at its own
+// address, and with Shorten set, dropping its last byte must make it ambiguous.
+//
+static size_t BatchSigTestCount(const std::vector<uint8_t>& Image, const BATCH_SIG_RESULT& Result, size_t Length)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; Length <= Image.size() && i <= (Image.size() - Length); i++)
+	{
+		size_t j = 0;
+
+		for (; j < Length; j++)
+		{
+			if (!Result.Signature.IsWildcard(j) && Image[i + j] != Result.Signature.Value(j))
+				break;
+		}
+
+		if (j == Length)
+			count++;
+	}
+
+	return count;
+}
+
+bool BatchSigSelfTest()
+{
+	uint32_t state = 0x1F123BB5;
+
+	auto random = [&state]()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	// Copies of a few "functions" that only differ in a byte here and there
+	std::vector<uint8_t> image(64 * 1024);
+	std::vector<uint8_t> function(512);
+
+	for (auto& b : function)
+		b = (uint8_t)random();
+
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = ((random() % 64) == 0) ? (uint8_t)random() : function[i % function.size()];
+
+	std::vector<uint64_t> addresses;
+
+	for (int i = 0; i < 64; i++)
+		addresses.push_back(0x400000 + random() % image.size());
+
+	BATCH_SIG_MODULE module;
+	module.Base	= 0x400000;
+	module.Data	= image.data();
+	module.Size	= image.size();
+	module.Type	= Decode64Bits;
+
+	BATCH_SIG_OPTIONS options;
+	options.MinLength		= 10;
+	options.MaxLength		= 200;
+	options.Trim			= false;
+	options.Shorten			= false;
+	options.SearchWindow	= 0;
+
+	// Wildcard the last 4 bytes of long instructions, like a displacement would be
+	options.Filters.push_back([](_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards)
+	{
+		if (Instruction->size >= 6)
+			memset(Wildcards + Instruction->size - 4, 1, 4);
+	});
+
+	std::vector<BATCH_SIG_RESULT> results;
+	std::vector<BATCH_SIG_RESULT> previous;
+
+	for (int pass = 0; pass < 3; pass++)
+	{
+		// Shortest prefixes, then also earlier starts and a second filter
+		if (pass == 1)
+			options.Shorten = true;
+
+		if (pass == 2)
+		{
+			options.SearchWindow = 16;
+			options.Filters.push_back([](_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards)
+			{
+			});
+		}
+
+		BatchSigGenerate(module, options, addresses, results);
+
+		size_t found = 0;
+
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			auto& result = results[i];
+
+			if (!result.Found)
+				continue;
+
+			size_t offset = (size_t)(result.Address - module.Base) - result.TargetOffset;
+			size_t length = result.Signature.Count();
+
+			// Unique and located at the requested address
+			if (BatchSigTestCount(image, result, length) != 1)
+				return false;
+
+			for (size_t j = 0; j < length; j++)
+			{
+				if (!result.Signature.IsWildcard(j) && image[offset + j] != result.Signature.Value(j))
+					return false;
+			}
+
+			if (options.Shorten && length > 1 && BatchSigTestCount(image, result, length - 1) <= 1)
+				return false;
+
+			// More choices can only give shorter signatures
+			if (pass == 2 && previous[i].Found && length > previous[i].Signature.Count())
+				return false;
+
+			found++;
+		}
+
+		// Nearly every address is reachable within the length limit
+		if (found < addresses.size() / 2)
+			return false;
+
+		previous.swap(results);
+	}
+
+	// A single search runs its candidates in parallel and must agree with the batch
+	for (size_t i = 0; i < 8; i++)
+	{
+		BATCH_SIG_RESULT result;
+		result.Address = addresses[i];
+
+		BatchSigSearch(module, options, result);
+
+		if (result.Found != previous[i].Found || result.TargetOffset != previous[i].TargetOffset || result.Signature != previous[i].Signature)
+			return false;
+	}
+
+	// Instructions with every kind of address-like field and which bytes become wildcards
+	struct
+	{
+		_DecodeType Type;
+		uint8_t Code[16];
+		const char *Mask;
+	} filterTests[] =
+	{
+		{ Decode64Bits, { 0x48, 0xB8, 1, 2, 3, 4, 5, 6, 7, 8 }, "xx????????" },				// mov rax, imm64
+		{ Decode64Bits, { 0x48, 0xC7, 0x00, 1, 2, 3, 4 }, "xxx????" },						// mov qword [rax], imm32
+		{ Decode64Bits, { 0x48, 0x83, 0xC0, 5 }, "xxxx" },									// add rax, imm8
+		{ Decode64Bits, { 0x83, 0x3D, 1, 2, 3, 4, 5 }, "xx????x" },						// cmp dword [rip+disp32], imm8
+		{ Decode64Bits, { 0xC6, 0x44, 0x24, 8, 1 }, "xxxxx" },								// mov byte [rsp+8], imm8
+		{ Decode64Bits, { 0x48, 0x8B, 0x84, 0x24, 1, 2, 3, 4 }, "xxxx????" },				// mov rax, [rsp+disp32]
+		{ Decode64Bits, { 0xA1, 1, 2, 3, 4, 5, 6, 7, 8 }, "x????????" },					// mov eax, [moffs64]
+		{ Decode64Bits, { 0xE8, 1, 2, 3, 4 }, "x????" },									// call rel32
+		{ Decode64Bits, { 0x0F, 0x84, 1, 2, 3, 4 }, "xx????" },							// jz rel32
+		{ Decode64Bits, { 0xEB, 1 }, "xx" },												// jmp rel8
+		{ Decode64Bits, { 0xD1, 0xA0, 1, 2, 3, 4 }, "xx????" },							// shl dword [rax+disp32], 1 (no immediate byte)
+		{ Decode64Bits, { 0x0F, 0xC2, 0x80, 1, 2, 3, 4, 0 }, "xxx????x" },				// cmpeqps xmm0, [rax+disp32] (predicate byte)
+		{ Decode64Bits, { 0xC4, 0xE3, 0x79, 0x4A, 0x80, 1, 2, 3, 4, 0x30 }, "xxxxx????x" },	// vblendvps xmm0, xmm0, [rax+disp32], xmm3
+		{ Decode32Bits, { 0x0F, 0x0F, 0x80, 1, 2, 3, 4, 0x9E }, "xxx????x" },			// pfadd mm0, [eax+disp32] (3DNow! suffix)
+		{ Decode32Bits, { 0x66, 0x6A, 1 }, "xxx" },										// push imm8 (16-bit operand)
+		{ Decode32Bits, { 0x69, 0x83, 1, 2, 3, 4, 5, 6, 7, 8 }, "xx????????" },			// imul eax, [ebx+disp32], imm32
+		{ Decode32Bits, { 0xC7, 0x05, 1, 2, 3, 4, 5, 0, 0, 0 }, "xx????????" },			// mov dword [disp32], imm32
+		{ Decode32Bits, { 0xC8, 0x10, 0, 1 }, "xxxx" },									// enter 16, 1
+		{ Decode32Bits, { 0xEA, 1, 2, 3, 4, 5, 6 }, "x??????" },							// jmp far ptr16:32
+	};
+
+	for (auto& test : filterTests)
+	{
+		int size = (int)strlen(test.Mask);
+
+		_CodeInfo info;
+		memset(&info, 0, sizeof(_CodeInfo));
+
+		info.code		= test.Code;
+		info.codeLen	= size;
+		info.dt			= test.Type;
+
+		_DInst instruction;
+		unsigned int count = 0;
+
+		if (distorm_decompose(&info, &instruction, 1, &count) == DECRES_INPUTERR || count != 1 || instruction.size != size)
+			return false;
+
+		uint8_t wildcards[BatchSigInstructionMax] = {};
+		BatchSigRelocationFilter(&instruction, test.Code, wildcards);
+
+		for (int i = 0; i < size; i++)
+		{
+			if ((wildcards[i] != 0) != (test.Mask[i] == '?'))
+				return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "CodeStream.h"
+#include <string.h>
+#include <algorithm>
+
+// Longest possible x86 instruction
+const size_t CodeStreamInstructionMax = 15;
+
+CodeStream::CodeStream(_DecodeType Type, size_t WindowSize, size_t ArenaSize)
+{
+	m_Type = Type;
+
+	// The window always has room for more than one full instruction, and the arena for
+	// the undecodable bytes of one (distorm reports those all at once)
+	m_Window.resize(std::max(WindowSize, CodeStreamInstructionMax * 2));
+	m_Instructions.resize(std::max(ArenaSize, CodeStreamInstructionMax));
+}
+
+bool CodeStream::Decode(uint64_t Start, uint64_t Size, const CodeStreamRead& Read, const CodeStreamCallback& Callback)
+{
+	uint64_t position	= 0;	// Stream offset of the first byte in the window
+	uint64_t readEnd	= 0;	// Stream offset of the next byte to read
+	size_t length		= 0;	// Bytes in the window
+
+	while (position < Size)
+	{
+		// Top up the window behind whatever wasn't decoded last time
+		size_t fill = (size_t)std::min<uint64_t>(m_Window.size() - length, Size - readEnd);
+
+		if (fill > 0)
+		{
+			if (!Read(Start + readEnd, m_Window.data() + length, fill))
+				return false;
+
+			readEnd	+= fill;
+			length	+= fill;
+		}
+
+		_CodeInfo info;
+		memset(&info, 0, sizeof(_CodeInfo));
+
+		info.codeOffset	= (_OffsetType)(Start + position);
+		info.code		= m_Window.data();
+		info.codeLen	= (int)length;
+		info.dt			= m_Type;
+		info.features	= DF_NONE;
+
+		// A full arena (DECRES_MEMORYERR) still returns every instruction that fit
+		unsigned int count = 0;
+
+		if (distorm_decompose(&info, m_Instructions.data(), (unsigned int)m_Instructions.size(), &count) == DECRES_INPUTERR)
+			return false;
+
+		//
+		// An instruction starting near the end of the window might continue past it and
+		// would be reported as undecodable bytes, so those are decoded again once the
+		// window has been refilled. At the end of the range there is nothing to wait for.
+		//
+		bool last		= readEnd == Size;
+		size_t limit	= last ? length : (length - CodeStreamInstructionMax);
+		size_t used		= 0;
+
+		for (unsigned int i = 0; i < count && used < limit; i++)
+		{
+			if (!Callback(&m_Instructions[i], m_Window.data() + used))
+				return true;
+
+			// Default to 1 byte on failure
+			used += std::max<size_t>(m_Instructions[i].size, 1);
+		}
+
+		// Nothing decoded at all would mean an endless loop
+		if (used == 0)
+			return false;
+
+		used = std::min(used, length);
+		memmove(m_Window.data(), m_Window.data() + used, length - used);
+
+		position	+= used;
+		length		-= used;
+	}
+
+	return true;
+}
+
+#include "CodeStreamTest.h"
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+//
+// Decodes a code range of any size with constant memory: bytes are read into a
+// fixed-size window and decoded into a reused instruction arena, and instructions
+// are handed out in order as soon as they are complete.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <functional>
+
+extern "C"
+{
+#include "distorm/distorm.h"
+}
+
+// Default window size in bytes and arena size in instructions (both have small minimums)
+const size_t CodeStreamWindowSize	= 64 * 1024;
+const size_t CodeStreamArenaSize	= 4096;
+
+// Fills Buffer with the Size bytes at Address; false fails the whole decode
+typedef std::function<bool(uint64_t Address, uint8_t *Buffer, size_t Size)> CodeStreamRead;
+
+// Data points to the instruction's bytes; return false to stop early
+typedef std::function<bool(_DInst *Instruction, const uint8_t *Data)> CodeStreamCallback;
+
+class CodeStream
+{
+public:
+	CodeStream(_DecodeType Type, size_t WindowSize = CodeStreamWindowSize, size_t ArenaSize = CodeStreamArenaSize);
+
+	//
+	// Decodes [Start, Start + Size). Every byte is read exactly once. Returns false if
+	// a read or the decoder failed; stopping early from Callback isn't a failure.
+	//
+	bool Decode(uint64_t Start, uint64_t Size, const CodeStreamRead& Read, const CodeStreamCallback& Callback);
+
+private:
+	_DecodeType m_Type;
+	std::vector<uint8_t> m_Window;
+	std::vector<_DInst> m_Instructions;
+};
+
+bool CodeStreamSelfTest();
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+//
+// Decodes the same code with tiny windows and arenas (so instructions constantly
+// straddle window ends and the arena overflows) and compares every instruction with
+// a single distorm_decompose call over the whole buffer. Also checks stopping early
+// and that read errors are reported.
+//
+bool CodeStreamSelfTest()
+{
+	// A mix of short and long instructions, repeated with a shifting pad so they land
+	// on every offset of a window
+	const uint8_t instructions[] =
+	{
+		0x48, 0x89, 0x5C, 0x24, 0x08,									// mov [rsp+8], rbx
+		0x48, 0xB8, 1, 2, 3, 4, 5, 6, 7, 8,							// mov rax, imm64
+		0xE8, 1, 2, 3, 4,												// call rel32
+		0xC4, 0xE3, 0x79, 0x4A, 0x80, 1, 2, 3, 4, 0x30,				// vblendvps xmm0, xmm0, [rax+disp32], xmm3
+		0x66, 0x66, 0x2E, 0x0F, 0x1F, 0x84, 0, 0, 0, 0, 0,			// nop word [rax+rax+0]
+		0x74, 0x10,														// jz rel8
+		0xC3,															// ret
+	};
+
+	std::vector<uint8_t> code;
+
+	for (int i = 0; code.size() < 5000; i++)
+	{
+		code.insert(code.end(), i % 7, 0x90);
+		code.insert(code.end(), instructions, instructions + sizeof(instructions));
+	}
+
+	// A truncated instruction at the very end
+	code.push_back(0x48);
+	code.push_back(0xB8);
+
+	const uint64_t start = 0x140001000;
+
+	std::vector<_DInst> expected(code.size());
+	unsigned int expectedCount = 0;
+
+	_CodeInfo info;
+	memset(&info, 0, sizeof(_CodeInfo));
+
+	info.codeOffset	= (_OffsetType)start;
+	info.code		= code.data();
+	info.codeLen	= (int)code.size();
+	info.dt			= Decode64Bits;
+	info.features	= DF_NONE;
+
+	if (distorm_decompose(&info, expected.data(), (unsigned int)expected.size(), &expectedCount) != DECRES_SUCCESS)
+		return false;
+
+	auto read = [&](uint64_t Address, uint8_t *Buffer, size_t Size)
+	{
+		if (Address < start || (Address - start) + Size > code.size())
+			return false;
+
+		memcpy(Buffer, &code[(size_t)(Address - start)], Size);
+		return true;
+	};
+
+	for (size_t windowSize : { 1, 31, 64, 4096, 64 * 1024 })
+	{
+		for (size_t arenaSize : { 1, 3, 100, 4096 })
+		{
+			CodeStream stream(Decode64Bits, windowSize, arenaSize);
+			size_t index	= 0;
+			size_t offset	= 0;
+			bool same		= true;
+
+			bool decoded = stream.Decode(start, code.size(), read, [&](_DInst *Instruction, const uint8_t *Data)
+			{
+				const _DInst& other = expected[index++];
+
+				same = same && index <= expectedCount && Instruction->addr == other.addr && Instruction->size == other.size &&
+					Instruction->opcode == other.opcode && Instruction->flags == other.flags && Instruction->dispOffset == other.dispOffset &&
+					Instruction->immOffset == other.immOffset && memcmp(Data, &code[offset], Instruction->size) == 0;
+
+				offset += Instruction->size;
+				return same;
+			});
+
+			if (!decoded || !same || index != expectedCount || offset != code.size())
+				return false;
+		}
+	}
+
+	// Stopping after a few instructions
+	CodeStream stream(Decode64Bits, 64, 8);
+	size_t seen = 0;
+
+	if (!stream.Decode(start, code.size(), read, [&](_DInst *Instruction, const uint8_t *Data) { return ++seen < 10; }) || seen != 10)
+		return false;
+
+	// Reads past the end of the buffer fail
+	if (stream.Decode(start, code.size() + 1, read, [](_DInst *Instruction, const uint8_t *Data) { return true; }))
+		return false;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,620 @@
+#include <string.h>
+#include <algorithm>
+#include "CrcPattern.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define CRC_X86
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC_TARGET_SSE42
+#else
+#include <immintrin.h>
+#define CRC_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif // _MSC_VER
+#else
+#define CRC_TARGET_SSE42
+#endif // x86
+
+// CRC32C (Castagnoli), reflected
+const static uint32_t CrcPolynomial = 0x82F63B78;
+
+// Windows checksummed side by side by the hardware scanner
+const static size_t CrcScanLanes = 4;
+
+// Most table lookups per position the rolling scanner may need (see BuildRolling)
+const static size_t CrcRollingMaxCost = 24;
+
+struct CRC_TABLES
+{
+	// Slicing-by-8: Entries[k][b] is the CRC of byte b followed by k zero bytes
+	uint32_t Entries[8][256];
+
+	CRC_TABLES()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t crc = i;
+
+			for (int j = 0; j < 8; j++)
+				crc = (crc >> 1) ^ ((crc & 1) ? CrcPolynomial : 0);
+
+			Entries[0][i] = crc;
+		}
+
+		for (int k = 1; k < 8; k++)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+				Entries[k][i] = (Entries[k - 1][i] >> 8) ^ Entries[0][Entries[k - 1][i] & 0xFF];
+		}
+	}
+};
+
+static const CRC_TABLES CrcTables;
+
+static inline uint64_t CrcLoadWord(const uint8_t *Data)
+{
+	uint64_t value;
+	memcpy(&value, Data, sizeof(uint64_t));
+	return value;
+}
+
+static inline uint32_t CrcTableWord(uint32_t Crc, uint64_t Value)
+{
+	uint32_t low	= Crc ^ (uint32_t)Value;
+	uint32_t high	= (uint32_t)(Value >> 32);
+
+	return	CrcTables.Entries[7][low & 0xFF] ^ CrcTables.Entries[6][(low >> 8) & 0xFF] ^
+			CrcTables.Entries[5][(low >> 16) & 0xFF] ^ CrcTables.Entries[4][low >> 24] ^
+			CrcTables.Entries[3][high & 0xFF] ^ CrcTables.Entries[2][(high >> 8) & 0xFF] ^
+			CrcTables.Entries[1][(high >> 16) & 0xFF] ^ CrcTables.Entries[0][high >> 24];
+}
+
+static inline uint32_t CrcTableByte(uint32_t Crc, uint8_t Value)
+{
+	return CrcTables.Entries[0][(Crc ^ Value) & 0xFF] ^ (Crc >> 8);
+}
+
+// Runs Crc through Zeros zero bytes
+static uint32_t CrcZeros(uint32_t Crc, size_t Zeros)
+{
+	for (size_t i = 0; i < Zeros; i++)
+		Crc = CrcTables.Entries[0][Crc & 0xFF] ^ (Crc >> 8);
+
+	return Crc;
+}
+
+//
+// Fills Table with every combination of the Bits basis values: Table[k * 256 + b] is
+// the XOR of Basis[k * 8 + i] for every bit i set in b
+//
+static void CrcCombineTable(const uint32_t *Basis, size_t Bits, uint32_t *Table)
+{
+	for (size_t k = 0; k < Bits / 8; k++)
+	{
+		uint32_t *table = Table + k * 256;
+		table[0] = 0;
+
+		// Values with bit i as their highest bit extend the ones below it
+		for (size_t i = 0; i < 8; i++)
+		{
+			for (size_t b = 0; b < ((size_t)1 << i); b++)
+				table[((size_t)1 << i) + b] = table[b] ^ Basis[k * 8 + i];
+		}
+	}
+}
+
+// Table[b] = the CRC (starting from 0) of byte b followed by Zeros zero bytes
+static void CrcByteTable(size_t Zeros, uint32_t *Table)
+{
+	uint32_t basis[8];
+
+	for (int bit = 0; bit < 8; bit++)
+		basis[bit] = CrcZeros(CrcTables.Entries[0][1 << bit], Zeros);
+
+	CrcCombineTable(basis, 8, Table);
+}
+
+// Table[k * 256 + b] = the CRC register (b << 8k) after Zeros zero bytes
+static void CrcShiftTable(size_t Zeros, uint32_t *Table)
+{
+	uint32_t basis[32];
+
+	for (int bit = 0; bit < 32; bit++)
+		basis[bit] = CrcZeros(1u << bit, Zeros);
+
+	CrcCombineTable(basis, 32, Table);
+}
+
+#ifdef CRC_X86
+CRC_TARGET_SSE42 static inline uint32_t CrcHardwareWord(uint32_t Crc, uint64_t Value)
+{
+#if defined(_M_X64) || defined(__x86_64__)
+	return (uint32_t)_mm_crc32_u64(Crc, Value);
+#else
+	return _mm_crc32_u32(_mm_crc32_u32(Crc, (uint32_t)Value), (uint32_t)(Value >> 32));
+#endif
+}
+#endif // CRC_X86
+
+static bool DetectCrcHardware()
+{
+#ifdef CRC_X86
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+
+	return (info[2] & (1 << 20)) != 0;
+#else
+	return __builtin_cpu_supports("sse4.2");
+#endif // _MSC_VER
+#else
+	return false;
+#endif // CRC_X86
+}
+
+bool CrcHardwareSupported()
+{
+	static const bool supported = DetectCrcHardware();
+	return supported;
+}
+
+CrcPattern::CrcPattern(const PackedDescriptor& Descriptor)
+{
+	Build(Descriptor);
+
+	// Wildcards are already zero in the value plane
+	m_Checksum = Compute(Descriptor.Values());
+}
+
+CrcPattern::CrcPattern(const PackedDescriptor& Layout, uint32_t Checksum)
+{
+	Build(Layout);
+
+	m_Checksum = Checksum;
+}
+
+void CrcPattern::Build(const PackedDescriptor& Layout)
+{
+	m_Count = Layout.Count();
+	m_Mask.assign((m_Count + 7) & ~(size_t)7, 0);
+
+	for (size_t i = 0; i < m_Count; i++)
+		m_Mask[i] = Layout.IsWildcard(i) ? 0x00 : 0xFF;
+
+	BuildRolling();
+}
+
+void CrcPattern::BuildRolling()
+{
+	//
+	// Without the initial value and final inversion a CRC is linear in the bytes, so the
+	// CRC of a masked window is the XOR of what each fixed run contributes at its place.
+	// The same value is also the CRC of the whole unmasked window XOR the contributions
+	// of the wildcard runs, whichever takes fewer lookups. A run is either looked up
+	// byte by byte, or rolled forward with its own register: one step for the incoming
+	// byte, one lookup for the outgoing one and, unless the run ends the window, four
+	// to move it past the trailing bytes.
+	//
+	m_Terms.clear();
+	m_Tables.clear();
+	m_ZeroCrc = 0;
+	m_PreferRolling = false;
+
+	std::vector<std::pair<size_t, size_t>> runs[2];	// Wildcard and fixed (offset, length)
+
+	for (size_t i = 0; i < m_Count;)
+	{
+		size_t start = i;
+		bool fixed = m_Mask[i] != 0;
+
+		while (i < m_Count && (m_Mask[i] != 0) == fixed)
+			i++;
+
+		runs[fixed].push_back({ start, i - start });
+	}
+
+	auto runCost = [&](const std::pair<size_t, size_t>& Run)
+	{
+		bool trailing = (Run.first + Run.second) < m_Count;
+		return std::min<size_t>(Run.second, trailing ? 6 : 2);
+	};
+
+	size_t fixedCost	= 0;
+	size_t wildcardCost	= runCost({ 0, m_Count });
+
+	for (auto& run : runs[1])
+		fixedCost += runCost(run);
+
+	for (auto& run : runs[0])
+		wildcardCost += runCost(run);
+
+	// Worth it when it needs clearly fewer lookups than a full checksum (about one per byte)
+	size_t cost = std::min(fixedCost, wildcardCost);
+
+	if (runs[1].empty() || cost > CrcRollingMaxCost || (cost * 2) > m_Count)
+		return;
+
+	if (fixedCost <= wildcardCost)
+	{
+		for (auto& run : runs[1])
+			AddTerm(run.first, run.second);
+	}
+	else
+	{
+		AddTerm(0, m_Count);
+
+		for (auto& run : runs[0])
+			AddTerm(run.first, run.second);
+	}
+
+	m_ZeroCrc = CrcZeros(0xFFFFFFFF, m_Count);
+
+	// The crc32 instruction takes about an eighth of a lookup per byte, but all of them are independent
+	m_PreferRolling = m_Count >= 6 * (cost + 3);
+}
+
+void CrcPattern::AddTerm(size_t Offset, size_t Length)
+{
+	size_t trailing = m_Count - Offset - Length;
+
+	if (Length <= (trailing ? 6u : 2u))
+	{
+		for (size_t i = Offset; i < Offset + Length; i++)
+		{
+			m_Terms.push_back({ i, 1, false, m_Tables.size(), SIZE_MAX });
+
+			m_Tables.resize(m_Tables.size() + 256);
+			CrcByteTable(m_Count - 1 - i, &m_Tables[m_Tables.size() - 256]);
+		}
+
+		return;
+	}
+
+	// The outgoing byte of a rolled run is followed by Length zero bytes by then
+	CRC_TERM term = { Offset, Length, true, m_Tables.size(), SIZE_MAX };
+
+	m_Tables.resize(m_Tables.size() + 256);
+	CrcByteTable(Length, &m_Tables[term.Table]);
+
+	if (trailing > 0)
+	{
+		term.Shift = m_Tables.size();
+
+		m_Tables.resize(m_Tables.size() + 4 * 256);
+		CrcShiftTable(trailing, &m_Tables[term.Shift]);
+	}
+
+	m_Terms.push_back(term);
+}
+
+uint32_t CrcPattern::Compute(const uint8_t *Data) const
+{
+	uint32_t crc	= 0xFFFFFFFF;
+	size_t words	= m_Count / 8;
+
+	for (size_t i = 0; i < words; i++)
+		crc = CrcTableWord(crc, CrcLoadWord(Data + i * 8) & CrcLoadWord(&m_Mask[i * 8]));
+
+	for (size_t i = words * 8; i < m_Count; i++)
+		crc = CrcTableByte(crc, Data[i] & m_Mask[i]);
+
+	return ~crc;
+}
+
+bool CrcPattern::MatchAt(const uint8_t *Data, size_t Size, size_t Offset) const
+{
+	if (Offset > Size || m_Count > (Size - Offset))
+		return false;
+
+	return Compute(Data + Offset) == m_Checksum;
+}
+
+size_t CrcPattern::Scan(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const
+{
+	CRC_SCAN_METHOD method = CRC_SCAN_TABLE;
+
+	if (CanRoll() && (m_PreferRolling || !CrcHardwareSupported()))
+		method = CRC_SCAN_ROLLING;
+	else if (CrcHardwareSupported())
+		method = CRC_SCAN_HARDWARE;
+
+	return Scan(Data, Size, Offsets, MaxResults, method);
+}
+
+size_t CrcPattern::Scan(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults, CRC_SCAN_METHOD Method) const
+{
+	if (m_Count <= 0 || m_Count > Size || MaxResults <= 0)
+		return 0;
+
+	if (Method == CRC_SCAN_ROLLING && CanRoll())
+		return ScanRolling(Data, Size, Offsets, MaxResults);
+
+#ifdef CRC_X86
+	if (Method == CRC_SCAN_HARDWARE && CrcHardwareSupported())
+		return ScanHardware(Data, Size, Offsets, MaxResults);
+#endif // CRC_X86
+
+	return ScanTable(Data, Size, Offsets, MaxResults);
+}
+
+size_t CrcPattern::ScanParallel(const uint8_t *Data, size_t Size, const ScanCallback& Callback) const
+{
+	if (m_Count <= 0 || m_Count > Size)
+		return 0;
+
+	return ScanChunksParallel(Size - m_Count + 1, [&](size_t Start, size_t Count, std::vector<size_t>& Offsets)
+	{
+		Scan(Data + Start, Count + m_Count - 1, Offsets, SIZE_MAX);
+
+		for (auto& offset : Offsets)
+			offset += Start;
+	}, Callback);
+}
+
+size_t CrcPattern::ScanTable(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const
+{
+	size_t found = 0;
+
+	for (size_t i = 0; i <= (Size - m_Count) && found < MaxResults; i++)
+	{
+		if (Compute(Data + i) == m_Checksum)
+		{
+			Offsets.push_back(i);
+			found++;
+		}
+	}
+
+	return found;
+}
+
+CRC_TARGET_SSE42 size_t CrcPattern::ScanHardware(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const
+{
+#ifdef CRC_X86
+	//
+	// Every position is checksummed from scratch, which beats rolling for short or
+	// fragmented layouts. Four neighbouring windows go through the crc32 instruction
+	// together to hide its latency.
+	//
+	size_t positions	= Size - m_Count + 1;
+	size_t words		= m_Count / 8;
+	size_t found		= 0;
+	size_t i			= 0;
+
+	for (; (i + CrcScanLanes) <= positions && found < MaxResults; i += CrcScanLanes)
+	{
+		uint32_t crc[CrcScanLanes];
+
+		for (size_t lane = 0; lane < CrcScanLanes; lane++)
+			crc[lane] = 0xFFFFFFFF;
+
+		for (size_t word = 0; word < words; word++)
+		{
+			uint64_t mask		= CrcLoadWord(&m_Mask[word * 8]);
+			const uint8_t *data	= Data + i + word * 8;
+
+			for (size_t lane = 0; lane < CrcScanLanes; lane++)
+				crc[lane] = CrcHardwareWord(crc[lane], CrcLoadWord(data + lane) & mask);
+		}
+
+		for (size_t j = words * 8; j < m_Count; j++)
+		{
+			for (size_t lane = 0; lane < CrcScanLanes; lane++)
+				crc[lane] = _mm_crc32_u8(crc[lane], Data[i + lane + j] & m_Mask[j]);
+		}
+
+		for (size_t lane = 0; lane < CrcScanLanes && found < MaxResults; lane++)
+		{
+			if (~crc[lane] == m_Checksum)
+			{
+				Offsets.push_back(i + lane);
+				found++;
+			}
+		}
+	}
+
+	// Leftover positions at the end of the buffer
+	for (; i < positions && found < MaxResults; i++)
+	{
+		if (Compute(Data + i) == m_Checksum)
+		{
+			Offsets.push_back(i);
+			found++;
+		}
+	}
+
+	return found;
+#else
+	return ScanTable(Data, Size, Offsets, MaxResults);
+#endif // CRC_X86
+}
+
+// The terms of a CrcPattern flattened for CrcRollLanes
+struct CRC_ROLLING
+{
+	const uint32_t *ByteTables[CrcRollingMaxCost];
+	size_t ByteOffsets[CrcRollingMaxCost];
+	size_t ByteCount;
+
+	const uint32_t *Leave[CrcRollingMaxCost];
+	const uint32_t *Shift[CrcRollingMaxCost];	// nullptr for runs at the end of the window
+	size_t RollOffsets[CrcRollingMaxCost];
+	size_t RollLengths[CrcRollingMaxCost];
+	size_t RollCount;
+
+	uint32_t Target;
+};
+
+//
+// Checks Count positions of each lane starting at Starts[lane], sliding every run past
+// each of them, so the position after the last one has to exist. Registers[t][lane]
+// holds the rolled runs of each lane. Lanes are independent dependency chains.
+//
+template<size_t Lanes>
+static void CrcRollLanes(const CRC_ROLLING& Rolling, const uint8_t *Data, const size_t *Starts, size_t Count, uint32_t (*Registers)[Lanes], std::vector<size_t> *Found)
+{
+	for (size_t i = 0; i < Count; i++)
+	{
+		const uint8_t *data[Lanes];
+		uint32_t crc[Lanes];
+
+		for (size_t lane = 0; lane < Lanes; lane++)
+		{
+			data[lane]	= Data + Starts[lane] + i;
+			crc[lane]	= 0;
+		}
+
+		for (size_t t = 0; t < Rolling.ByteCount; t++)
+		{
+			const uint32_t *table	= Rolling.ByteTables[t];
+			size_t offset			= Rolling.ByteOffsets[t];
+
+			for (size_t lane = 0; lane < Lanes; lane++)
+				crc[lane] ^= table[data[lane][offset]];
+		}
+
+		for (size_t t = 0; t < Rolling.RollCount; t++)
+		{
+			const uint32_t *shift	= Rolling.Shift[t];
+			const uint32_t *leave	= Rolling.Leave[t];
+			size_t offset			= Rolling.RollOffsets[t];
+			size_t length			= Rolling.RollLengths[t];
+
+			for (size_t lane = 0; lane < Lanes; lane++)
+			{
+				uint32_t value = Registers[t][lane];
+
+				if (shift)
+				{
+					crc[lane] ^=	shift[value & 0xFF] ^ shift[256 + ((value >> 8) & 0xFF)] ^
+									shift[512 + ((value >> 16) & 0xFF)] ^ shift[768 + (value >> 24)];
+				}
+				else
+				{
+					crc[lane] ^= value;
+				}
+
+				// The next byte comes in, the first one goes out
+				const uint8_t *run = data[lane] + offset;
+				Registers[t][lane] = CrcTableByte(value, run[length]) ^ leave[run[0]];
+			}
+		}
+
+		for (size_t lane = 0; lane < Lanes; lane++)
+		{
+			if (crc[lane] == Rolling.Target)
+				Found[lane].push_back(Starts[lane] + i);
+		}
+	}
+}
+
+size_t CrcPattern::ScanRolling(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const
+{
+	// Every term XORed together gives the window's CRC from 0, without the initial value
+	CRC_ROLLING rolling;
+	rolling.ByteCount	= 0;
+	rolling.RollCount	= 0;
+	rolling.Target		= ~m_Checksum ^ m_ZeroCrc;
+
+	for (auto& term : m_Terms)
+	{
+		if (!term.Rolling)
+		{
+			rolling.ByteTables[rolling.ByteCount]	= &m_Tables[term.Table];
+			rolling.ByteOffsets[rolling.ByteCount]	= term.Offset;
+			rolling.ByteCount++;
+			continue;
+		}
+
+		rolling.Leave[rolling.RollCount]		= &m_Tables[term.Table];
+		rolling.Shift[rolling.RollCount]		= (term.Shift != SIZE_MAX) ? &m_Tables[term.Shift] : nullptr;
+		rolling.RollOffsets[rolling.RollCount]	= term.Offset;
+		rolling.RollLengths[rolling.RollCount]	= term.Length;
+		rolling.RollCount++;
+	}
+
+	auto startRegisters = [&](size_t Position, uint32_t *Registers, size_t Stride)
+	{
+		for (size_t t = 0; t < rolling.RollCount; t++)
+		{
+			const uint8_t *run = Data + Position + rolling.RollOffsets[t];
+			uint32_t crc = 0;
+
+			for (size_t i = 0; i < rolling.RollLengths[t]; i++)
+				crc = CrcTableByte(crc, run[i]);
+
+			Registers[t * Stride] = crc;
+		}
+	};
+
+	//
+	// Rolling a register is one long dependency chain, so the positions are split into
+	// lanes rolled side by side, a block at a time so that lane 0 can stop the scan
+	// once it alone found enough. The last position can't slide and is checked alone.
+	//
+	const size_t blockSize = 4096;
+
+	size_t positions	= Size - m_Count + 1;
+	size_t sliding		= positions - 1;
+	size_t laneSize		= (sliding >= CrcScanLanes * 256) ? (sliding / CrcScanLanes) : 0;
+	size_t tail			= laneSize * CrcScanLanes;
+
+	std::vector<size_t> found[CrcScanLanes];
+	size_t starts[CrcScanLanes];
+	uint32_t registers[CrcRollingMaxCost][CrcScanLanes];
+	uint32_t tailRegisters[CrcRollingMaxCost][1];
+
+	if (laneSize > 0)
+	{
+		for (size_t lane = 0; lane < CrcScanLanes; lane++)
+		{
+			starts[lane] = lane * laneSize;
+			startRegisters(starts[lane], &registers[0][lane], CrcScanLanes);
+		}
+
+		for (size_t done = 0; done < laneSize && found[0].size() < MaxResults;)
+		{
+			size_t count = std::min(blockSize, laneSize - done);
+
+			CrcRollLanes<CrcScanLanes>(rolling, Data, starts, count, registers, found);
+
+			for (size_t lane = 0; lane < CrcScanLanes; lane++)
+				starts[lane] += count;
+
+			done += count;
+		}
+
+		// The last lane carries on with whatever didn't divide evenly
+		for (size_t t = 0; t < rolling.RollCount; t++)
+			tailRegisters[t][0] = registers[t][CrcScanLanes - 1];
+	}
+	else
+	{
+		startRegisters(0, &tailRegisters[0][0], 1);
+	}
+
+	std::vector<size_t>& tailFound = found[CrcScanLanes - 1];
+
+	for (size_t done = tail; done < sliding && found[0].size() < MaxResults && (laneSize > 0 || tailFound.size() < MaxResults);)
+	{
+		size_t count = std::min(blockSize, sliding - done);
+
+		CrcRollLanes<1>(rolling, Data, &done, count, tailRegisters, &tailFound);
+		done += count;
+	}
+
+	if (Compute(Data + sliding) == m_Checksum)
+		tailFound.push_back(sliding);
+
+	size_t count = 0;
+
+	for (size_t lane = 0; lane < CrcScanLanes; lane++)
+	{
+		for (size_t i = 0; i < found[lane].size() && count < MaxResults; i++, count++)
+			Offsets.push_back(found[lane][i]);
+	}
+
+	return count;
+}
+
+#include "CrcPatternTest.h"
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+//
+// CRC signatures: a length and the CRC32C of the window with every wildcard byte
+// zeroed. Only the checksum and the wildcard layout are stored, so a signature of
+// any length stays a few bytes, but the original bytes can't be recovered.
+//
+#include "Scanner.h"
+
+bool CrcHardwareSupported();
+
+enum CRC_SCAN_METHOD
+{
+	CRC_SCAN_TABLE,			// Every window checksummed with slicing-by-8 tables
+	CRC_SCAN_HARDWARE,		// Every window checksummed with the SSE4.2 crc32 instruction
+	CRC_SCAN_ROLLING,		// The checksum rolled forward one byte at a time
+};
+
+class CrcPattern
+{
+public:
+	// Checksums the fixed bytes of Descriptor
+	explicit CrcPattern(const PackedDescriptor& Descriptor);
+
+	// Only the wildcard layout of Layout is used
+	CrcPattern(const PackedDescriptor& Layout, uint32_t Checksum);
+
+	size_t Count() const
+	{
+		return m_Count;
+	}
+
+	uint32_t Checksum() const
+	{
+		return m_Checksum;
+	}
+
+	bool IsWildcard(size_t Index) const
+	{
+		return m_Mask[Index] == 0;
+	}
+
+	bool MatchAt(const uint8_t *Data, size_t Size, size_t Offset) const;
+
+	// Whether the wildcard layout is simple enough to scan with CRC_SCAN_ROLLING
+	bool CanRoll() const
+	{
+		return !m_Terms.empty();
+	}
+
+	//
+	// Same contract as ScanPattern::Scan. Without a method, the rolling scan is used when
+	// it is expected to be faster than checksumming every window; methods that aren't
+	// available fall back to the table implementation.
+	//
+	size_t Scan(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t Scan(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults, CRC_SCAN_METHOD Method) const;
+	size_t ScanParallel(const uint8_t *Data, size_t Size, const ScanCallback& Callback) const;
+
+private:
+	// One part of a window's CRC for the rolling scan (see CrcPattern.cpp)
+	struct CRC_TERM
+	{
+		size_t Offset;
+		size_t Length;
+		bool Rolling;		// Rolled with its own register instead of looked up per byte
+		size_t Table;		// Into m_Tables: 256 byte contributions, or the outgoing bytes if rolling
+		size_t Shift;		// Into m_Tables: 4x256 trailing zero byte tables, SIZE_MAX if none
+	};
+
+	void Build(const PackedDescriptor& Layout);
+	void BuildRolling();
+	void AddTerm(size_t Offset, size_t Length);
+
+	uint32_t Compute(const uint8_t *Data) const;
+	size_t ScanTable(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t ScanHardware(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t ScanRolling(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+
+	size_t m_Count;
+	uint32_t m_Checksum;
+
+	// 0xFF for fixed bytes and 0x00 for wildcards, padded to a multiple of 8 bytes
+	std::vector<uint8_t> m_Mask;
+
+	// Rolling scan: the terms, their lookup tables and the CRC of m_Count zero bytes
+	std::vector<CRC_TERM> m_Terms;
+	std::vector<uint32_t> m_Tables;
+	uint32_t m_ZeroCrc;
+	bool m_PreferRolling;	// Even over the crc32 instruction
+};
+
+bool CrcPatternSelfTest();
\ No newline at end of file
@@ -0,0 +1,173 @@
+#pragma once
+
+//
+// Checks the checksum against the published CRC32C test vector and every scanner
+// against a bit-at-a-time reference, which also reports CRC collisions.
+//
+static uint32_t CrcTestReference(const uint8_t *Data, const CrcPattern& Pattern)
+{
+	uint32_t crc = 0xFFFFFFFF;
+
+	for (size_t i = 0; i < Pattern.Count(); i++)
+	{
+		crc ^= Pattern.IsWildcard(i) ? 0 : Data[i];
+
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+	}
+
+	return ~crc;
+}
+
+bool CrcPatternSelfTest()
+{
+	const uint8_t check[]			= { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+	const uint8_t noWildcards[9]	= {};
+
+	if (CrcPattern(PackedDescriptor(check, noWildcards, 9)).Checksum() != 0xE3069283)
+		return false;
+
+	uint32_t state = 0x3A9F1C27;
+
+	auto random = [&state]()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> wildcards;
+	std::vector<size_t> expected;
+	std::vector<size_t> actual;
+
+	for (int iteration = 0; iteration < 300; iteration++)
+	{
+		size_t size = 64 + random() % 4096;
+
+		data.resize(size);
+
+		for (auto& b : data)
+			b = (uint8_t)(random() % 3);
+
+		size_t count	= 1 + random() % 60;
+		size_t source	= random() % (size - count + 1);
+
+		wildcards.resize(count);
+
+		for (auto& w : wildcards)
+			w = (random() % 4) == 0 ? 1 : 0;
+
+		CrcPattern pattern(PackedDescriptor(&data[source], wildcards.data(), count));
+		size_t maxResults = (iteration % 5 == 0) ? (1 + random() % 4) : SIZE_MAX;
+
+		expected.clear();
+
+		for (size_t i = 0; i <= (size - count) && expected.size() < maxResults; i++)
+		{
+			if (CrcTestReference(&data[i], pattern) == pattern.Checksum())
+				expected.push_back(i);
+		}
+
+		for (auto method : { CRC_SCAN_TABLE, CRC_SCAN_HARDWARE, CRC_SCAN_ROLLING })
+		{
+			actual.clear();
+			pattern.Scan(data.data(), size, actual, maxResults, method);
+
+			if (actual != expected)
+				return false;
+		}
+
+		// The source itself always matches
+		if (!pattern.MatchAt(data.data(), size, source))
+			return false;
+	}
+
+	//
+	// Long signatures with a few wildcard runs (or none) are rolled. Both ways of splitting
+	// the window (fixed runs, or the whole window and its wildcard runs) and runs that are
+	// looked up or rolled, with and without trailing bytes, must agree with Compute.
+	//
+	size_t rolled = 0;
+
+	for (int iteration = 0; iteration < 200; iteration++)
+	{
+		size_t size = 512 + random() % 4096;
+
+		data.resize(size);
+
+		for (auto& b : data)
+			b = (uint8_t)(random() % 3);
+
+		size_t count	= 8 + random() % 400;
+		size_t source	= random() % (size - count + 1);
+		size_t runs		= random() % 4;
+
+		wildcards.assign(count, (iteration % 3 == 0) ? 1 : 0);
+
+		for (size_t run = 0; run < runs; run++)
+		{
+			size_t start	= random() % count;
+			size_t length	= 1 + random() % ((iteration % 2) ? 3 : 40);
+
+			for (size_t i = start; i < std::min(start + length, count); i++)
+				wildcards[i] ^= 1;
+		}
+
+		CrcPattern pattern(PackedDescriptor(&data[source], wildcards.data(), count));
+		size_t maxResults = (iteration % 5 == 0) ? (1 + random() % 4) : SIZE_MAX;
+
+		expected.clear();
+
+		for (size_t i = 0; i <= (size - count) && expected.size() < maxResults; i++)
+		{
+			if (pattern.MatchAt(data.data(), size, i))
+				expected.push_back(i);
+		}
+
+		for (auto method : { CRC_SCAN_ROLLING, CRC_SCAN_HARDWARE })
+		{
+			actual.clear();
+			pattern.Scan(data.data(), size, actual, maxResults, method);
+
+			if (actual != expected || expected.empty())
+				return false;
+		}
+
+		actual.clear();
+		pattern.Scan(data.data(), size, actual, maxResults);
+
+		if (actual != expected)
+			return false;
+
+		rolled += pattern.CanRoll() ? 1 : 0;
+	}
+
+	if (rolled < 100)
+		return false;
+
+	// Several chunks for the threaded scanner
+	data.resize(3 * 1024 * 1024 + 777);
+
+	for (auto& b : data)
+		b = (uint8_t)(random() % 4);
+
+	wildcards.assign(21, 0);
+	wildcards[5] = 1;
+
+	CrcPattern pattern(PackedDescriptor(&data[1024 * 1024 - 3], wildcards.data(), wildcards.size()));
+
+	expected.clear();
+	pattern.Scan(data.data(), data.size(), expected, SIZE_MAX);
+
+	actual.clear();
+	pattern.ScanParallel(data.data(), data.size(), [&](size_t Offset)
+	{
+		actual.push_back(Offset);
+		return true;
+	});
+
+	return !expected.empty() && actual == expected;
+}
\ No newline at end of file
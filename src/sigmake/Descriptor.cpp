@@ -12,234 +12,105 @@ SIG_DESCRIPTOR *AllocDescriptor(ULONG Count)
 	return temp;
 }
 
-void TrimDescriptor(SIG_DESCRIPTOR *Descriptor)
+ScanPattern CompileDescriptor(SIG_DESCRIPTOR *Descriptor)
 {
-	//
-	// This removes any TRAILING wildcards, so
-	// the loop starts from the end.
-	//
-	for (LONG i = Descriptor->Count - 1; i >= 0; i--)
-	{
-		if (Descriptor->Entries[i].Wildcard == 0)
-			break;
-
-		Descriptor->Count--;
-	}
+	return ScanPattern(PackDescriptor(Descriptor));
 }
 
-void ShortenDescriptor(SIG_DESCRIPTOR *Descriptor)
+PackedDescriptor PackDescriptor(SIG_DESCRIPTOR *Descriptor)
 {
-	//
-	// This shortens patterns by detecting the number
-	// of resulting matches. If there is more than one,
-	// return. The signature is as short as possible, but
-	// still accurate
-	//
-	std::vector<duint> results;
-
-	for (ULONG init = Descriptor->Count; Descriptor->Count >= 1;)
-	{
-		// Zero previous values
-		results.clear();
+	PackedDescriptor packed;
 
-		// Scan
-		PatternScan(Descriptor, results);
+	for (ULONG i = 0; i < Descriptor->Count; i++)
+		packed.Append(Descriptor->Entries[i].Value, Descriptor->Entries[i].Wildcard != 0);
 
-		// Was there more than 1 result?
-		if (results.size() > 1)
-		{
-			if (init != Descriptor->Count)
-				Descriptor->Count++;
+	return packed;
+}
 
-			return;
-		}
+SIG_DESCRIPTOR *UnpackDescriptor(const PackedDescriptor& Descriptor)
+{
+	SIG_DESCRIPTOR *desc = AllocDescriptor((ULONG)Descriptor.Count());
 
-		// Otherwise decrease the sig and repeat
-		Descriptor->Count--;
+	for (ULONG i = 0; i < desc->Count; i++)
+	{
+		desc->Entries[i].Value		= Descriptor.Value(i);
+		desc->Entries[i].Wildcard	= Descriptor.IsWildcard(i) ? 1 : 0;
 	}
+
+	return desc;
 }
 
 void DescriptorToCode(SIG_DESCRIPTOR *Descriptor, char **Data, char **Mask)
 {
-	//
 	// Allocate buffers for the resulting strings
-	//
-	size_t dataSize = Descriptor->Count * strlen("\\x00") + 1;
-	size_t maskSize = Descriptor->Count * strlen("x") + 1;
+	*Data = (char *)BridgeAlloc(CodeDataTextSize(Descriptor->Count));
+	*Mask = (char *)BridgeAlloc(CodeMaskTextSize(Descriptor->Count));
 
-	*Data = (char *)BridgeAlloc(dataSize);
-	*Mask = (char *)BridgeAlloc(maskSize);
-
-	for (ULONG i = 0; i < Descriptor->Count; i++)
-	{
-		if (Descriptor->Entries[i].Wildcard == 0)
-		{
-			char temp[16];
-			sprintf_s(temp, "\\x%02X", (DWORD)Descriptor->Entries[i].Value);
-
-			strcat_s(*Data, dataSize, temp);
-			strcat_s(*Mask, maskSize, "x");
-		}
-		else
-		{
-			strcat_s(*Data, dataSize, "\\x00");
-			strcat_s(*Mask, maskSize, "?");
-		}
-	}
+	PackedToCode(PackDescriptor(Descriptor), *Data, *Mask);
 }
 
 void DescriptorToIDA(SIG_DESCRIPTOR *Descriptor, char **Data)
 {
-	//
-	// Allocate buffers for the resulting strings.
 	// Worst case scenario: all are 2 bytes (No wildcards)
-	//
-	size_t dataSize = Descriptor->Count * strlen("00 ") + 1;
-	*Data			= (char *)BridgeAlloc(dataSize);
+	*Data = (char *)BridgeAlloc(IDATextSize(Descriptor->Count));
 
-	for (ULONG i = 0; i < Descriptor->Count; i++)
-	{
-		if (Descriptor->Entries[i].Wildcard == 0)
-		{
-			char temp[16];
-			sprintf_s(temp, "%02X ", (DWORD)Descriptor->Entries[i].Value);
-
-			strcat_s(*Data, dataSize, temp);
-		}
-		else
-		{
-			strcat_s(*Data, dataSize, "? ");
-		}
-	}
-
-	// Remove the final space
-	if (strrchr(*Data, ' '))
-		*strrchr(*Data, ' ') = '\0';
+	PackedToIDA(PackDescriptor(Descriptor), *Data);
 }
 
 void DescriptorToPEiD(SIG_DESCRIPTOR *Descriptor, char **Data)
 {
 	// Similar to IDA, allows for one more ? -> '00 00 ?? 99 99'
-	//
-	// Allocate buffers for the resulting strings.
-	// Worst case scenario: all are 2 bytes (No wildcards)
-	//
-	size_t dataSize = Descriptor->Count * strlen("00 ") + 1;
-	*Data			= (char *)BridgeAlloc(dataSize);
+	*Data = (char *)BridgeAlloc(IDATextSize(Descriptor->Count));
 
-	for (ULONG i = 0; i < Descriptor->Count; i++)
-	{
-		if (Descriptor->Entries[i].Wildcard == 0)
-		{
-			char temp[16];
-			sprintf_s(temp, "%02X ", (DWORD)Descriptor->Entries[i].Value);
-
-			strcat_s(*Data, dataSize, temp);
-		}
-		else
-		{
-			strcat_s(*Data, dataSize, "?? ");
-		}
-	}
-
-	// Remove the final space
-	if (strrchr(*Data, ' '))
-		*strrchr(*Data, ' ') = '\0';
+	PackedToPEiD(PackDescriptor(Descriptor), *Data);
 }
 
 void DescriptorToCRC(SIG_DESCRIPTOR *Descriptor, char **Data, char **Mask)
 {
-	// TODO
-	__debugbreak();
+	// Length and checksum, plus the wildcard layout if there is one
+	*Data = (char *)BridgeAlloc(CRCDataTextSize());
+	*Mask = (char *)BridgeAlloc(CodeMaskTextSize(Descriptor->Count));
+
+	PackedToCRC(PackDescriptor(Descriptor), *Data, *Mask);
 }
 
 SIG_DESCRIPTOR *DescriptorFromCode(const char *Data, const char *Mask)
 {
-	ULONG count = (ULONG)strlen(Mask);
-	SIG_DESCRIPTOR *desc = AllocDescriptor(count);
+	PackedDescriptor packed;
 
-	//
-	// \x00\x00\x00\x00
-	// xx?x
-	//
-	Data += 2;
+	if (!PackedFromCode(Data, Mask, packed))
+		return nullptr;
 
-	for (ULONG i = 0; i < count; i++)
-	{
-		if (Mask[0] == 'x')
-		{
-			desc->Entries[i].Value		= (BYTE)strtol(Data, nullptr, 16);
-			desc->Entries[i].Wildcard	= 0;
-		}
-		else
-		{
-			desc->Entries[i].Value		= 0;
-			desc->Entries[i].Wildcard	= 1;
-		}
-
-		Data += 4;
-		Mask += 1;
-	}
-
-	return desc;
+	return UnpackDescriptor(packed);
 }
 
 SIG_DESCRIPTOR *DescriptorFromIDA(const char *Data)
 {
-	// Get the number of entries by counting spaces + 1
-	size_t dataLen	= strlen(Data);
-	ULONG count		= 1;
+	PackedDescriptor packed;
 
-	for (size_t i = 0; i < dataLen; i++)
-	{
-		if (Data[i] == ' ')
-			count++;
-	}
-
-	SIG_DESCRIPTOR *desc = AllocDescriptor(count);
-
-	//
-	// 00 44 ? ? 66 ? 88 99
-	//
-	const char *dataStart	= Data;
-	const char *dataEnd		= Data + dataLen;
+	if (!PackedFromIDA(Data, packed))
+		return nullptr;
 
-	for (ULONG i = 0; Data < dataEnd; i++)
-	{
-		if (Data[0] == '?')
-		{
-			desc->Entries[i].Value		= 0;
-			desc->Entries[i].Wildcard	= 1;
-
-			// Skip over the '?' and space
-			Data += 2;
-		}
-		else
-		{
-			desc->Entries[i].Value		= (BYTE)strtol(Data, nullptr, 16);
-			desc->Entries[i].Wildcard	= 0;
-
-			// Skip over the BYTE and space
-			Data += 3;
-		}
-	}
-
-	return desc;
+	return UnpackDescriptor(packed);
 }
 
 SIG_DESCRIPTOR *DescriptorFromPEiD(const char *Data)
 {
-	// This is identical to IDA, just replace '??' with '?'
-	std::string newData(Data);
-	StringReplace(newData, "??", "?");
+	PackedDescriptor packed;
 
-	return DescriptorFromIDA(newData.c_str());
+	if (!PackedFromPEiD(Data, packed))
+		return nullptr;
+
+	return UnpackDescriptor(packed);
 }
 
-SIG_DESCRIPTOR *DescriptorFromCRC(const char *Data)
+std::unique_ptr<CrcPattern> CrcPatternFromText(const char *Data, const char *Mask)
 {
-	// TODO
-	__debugbreak();
+	PackedDescriptor layout;
+	uint32_t checksum;
+
+	if (!PackedFromCRC(Data, Mask, layout, checksum))
+		return nullptr;
 
-	return nullptr;
+	return std::unique_ptr<CrcPattern>(new CrcPattern(layout, checksum));
 }
\ No newline at end of file
@@ -24,8 +24,9 @@ struct SIG_DESCRIPTOR
 #pragma warning(pop)
 
 SIG_DESCRIPTOR *AllocDescriptor(ULONG Count);
-void TrimDescriptor(SIG_DESCRIPTOR *Descriptor);
-void ShortenDescriptor(SIG_DESCRIPTOR *Descriptor);
+ScanPattern CompileDescriptor(SIG_DESCRIPTOR *Descriptor);
+PackedDescriptor PackDescriptor(SIG_DESCRIPTOR *Descriptor);
+SIG_DESCRIPTOR *UnpackDescriptor(const PackedDescriptor& Descriptor);
 
 void DescriptorToCode(SIG_DESCRIPTOR *Descriptor, char **Data, char **Mask);
 void DescriptorToIDA(SIG_DESCRIPTOR *Descriptor, char **Data);
@@ -35,4 +36,6 @@ void DescriptorToCRC(SIG_DESCRIPTOR *Descriptor, char **Data, char **Mask);
 SIG_DESCRIPTOR *DescriptorFromCode(const char *Data, const char *Mask);
 SIG_DESCRIPTOR *DescriptorFromIDA(const char *Data);
 SIG_DESCRIPTOR *DescriptorFromPEiD(const char *Data);
-SIG_DESCRIPTOR *DescriptorFromCRC(const char *Data);
\ No newline at end of file
+
+// CRC signatures can't be turned back into bytes, only scanned for
+std::unique_ptr<CrcPattern> CrcPatternFromText(const char *Data, const char *Mask);
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "DescriptorText.h"
+
+static const char HexDigits[] = "0123456789ABCDEF";
+
+// Longest length accepted in a CRC signature
+const static size_t CRCTextMaxLength = 16 * 1024 * 1024;
+
+// Value of each hex digit character, -1 for everything else
+static const int8_t HexValues[256] =
+{
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+static inline int HexValue(char Character)
+{
+	return HexValues[(uint8_t)Character];
+}
+
+static inline bool IsTextSpace(char Character)
+{
+	return Character == ' ' || Character == '\t' || Character == '\r' || Character == '\n';
+}
+
+static inline const char *SkipTextSpace(const char *Data)
+{
+	while (IsTextSpace(*Data))
+		Data++;
+
+	return Data;
+}
+
+size_t CodeDataTextSize(size_t Count)
+{
+	return Count * 4 + 1;
+}
+
+size_t CodeMaskTextSize(size_t Count)
+{
+	return Count + 1;
+}
+
+size_t IDATextSize(size_t Count)
+{
+	return Count * 3 + 1;
+}
+
+size_t CRCDataTextSize()
+{
+	// 20 digit length, separator, 8 digit checksum
+	return 20 + 1 + 8 + 1;
+}
+
+size_t PackedToCode(const PackedDescriptor& Descriptor, char *Data, char *Mask)
+{
+	char *out = Data;
+
+	for (size_t i = 0; i < Descriptor.Count(); i++)
+	{
+		uint8_t value	= Descriptor.Value(i);	// Zero for wildcards
+		bool wildcard	= Descriptor.IsWildcard(i);
+
+		out[0] = '\\';
+		out[1] = 'x';
+		out[2] = HexDigits[value >> 4];
+		out[3] = HexDigits[value & 0xF];
+		out += 4;
+
+		Mask[i] = wildcard ? '?' : 'x';
+	}
+
+	Mask[Descriptor.Count()] = '\0';
+
+	*out = '\0';
+	return out - Data;
+}
+
+static size_t PackedToIDA(const PackedDescriptor& Descriptor, char *Data, size_t WildcardLength)
+{
+	char *out = Data;
+
+	for (size_t i = 0; i < Descriptor.Count(); i++)
+	{
+		if (i > 0)
+			*out++ = ' ';
+
+		if (Descriptor.IsWildcard(i))
+		{
+			for (size_t j = 0; j < WildcardLength; j++)
+				*out++ = '?';
+		}
+		else
+		{
+			uint8_t value = Descriptor.Value(i);
+
+			out[0] = HexDigits[value >> 4];
+			out[1] = HexDigits[value & 0xF];
+			out += 2;
+		}
+	}
+
+	*out = '\0';
+	return out - Data;
+}
+
+size_t PackedToIDA(const PackedDescriptor& Descriptor, char *Data)
+{
+	return PackedToIDA(Descriptor, Data, 1);
+}
+
+size_t PackedToPEiD(const PackedDescriptor& Descriptor, char *Data)
+{
+	return PackedToIDA(Descriptor, Data, 2);
+}
+
+size_t PackedToCRC(const PackedDescriptor& Descriptor, char *Data, char *Mask)
+{
+	char digits[20];
+	size_t digitCount	= 0;
+	size_t count		= Descriptor.Count();
+	char *out			= Data;
+
+	do
+	{
+		digits[digitCount++] = (char)('0' + count % 10);
+		count /= 10;
+	} while (count > 0);
+
+	while (digitCount > 0)
+		*out++ = digits[--digitCount];
+
+	*out++ = ':';
+
+	uint32_t checksum = CrcPattern(Descriptor).Checksum();
+
+	for (int shift = 28; shift >= 0; shift -= 4)
+		*out++ = HexDigits[(checksum >> shift) & 0xF];
+
+	*out = '\0';
+
+	// Only spell out the layout when it has wildcards
+	bool wildcards = false;
+
+	for (size_t i = 0; i < Descriptor.Count() && !wildcards; i++)
+		wildcards = Descriptor.IsWildcard(i);
+
+	for (size_t i = 0; i < Descriptor.Count() && wildcards; i++)
+		*Mask++ = Descriptor.IsWildcard(i) ? '?' : 'x';
+
+	*Mask = '\0';
+	return out - Data;
+}
+
+bool PackedFromCode(const char *Data, const char *Mask, PackedDescriptor& Descriptor)
+{
+	//
+	// \x00\x00\x00\x00
+	// xx?x
+	//
+	// Each mask character consumes one escaped byte, whatever is in between is whitespace.
+	//
+	Descriptor = PackedDescriptor();
+
+	for (Mask = SkipTextSpace(Mask); *Mask; Mask = SkipTextSpace(Mask + 1))
+	{
+		Data = SkipTextSpace(Data);
+
+		if (Data[0] != '\\' || (Data[1] != 'x' && Data[1] != 'X'))
+			return false;
+
+		int high	= HexValue(Data[2]);
+		int low		= (high >= 0) ? HexValue(Data[3]) : -1;
+
+		if (low < 0)
+			return false;
+
+		Data += 4;
+
+		if (*Mask != 'x' && *Mask != 'X' && *Mask != '?')
+			return false;
+
+		Descriptor.Append((uint8_t)((high << 4) | low), *Mask == '?');
+	}
+
+	// Both strings have to end together
+	return Descriptor.Count() > 0 && *SkipTextSpace(Data) == '\0';
+}
+
+bool PackedFromIDA(const char *Data, PackedDescriptor& Descriptor)
+{
+	//
+	// 00 44 ? ?? 66 ? 88 99
+	//
+	// Entries are a wildcard ('?' or '??') or one or two hex digits.
+	//
+	Descriptor = PackedDescriptor();
+
+	for (Data = SkipTextSpace(Data); *Data; Data = SkipTextSpace(Data))
+	{
+		if (Data[0] == '?')
+		{
+			Data += (Data[1] == '?') ? 2 : 1;
+			Descriptor.Append(0, true);
+			continue;
+		}
+
+		int value = HexValue(Data[0]);
+
+		if (value < 0)
+			return false;
+
+		Data++;
+
+		if (HexValue(Data[0]) >= 0)
+		{
+			value = (value << 4) | HexValue(Data[0]);
+			Data++;
+		}
+
+		Descriptor.Append((uint8_t)value, false);
+	}
+
+	return Descriptor.Count() > 0;
+}
+
+bool PackedFromPEiD(const char *Data, PackedDescriptor& Descriptor)
+{
+	// The IDA parser already takes '??'
+	return PackedFromIDA(Data, Descriptor);
+}
+
+bool PackedFromCRC(const char *Data, const char *Mask, PackedDescriptor& Layout, uint32_t& Checksum)
+{
+	//
+	// 40:1A2B3C4D
+	// xxxx?xxx... (optional)
+	//
+	Layout		= PackedDescriptor();
+	Checksum	= 0;
+
+	size_t count	= 0;
+	Data			= SkipTextSpace(Data);
+
+	if (*Data < '0' || *Data > '9')
+		return false;
+
+	for (; *Data >= '0' && *Data <= '9'; Data++)
+	{
+		count = count * 10 + (*Data - '0');
+
+		// Anything this long can't be a real signature
+		if (count > CRCTextMaxLength)
+			return false;
+	}
+
+	Data = SkipTextSpace(Data);
+
+	if (*Data++ != ':')
+		return false;
+
+	Data = SkipTextSpace(Data);
+
+	int digits = 0;
+
+	for (; HexValue(*Data) >= 0 && digits < 8; Data++, digits++)
+		Checksum = (Checksum << 4) | HexValue(*Data);
+
+	if (digits <= 0 || *SkipTextSpace(Data) != '\0')
+		return false;
+
+	for (Mask = SkipTextSpace(Mask); *Mask; Mask = SkipTextSpace(Mask + 1))
+	{
+		if (*Mask != 'x' && *Mask != 'X' && *Mask != '?')
+			return false;
+
+		Layout.Append(0, *Mask == '?');
+	}
+
+	// No mask means every byte is fixed
+	if (Layout.Count() <= 0)
+	{
+		for (size_t i = 0; i < count; i++)
+			Layout.Append(0, false);
+	}
+
+	return count > 0 && Layout.Count() == count;
+}
+
+#include "DescriptorTextTest.h"
\ No newline at end of file
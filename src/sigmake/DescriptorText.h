@@ -0,0 +1,35 @@
+#pragma once
+
+//
+// Single pass text codecs for the Code, IDA, PEiD and CRC signature formats. Encoders
+// write into caller allocated buffers (see the *TextSize helpers) and decoders
+// accept any whitespace between entries and both '?' and '??' as wildcards.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include "PackedDescriptor.h"
+#include "CrcPattern.h"
+
+// Buffer sizes including the null terminator
+size_t CodeDataTextSize(size_t Count);	// \x00\x00
+size_t CodeMaskTextSize(size_t Count);	// x?
+size_t IDATextSize(size_t Count);		// 00 ? 00, also used for PEiD (00 ?? 00)
+size_t CRCDataTextSize();				// 40:1A2B3C4D, the mask uses CodeMaskTextSize
+
+// Return the number of characters written to Data, excluding the terminator
+size_t PackedToCode(const PackedDescriptor& Descriptor, char *Data, char *Mask);
+size_t PackedToIDA(const PackedDescriptor& Descriptor, char *Data);
+size_t PackedToPEiD(const PackedDescriptor& Descriptor, char *Data);
+
+// "Length:Checksum" in decimal and hex. Mask is left empty when nothing is wildcarded.
+size_t PackedToCRC(const PackedDescriptor& Descriptor, char *Data, char *Mask);
+
+// Fail on malformed or empty input
+bool PackedFromCode(const char *Data, const char *Mask, PackedDescriptor& Descriptor);
+bool PackedFromIDA(const char *Data, PackedDescriptor& Descriptor);
+bool PackedFromPEiD(const char *Data, PackedDescriptor& Descriptor);
+
+// CRC signatures only give back the wildcard layout (all values are zero) and the checksum
+bool PackedFromCRC(const char *Data, const char *Mask, PackedDescriptor& Layout, uint32_t& Checksum);
+
+bool DescriptorTextSelfTest();
\ No newline at end of file
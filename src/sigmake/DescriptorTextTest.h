@@ -0,0 +1,109 @@
+#pragma once
+
+//
+// Round trips random descriptors through every text format, then parses a few
+// hand written strings with odd spacing and wildcard styles.
+//
+bool DescriptorTextSelfTest()
+{
+	uint32_t state = 0x6C8E9CF5;
+
+	auto random = [&state]()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	std::vector<char> data;
+	std::vector<char> mask;
+
+	for (int iteration = 0; iteration < 500; iteration++)
+	{
+		PackedDescriptor descriptor;
+		size_t count = 1 + random() % 300;
+
+		for (size_t i = 0; i < count; i++)
+			descriptor.Append((uint8_t)random(), (random() % 4) == 0);
+
+		PackedDescriptor decoded;
+
+		data.assign(CodeDataTextSize(count), '\xCC');
+		mask.assign(CodeMaskTextSize(count), '\xCC');
+
+		if (PackedToCode(descriptor, data.data(), mask.data()) != data.size() - 1)
+			return false;
+
+		if (!PackedFromCode(data.data(), mask.data(), decoded) || decoded != descriptor)
+			return false;
+
+		data.assign(IDATextSize(count), '\xCC');
+
+		if (PackedToIDA(descriptor, data.data()) >= data.size())
+			return false;
+
+		if (!PackedFromIDA(data.data(), decoded) || decoded != descriptor)
+			return false;
+
+		if (PackedToPEiD(descriptor, data.data()) >= data.size())
+			return false;
+
+		if (!PackedFromPEiD(data.data(), decoded) || decoded != descriptor)
+			return false;
+
+		// CRC text only keeps the layout and checksum
+		uint32_t checksum = 0;
+
+		data.assign(CRCDataTextSize(), '\xCC');
+		mask.assign(CodeMaskTextSize(count), '\xCC');
+
+		if (PackedToCRC(descriptor, data.data(), mask.data()) >= data.size())
+			return false;
+
+		if (!PackedFromCRC(data.data(), mask.data(), decoded, checksum) || checksum != CrcPattern(descriptor).Checksum())
+			return false;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (decoded.IsWildcard(i) != descriptor.IsWildcard(i))
+				return false;
+		}
+	}
+
+	// 8B ? ? 0F followed by nothing
+	const uint8_t values[]		= { 0x8B, 0x00, 0x00, 0x0F };
+	const uint8_t wildcards[]	= { 0, 1, 1, 0 };
+	PackedDescriptor expected(values, wildcards, 4);
+	PackedDescriptor decoded;
+
+	for (const char *text : { "8B ? ? 0F", "8b ?? ? 0f", "  8B\t?\r\n??   F  ", "8B????0F" })
+	{
+		if (!PackedFromIDA(text, decoded) || decoded != expected)
+			return false;
+	}
+
+	if (!PackedFromCode(" \\x8B\\x00 \\xff\\x0f\r\n", "x??x", decoded) || decoded != expected)
+		return false;
+
+	// Malformed input must be rejected
+	for (const char *text : { "", "   ", "8B ?? G0", "8B - 0F" })
+	{
+		if (PackedFromIDA(text, decoded))
+			return false;
+	}
+
+	uint32_t checksum = 0;
+
+	if (!PackedFromCRC(" 9 : e3069283 ", "", decoded, checksum) || checksum != 0xE3069283 || decoded.Count() != 9 || decoded.IsWildcard(8))
+		return false;
+
+	if (PackedFromCRC("9:E3069283", "xx", decoded, checksum) || PackedFromCRC("9:", "", decoded, checksum) || PackedFromCRC("99999999999999999999999:0", "", decoded, checksum))
+		return false;
+
+	if (PackedFromCode("\\x8B\\x00", "x??x", decoded) || PackedFromCode("\\x8B\\x00\\x00\\x0F", "xx", decoded) || PackedFromCode("\\x8B", "z", decoded))
+		return false;
+
+	return true;
+}
\ No newline at end of file
@@ -1,5 +1,3 @@
-#include <algorithm>
-#include <execution>
 #include <ctype.h>
 #include "../stdafx.h"
 
@@ -13,7 +11,7 @@ void BatchSigDialogInit(HWND hwndDlg)
 		"// 0x12345678\r\n"
 		"// 0x0987654312345678\r\n"
 		"//\r\n"
-		"// NOTE: This threaded scan may consume a large amount of memory depending on module size.\r\n"
+		"// NOTE: This threaded scan keeps one copy of each module involved in memory.\r\n"
 		"//\r\n";
 
 	SetWindowText(GetDlgItem(hwndDlg, IDC_SIGMAKE_EDIT1), message);
@@ -73,80 +71,54 @@ void BatchSigDialogExecute(HWND hwndDlg)
 
 	_plugin_logprintf("Parsed %d addresses in list, scanning...\n", addresses.size());
 
-	// Guess the amount of bytes needed for a unique signature starting from 10 and maxing out at ~50. This
-	// doesn't take function boundaries into account.
-	std::mutex descriptorLock;
+	BATCH_SIG_OPTIONS options = GetBatchSigOptions();
+
+	// Each module is only copied and scanned for one group of addresses
+	std::map<duint, std::vector<uint64_t>> modules;
 	std::map<duint, SIG_DESCRIPTOR *> descriptors;
+	std::map<duint, uint32_t> targetOffsets;
 
-	// Avoid a lock just to assign null descriptors
 	for (duint address : addresses)
+	{
+		modules[DbgFunctions()->ModBaseFromAddr(address)].push_back(address);
 		descriptors.emplace(address, nullptr);
+	}
 
-	std::for_each(std::execution::par_unseq, addresses.begin(), addresses.end(),
-	[&descriptorLock, &descriptors](duint Address)
+	for (auto& [moduleBase, moduleAddresses] : modules)
 	{
-		const uint32_t minSigLength = 10;
-		const uint32_t maxSigLength = 50;
-
-		// Keep a copy of the module in memory
-		duint moduleBase = DbgFunctions()->ModBaseFromAddr(Address);
-		duint moduleSize = DbgFunctions()->ModSizeFromAddr(moduleBase);
-		PBYTE processMemory = (PBYTE)BridgeAlloc(moduleSize);
-
-		if (!DbgMemRead(moduleBase, processMemory, moduleSize))
-		{
-			_plugin_logprintf("Couldn't read process memory for address 0x%llX\n", Address);
-			return;
-		}
+		SnapshotPtr module = SnapshotModule(moduleBase);
 
-		for (uint32_t length = 0; length < maxSigLength;)
+		if (!module)
 		{
-			// Gather some instructions to meet the minimum length
-			while (length < minSigLength)
-			{
-				DISASM_INSTR inst;
-				DbgDisasmAt(Address + length, &inst);
-
-				// Default to 1 byte on failure
-				length += max(inst.instr_size, 1);
-			}
-
-			SIG_DESCRIPTOR *desc = GenerateSigFromCode(Address, Address + length);
+			for (uint64_t address : moduleAddresses)
+				_plugin_logprintf("Couldn't read process memory for address 0x%llX\n", address);
 
-			std::vector<duint> results;
-			PatternScan(desc, results, moduleBase, moduleSize, processMemory);
-
-			if (results.empty())
-			{
-				BridgeFree(desc);
+			continue;
+		}
 
-				_plugin_logprintf("Unable to match any signatures for address 0x%llX. How did this happen?\n", Address);
-				break;
-			}
+		BATCH_SIG_MODULE batchModule;
+		batchModule.Base	= module->Base();
+		batchModule.Data	= module->Data();
+		batchModule.Size	= module->Size();
 
-			if (results.size() > 1)
-			{
-				BridgeFree(desc);
+#ifdef _WIN64
+		batchModule.Type = Decode64Bits;
+#else
+		batchModule.Type = Decode32Bits;
+#endif // _WIN64
 
-				// Multiple results. Disassemble yet another instruction.
-				DISASM_INSTR inst;
-				DbgDisasmAt(Address + length, &inst);
+		std::vector<BATCH_SIG_RESULT> results;
+		BatchSigGenerate(batchModule, options, moduleAddresses, results);
 
-				length += max(inst.instr_size, 1);
-			}
-			else
-			{
-				// Done.
-				descriptorLock.lock();
-				descriptors.insert_or_assign(Address, desc);
-				descriptorLock.unlock();
+		for (auto& result : results)
+		{
+			if (!result.Found)
+				continue;
 
-				break;
-			}
+			descriptors.insert_or_assign((duint)result.Address, UnpackDescriptor(result.Signature));
+			targetOffsets.insert_or_assign((duint)result.Address, result.TargetOffset);
 		}
-
-		BridgeFree(processMemory);
-	});
+	}
 
 	// Print out all of the results
 	for (auto& [address, desc] : descriptors)
@@ -156,6 +128,10 @@ void BatchSigDialogExecute(HWND hwndDlg)
 
 		if (desc)
 		{
+			// Anchor search may have picked an earlier instruction
+			if (targetOffsets[address] > 0)
+				_plugin_logprintf("0x%llX: Signature starts 0x%X bytes before the address\n", address, targetOffsets[address]);
+
 			switch (Settings::LastType)
 			{
 			case SIG_CODE:
@@ -174,6 +150,8 @@ void BatchSigDialogExecute(HWND hwndDlg)
 				break;
 
 			case SIG_CRC:
+				DescriptorToCRC(desc, &data, &mask);
+				_plugin_logprintf("0x%llX: %s, %s\n", address, data, mask);
 				break;
 			}
 		}
@@ -202,9 +180,6 @@ INT_PTR CALLBACK BatchSigDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPAR
 		// Check if the user has any code selected
 		BatchSigDialogInit(hwndDlg);
 
-		// TODO: CRC disabled until I can find a good piece of code for it
-		EnableWindow(GetDlgItem(hwndDlg, IDC_SIGMAKE_CRC), FALSE);
-
 		// Update the initial signature type selection button
 		switch (Settings::LastType)
 		{
@@ -11,6 +11,7 @@ namespace Settings
 	bool IncludeMemRefences;
 	bool IncludeRelAddresses;
 	bool UseSegments;
+	bool SearchAnchors;
 	SIGNATURE_TYPE LastType;
 
 	void InitIni()
@@ -53,6 +54,7 @@ namespace Settings
 		IncludeMemRefences	= GetProfileBool("IncludeMemRefences");
 		IncludeRelAddresses	= GetProfileBool("IncludeRelAddresses");
 		UseSegments         = GetProfileBool("UseSegments");
+		SearchAnchors		= GetProfileBool("SearchAnchors");
 		LastType			= (SIGNATURE_TYPE)GetPrivateProfileInt("Options", "LastType", 0, IniPath);
 	}
 
@@ -74,5 +76,6 @@ namespace Settings
 		SetProfileInt("IncludeRelAddresses",	IncludeRelAddresses);
 		SetProfileInt("LastType",				LastType);
 		SetProfileInt("UseSegments",            UseSegments);
+		SetProfileInt("SearchAnchors",			SearchAnchors);
 	}
 }
\ No newline at end of file
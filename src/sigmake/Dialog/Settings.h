@@ -9,6 +9,7 @@ namespace Settings
 	extern bool IncludeMemRefences;
 	extern bool IncludeRelAddresses;
 	extern bool UseSegments;
+	extern bool SearchAnchors;
 	extern SIGNATURE_TYPE LastType;
 
 	void InitIni();
@@ -10,7 +10,34 @@ void MakeSigDialogInit(HWND hwndDlg)
 	if (!GuiSelectionGet(GUI_DISASSEMBLY, &selection))
 		return;
 
-	SIG_DESCRIPTOR *desc = GenerateSigFromCode(selection.start, selection.end);
+	SIG_DESCRIPTOR *desc = nullptr;
+
+	if (Settings::SearchAnchors)
+	{
+		//
+		// The search starts from the selection start and the signature may begin earlier.
+		// A selection of more than one instruction still bounds its length, as it does
+		// without searching.
+		//
+		BASIC_INSTRUCTION_INFO info;
+		DbgDisasmFastAt(selection.start, &info);
+
+		duint selectionSize	= selection.end - selection.start + 1;
+		uint32_t maxLength	= 0;
+
+		if (selection.end >= selection.start && selectionSize > (duint)info.size)
+			maxLength = (uint32_t)std::min<duint>(selectionSize, UINT32_MAX);
+
+		uint32_t targetOffset = 0;
+		desc = SearchSigFromCode(selection.start, &targetOffset, maxLength);
+
+		if (desc && targetOffset > 0)
+			_plugin_logprintf("Signature starts 0x%X bytes before the selected address\n", targetOffset);
+	}
+	else
+	{
+		desc = GenerateSigFromCode(selection.start, selection.end);
+	}
 
 	if (!desc)
 		return;
@@ -66,12 +93,28 @@ void MakeSigDialogConvert(HWND hwndDlg, SIGNATURE_TYPE To, SIGNATURE_TYPE From)
 	case SIG_CODE:	inDesc = DescriptorFromCode(data, mask);	break;
 	case SIG_IDA:	inDesc = DescriptorFromIDA(data);			break;
 	case SIG_PEID:	inDesc = DescriptorFromPEiD(data);			break;
-	case SIG_CRC:	inDesc = DescriptorFromCRC(data);			break;
+	case SIG_CRC:	break;
 	}
 
 	BridgeFree(data);
 	BridgeFree(mask);
 
+	if (From == SIG_CRC)
+	{
+		// The checksum doesn't keep the original bytes
+		_plugin_logprintf("CRC signatures can't be converted to other types\n");
+
+		SetWindowText(GetDlgItem(hwndDlg, IDC_SIGMAKE_EDIT1), "");
+		SetWindowText(GetDlgItem(hwndDlg, IDC_SIGMAKE_EDIT2), "");
+		return;
+	}
+
+	if (!inDesc)
+	{
+		_plugin_logprintf("Unable to parse the signature\n");
+		return;
+	}
+
 	data = nullptr;
 	mask = nullptr;
 
@@ -108,48 +151,44 @@ void MakeSigDialogExecute(HWND hwndDlg)
 	GetWindowText(GetDlgItem(hwndDlg, IDC_SIGMAKE_EDIT1), data, dataLen);
 	GetWindowText(GetDlgItem(hwndDlg, IDC_SIGMAKE_EDIT2), mask, maskLen);
 
-	// Convert the string to a code descriptor
+	// Convert the string to a code descriptor (or a checksum for CRC)
 	SIG_DESCRIPTOR *desc = nullptr;
+	std::unique_ptr<CrcPattern> crc;
 
 	switch (Settings::LastType)
 	{
-	case SIG_CODE:	desc = DescriptorFromCode(data, mask);	break;
-	case SIG_IDA:	desc = DescriptorFromIDA(data);			break;
-	case SIG_PEID:	desc = DescriptorFromPEiD(data);		break;
-	case SIG_CRC:	desc = DescriptorFromCRC(data);			break;
+	case SIG_CODE:	desc = DescriptorFromCode(data, mask);		break;
+	case SIG_IDA:	desc = DescriptorFromIDA(data);				break;
+	case SIG_PEID:	desc = DescriptorFromPEiD(data);			break;
+	case SIG_CRC:	crc = CrcPatternFromText(data, mask);		break;
 	}
 
-	// Scan & log it to the GUI
-	std::vector<duint> results;
-	PatternScan(desc, results);
-
-	GuiReferenceDeleteAllColumns();
-	GuiReferenceAddColumn(20, "Address");
-	GuiReferenceAddColumn(100, "Disassembly");
-	GuiReferenceSetRowCount((int)results.size());
-	GuiReferenceSetProgress(0);
-	GuiShowReferences();
-
-	int i = 0;
-	for (auto& match : results)
+	if (!desc && !crc)
 	{
-		DISASM_INSTR inst;
-		DbgDisasmAt(match, &inst);
-
-		char temp[32];
-		sprintf_s(temp, "%p", (PVOID)match);
+		_plugin_logprintf("Unable to parse the signature\n");
 
-		GuiReferenceSetCellContent(i, 0, temp);
-		GuiReferenceSetCellContent(i++, 1, inst.instruction);
+		BridgeFree(data);
+		BridgeFree(mask);
+		return;
 	}
 
+	// Scan & log it to the GUI
+	std::vector<duint> results;
+
+	if (crc)
+		PatternScan(*crc, results);
+	else
+		PatternScan(desc, results);
+
+	// Rows are filled in the background
+	ShowScanResults(results);
 	_plugin_logprintf("Found %d references(s)\n", results.size());
-	GuiReferenceSetProgress(100);
-	GuiUpdateAllViews();
 
 	BridgeFree(data);
 	BridgeFree(mask);
-	BridgeFree(desc);
+
+	if (desc)
+		BridgeFree(desc);
 }
 
 INT_PTR CALLBACK MakeSigDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam)
@@ -161,9 +200,6 @@ INT_PTR CALLBACK MakeSigDialogProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARA
 		// Check if the user has any code selected
 		MakeSigDialogInit(hwndDlg);
 
-		// TODO: CRC disabled until I can find a good piece of code for it
-		EnableWindow(GetDlgItem(hwndDlg, IDC_SIGMAKE_CRC), FALSE);
-
 		// Update the initial signature type selection button
 		switch (Settings::LastType)
 		{
@@ -0,0 +1,94 @@
+#include "MemoryIndex.h"
+#include <string.h>
+#include <algorithm>
+#include <utility>
+
+// Lookups done side by side in the batch version
+const size_t MemoryIndexBatchWidth = 8;
+
+MemoryIndex::MemoryIndex()
+{
+	m_Built = false;
+	Build();
+}
+
+void MemoryIndex::Add(uint64_t Start, uint64_t End)
+{
+	if (End <= Start)
+		return;
+
+	m_Starts.push_back(Start);
+	m_Sizes.push_back(End - Start);
+	m_Built = false;
+}
+
+void MemoryIndex::Build()
+{
+	if (m_Built)
+		return;
+
+	std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+	for (size_t i = 0; i < m_Starts.size(); i++)
+	{
+		if (m_Sizes[i] != 0)
+			ranges.emplace_back(m_Starts[i], m_Starts[i] + m_Sizes[i]);
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+
+	// Entry 0 is the empty sentinel, adjacent and overlapping ranges are merged
+	m_Starts.assign(1, 0);
+	m_Sizes.assign(1, 0);
+
+	for (auto& range : ranges)
+	{
+		uint64_t end = m_Starts.back() + m_Sizes.back();
+
+		if (m_Sizes.back() != 0 && range.first <= end)
+			m_Sizes.back() = std::max(end, range.second) - m_Starts.back();
+		else if (range.first == 0)
+			m_Sizes.back() = range.second;
+		else
+		{
+			m_Starts.push_back(range.first);
+			m_Sizes.push_back(range.second - range.first);
+		}
+	}
+
+	m_Built = true;
+}
+
+void MemoryIndex::IsReadable(const uint64_t *Addresses, size_t Count, uint8_t *Results) const
+{
+	// Independent searches over the same array, so a group of them runs in parallel
+	// instead of one dependent chain of loads at a time
+	size_t i = 0;
+
+	for (; i + MemoryIndexBatchWidth <= Count; i += MemoryIndexBatchWidth)
+	{
+		size_t index[MemoryIndexBatchWidth];
+		size_t count = m_Starts.size();
+
+		for (size_t j = 0; j < MemoryIndexBatchWidth; j++)
+			index[j] = 0;
+
+		while (count > 1)
+		{
+			size_t half = count / 2;
+
+			for (size_t j = 0; j < MemoryIndexBatchWidth; j++)
+				index[j] = (m_Starts[index[j] + half] <= Addresses[i + j]) ? index[j] + half : index[j];
+
+			count -= half;
+		}
+
+		for (size_t j = 0; j < MemoryIndexBatchWidth; j++)
+			Results[i + j] = (Addresses[i + j] - m_Starts[index[j]]) < m_Sizes[index[j]];
+	}
+
+	for (; i < Count; i++)
+		Results[i] = IsReadable(Addresses[i]);
+}
+
+#include "MemoryIndexTest.h"
\ No newline at end of file
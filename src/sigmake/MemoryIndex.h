@@ -0,0 +1,63 @@
+#pragma once
+
+//
+// A local copy of which address ranges of the debuggee are readable, built once from
+// the memory map so pointer checks during signature generation don't have to go
+// through the bridge for every operand.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class MemoryIndex
+{
+public:
+	MemoryIndex();
+
+	// [Start, End) is readable. Ranges can be added in any order and may overlap.
+	void Add(uint64_t Start, uint64_t End);
+
+	// Sorts and merges the ranges; required after adding and before any lookup
+	void Build();
+
+	size_t Count() const
+	{
+		return m_Starts.size();
+	}
+
+	bool IsReadable(uint64_t Address) const
+	{
+		size_t index = Find(Address);
+		return (Address - m_Starts[index]) < m_Sizes[index];
+	}
+
+	// Results[i] = IsReadable(Addresses[i]), with the searches interleaved
+	void IsReadable(const uint64_t *Addresses, size_t Count, uint8_t *Results) const;
+
+private:
+	//
+	// Index of the last range starting at or before Address. A branch-free binary
+	// search over the sorted starts; a sentinel range (0, size 0) makes every address
+	// land on some entry so no bounds checks are needed.
+	//
+	size_t Find(uint64_t Address) const
+	{
+		const uint64_t *base	= m_Starts.data();
+		size_t count			= m_Starts.size();
+
+		while (count > 1)
+		{
+			size_t half = count / 2;
+			base		= (base[half] <= Address) ? base + half : base;
+			count		-= half;
+		}
+
+		return (size_t)(base - m_Starts.data());
+	}
+
+	std::vector<uint64_t> m_Starts;
+	std::vector<uint64_t> m_Sizes;
+	bool m_Built;
+};
+
+bool MemoryIndexSelfTest();
\ No newline at end of file
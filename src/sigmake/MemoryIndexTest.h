@@ -0,0 +1,79 @@
+#pragma once
+
+//
+// Checks lookups against a plain scan of the ranges: overlapping, adjacent and
+// zero-based ranges, the addresses right around every boundary and random ones,
+// through both the single and the batch lookup.
+//
+bool MemoryIndexSelfTest()
+{
+	MemoryIndex empty;
+
+	if (empty.IsReadable(0) || empty.IsReadable(0x1000) || empty.IsReadable(UINT64_MAX))
+		return false;
+
+	std::vector<std::pair<uint64_t, uint64_t>> ranges =
+	{
+		{ 0x0, 0x1000 },
+		{ 0x10000, 0x20000 },
+		{ 0x18000, 0x30000 },			// Overlaps the previous one
+		{ 0x30000, 0x31000 },			// Adjacent
+		{ 0x7FFE0000, 0x7FFE1000 },
+		{ 0x40000, 0x40000 },			// Empty
+		{ 0x140000000, 0x140123000 },
+		{ 0xFFFFFFFFFFFFF000, 0xFFFFFFFFFFFFFFFF },
+	};
+
+	MemoryIndex index;
+
+	// Reversed, since the order they are added in shouldn't matter
+	for (auto it = ranges.rbegin(); it != ranges.rend(); ++it)
+		index.Add(it->first, it->second);
+
+	index.Build();
+
+	// The overlapping and adjacent ranges are merged, the empty one dropped
+	if (index.Count() != 5)
+		return false;
+
+	std::vector<uint64_t> addresses;
+
+	for (auto& range : ranges)
+	{
+		for (uint64_t delta : { 0ull, 1ull })
+		{
+			addresses.push_back(range.first - delta);
+			addresses.push_back(range.first + delta);
+			addresses.push_back(range.second - delta);
+			addresses.push_back(range.second + delta);
+		}
+	}
+
+	uint64_t seed = 0x9E3779B97F4A7C15;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+
+		// Mostly low addresses, where the ranges are
+		addresses.push_back((i & 1) ? (seed & 0x1FFFFFFFF) : seed);
+	}
+
+	std::vector<uint8_t> results(addresses.size());
+	index.IsReadable(addresses.data(), addresses.size(), results.data());
+
+	for (size_t i = 0; i < addresses.size(); i++)
+	{
+		bool expected = false;
+
+		for (auto& range : ranges)
+			expected |= addresses[i] >= range.first && addresses[i] < range.second;
+
+		if (index.IsReadable(addresses[i]) != expected || (results[i] != 0) != expected)
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
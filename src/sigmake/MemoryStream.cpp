@@ -0,0 +1,120 @@
+#include "MemoryStream.h"
+#include <string.h>
+#include <algorithm>
+
+MemoryStream::MemoryStream(size_t WindowSize, size_t PageSize)
+{
+	m_PageSize			= std::max<size_t>(PageSize, 1);
+	m_WindowSize		= std::max(((WindowSize + m_PageSize - 1) / m_PageSize) * m_PageSize, m_PageSize * 2);
+	m_UnreadablePages	= 0;
+	m_WindowPage		= 0;
+	m_Start				= 0;
+}
+
+bool MemoryStream::Scan(uint64_t Start, uint64_t End, size_t Overlap, const MemoryStreamRead& Read, const MemoryStreamCallback& Callback)
+{
+	m_UnreadablePages = 0;
+
+	if (End <= Start)
+		return true;
+
+	// Windows move by whole pages, so the bitmap only ever shifts by whole entries
+	size_t overlap		= ((Overlap + m_PageSize - 1) / m_PageSize) * m_PageSize;
+	size_t windowSize	= std::max(m_WindowSize, overlap * 2);
+	size_t step			= windowSize - overlap;
+
+	m_Window.resize(windowSize);
+	m_ValidPages.assign((windowSize / m_PageSize) + 1, false);
+	m_WindowPage	= Start / m_PageSize;
+	m_Start			= Start;
+
+	uint64_t windowStart	= Start;
+	size_t length			= 0;	// Bytes already in the window
+
+	auto isValid = [&](size_t Offset)
+	{
+		return m_ValidPages[(size_t)(((windowStart + Offset) / m_PageSize) - m_WindowPage)];
+	};
+
+	auto nextPage = [&](size_t Offset)
+	{
+		return (size_t)((((windowStart + Offset) / m_PageSize) + 1) * m_PageSize - windowStart);
+	};
+
+	for (;;)
+	{
+		size_t size		= (size_t)std::min<uint64_t>(windowSize, End - windowStart);
+		size_t count	= (size_t)std::min<uint64_t>(step, End - windowStart);
+
+		if (length < size)
+		{
+			ReadPages(windowStart + length, length, size - length, Read);
+			length = size;
+		}
+
+		// Every run of readable pages that starts a match in this window
+		for (size_t offset = 0; offset < count;)
+		{
+			if (!isValid(offset))
+			{
+				offset = nextPage(offset);
+				continue;
+			}
+
+			size_t runEnd = offset;
+
+			while (runEnd < size && isValid(runEnd))
+				runEnd = std::min(nextPage(runEnd), size);
+
+			if (!Callback(windowStart + offset, m_Window.data() + offset, runEnd - offset, std::min(runEnd, count) - offset))
+				return false;
+
+			offset = runEnd;
+		}
+
+		if ((End - windowStart) <= step)
+			break;
+
+		// The overlap becomes the start of the next window
+		size_t pages = step / m_PageSize;
+
+		memmove(m_Window.data(), m_Window.data() + step, size - step);
+		m_ValidPages.erase(m_ValidPages.begin(), m_ValidPages.begin() + pages);
+		m_ValidPages.resize((windowSize / m_PageSize) + 1, false);
+
+		m_WindowPage	+= pages;
+		windowStart		+= step;
+		length			= size - step;
+	}
+
+	return true;
+}
+
+void MemoryStream::ReadPages(uint64_t Address, size_t Offset, size_t Size, const MemoryStreamRead& Read)
+{
+	// Only fall back to single pages when the full read fails
+	bool whole = Read(Address, m_Window.data() + Offset, Size);
+
+	for (size_t done = 0; done < Size;)
+	{
+		uint64_t address	= Address + done;
+		size_t piece		= (size_t)std::min<uint64_t>(m_PageSize - (address % m_PageSize), Size - done);
+		bool readable		= whole || Read(address, m_Window.data() + Offset + done, piece);
+
+		// A page split between two reads is only valid if both parts were, and only counted once
+		size_t page	= (size_t)((address / m_PageSize) - m_WindowPage);
+		bool first	= (address % m_PageSize) == 0 || address == m_Start;
+		bool valid	= first || m_ValidPages[page];
+
+		if (!readable)
+		{
+			memset(m_Window.data() + Offset + done, 0, piece);
+			m_UnreadablePages += valid ? 1 : 0;
+		}
+
+		m_ValidPages[page] = readable && valid;
+		done += piece;
+	}
+}
+
+#include "MemoryStreamTest.h"
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+//
+// Walks a memory range of any size through one fixed-size window, so scanners never
+// hold more than that in memory. Consecutive windows overlap, pages that can't be
+// read are tracked in a bitmap and left out, and every byte is read only once.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <functional>
+
+// Default window size in bytes (rounded up to whole pages)
+const size_t MemoryStreamWindowSize	= 1024 * 1024;
+const size_t MemoryStreamPageSize	= 0x1000;
+
+// Fills Buffer with the Size bytes at Address; false if any of them couldn't be read
+typedef std::function<bool(uint64_t Address, uint8_t *Buffer, size_t Size)> MemoryStreamRead;
+
+//
+// Data holds Size readable bytes at Address. Matches starting at Data[0] up to (but not
+// including) Data[Count] belong to this call; the bytes after that are only there so
+// they can be completed. Return false to stop early.
+//
+typedef std::function<bool(uint64_t Address, const uint8_t *Data, size_t Size, size_t Count)> MemoryStreamCallback;
+
+class MemoryStream
+{
+public:
+	MemoryStream(size_t WindowSize = MemoryStreamWindowSize, size_t PageSize = MemoryStreamPageSize);
+
+	//
+	// Hands out [Start, End) in runs of readable bytes. Each start position is handed out
+	// exactly once and followed by at least Overlap bytes, unless the range or the
+	// readable run ends earlier. Returns false if the callback stopped it.
+	//
+	bool Scan(uint64_t Start, uint64_t End, size_t Overlap, const MemoryStreamRead& Read, const MemoryStreamCallback& Callback);
+
+	// Pages found unreadable during the last scan
+	size_t UnreadablePages() const
+	{
+		return m_UnreadablePages;
+	}
+
+private:
+	void ReadPages(uint64_t Address, size_t Offset, size_t Size, const MemoryStreamRead& Read);
+
+	size_t m_WindowSize;
+	size_t m_PageSize;
+	size_t m_UnreadablePages;
+
+	// The window, and whether each page of it was readable (indexed from the page of its first byte)
+	std::vector<uint8_t> m_Window;
+	std::vector<bool> m_ValidPages;
+	uint64_t m_WindowPage;
+	uint64_t m_Start;		// Of the current scan, the only read that may begin mid-page
+};
+
+bool MemoryStreamSelfTest();
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+//
+// Streams simulated memory with a few unreadable pages (any read touching one fails)
+// through small windows, from aligned and unaligned starts. Every readable start
+// position has to be handed out exactly once with the right bytes and enough of the
+// following ones, unreadable ones never, and stopping early has to stop the scan.
+// Every unreadable page is counted once, even when two reads split it.
+//
+bool MemoryStreamSelfTest()
+{
+	const size_t pageSize	= 0x100;
+	const uint64_t base		= 0x10000;
+
+	std::vector<uint8_t> memory(pageSize * 40);
+
+	for (size_t i = 0; i < memory.size(); i++)
+		memory[i] = (uint8_t)((i * 131) ^ (i >> 8));
+
+	auto unreadable = [&](uint64_t Page)
+	{
+		return Page == 3 || Page == 4 || Page == 17 || Page == 39;
+	};
+
+	auto read = [&](uint64_t Address, uint8_t *Buffer, size_t Size)
+	{
+		for (uint64_t page = (Address - base) / pageSize; page <= (Address - base + Size - 1) / pageSize; page++)
+		{
+			if (unreadable(page))
+				return false;
+		}
+
+		memcpy(Buffer, &memory[(size_t)(Address - base)], Size);
+		return true;
+	};
+
+	for (size_t windowSize : { 1, 0x300, 0x1000 })
+	{
+		for (size_t overlap : { 0, 1, 0x80, 0x100, 0x450 })
+		{
+			for (uint64_t start : { base, base + 0x37, base + pageSize * 5 })
+			{
+				uint64_t end = base + memory.size() - ((start == base) ? 0 : 0x21);
+
+				MemoryStream stream(windowSize, pageSize);
+				std::vector<int> seen(memory.size(), 0);
+				bool valid = true;
+
+				stream.Scan(start, end, overlap, read, [&](uint64_t Address, const uint8_t *Data, size_t Size, size_t Count)
+				{
+					size_t offset = (size_t)(Address - base);
+
+					valid = valid && Count > 0 && Count <= Size && Address >= start && (Address + Size) <= end &&
+						memcmp(Data, &memory[offset], Size) == 0;
+
+					for (size_t i = 0; valid && i < Size; i++)
+						valid = !unreadable((offset + i) / pageSize);
+
+					// Cut short only by the end of the range or an unreadable page
+					uint64_t needed = Address + Count - 1 + overlap + 1;
+					uint64_t limit	= Address + Size;
+
+					valid = valid && (limit >= needed || limit == end || unreadable((limit - base) / pageSize));
+
+					for (size_t i = 0; i < Count; i++)
+						seen[offset + i]++;
+
+					return true;
+				});
+
+				size_t unreadablePages = 0;
+
+				for (size_t i = 0; i < memory.size() && valid; i++)
+				{
+					bool inRange = (base + i) >= start && (base + i) < end;
+					valid = seen[i] == ((inRange && !unreadable(i / pageSize)) ? 1 : 0);
+
+					if (inRange && unreadable(i / pageSize) && (i % pageSize == 0 || (base + i) == start))
+						unreadablePages++;
+				}
+
+				if (!valid || stream.UnreadablePages() != unreadablePages)
+					return false;
+			}
+		}
+	}
+
+	// Stopping early
+	MemoryStream stream(0x200, pageSize);
+	int calls = 0;
+
+	if (stream.Scan(base, base + memory.size(), 0, read, [&](uint64_t Address, const uint8_t *Data, size_t Size, size_t Count) { return ++calls < 2; }) || calls != 2)
+		return false;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "MultiBuild.h"
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Longest possible x86 instruction
+const uint32_t MultiBuildInstructionMax	= 15;
+
+// Uniqueness checks stop tracking matches past this and rescan instead
+const size_t MultiBuildCandidateLimit	= 4096;
+
+// Locating looks at this many times more code than ends up in the signature
+const uint32_t MultiBuildLocateFactor	= 4;
+
+static bool MultiBuildDecode(const PEImage& Reference, size_t Offset, const BatchSigFilter& Filter, size_t MaxLength, PackedDescriptor& Signature, std::vector<size_t>& Boundaries)
+{
+	size_t codeSize = std::min<size_t>(Reference.Size() - Offset, MaxLength + MultiBuildInstructionMax);
+	std::vector<_DInst> instructions(codeSize);
+	unsigned int count = 0;
+
+	_CodeInfo info;
+	memset(&info, 0, sizeof(_CodeInfo));
+
+	info.codeOffset	= (_OffsetType)(Reference.Base() + Offset);
+	info.code		= Reference.Data() + Offset;
+	info.codeLen	= (int)codeSize;
+	info.dt			= Reference.Is64() ? Decode64Bits : Decode32Bits;
+	info.features	= DF_NONE;
+
+	if (distorm_decompose(&info, instructions.data(), (unsigned int)instructions.size(), &count) == DECRES_INPUTERR)
+		return false;
+
+	// Relocated bytes change with the load address even when the code doesn't
+	for (unsigned int i = 0; i < count && Signature.Count() < MaxLength; i++)
+	{
+		size_t start		= Offset + Signature.Count();
+		const uint8_t *data	= Reference.Data() + start;
+
+		// Default to 1 byte on failure
+		int size = std::max<int>(instructions[i].size, 1);
+		uint8_t wildcards[MultiBuildInstructionMax] = {};
+
+		if (Filter)
+			Filter(&instructions[i], data, wildcards);
+
+		for (int j = 0; j < size; j++)
+			Signature.Append(data[j], wildcards[j] != 0 || Reference.IsRelocated((uint32_t)(start + j)));
+
+		Boundaries.push_back(Signature.Count());
+	}
+
+	return !Boundaries.empty();
+}
+
+// Returns the match offset, or the boundary where the build stopped matching in End (0 if it never did)
+static bool MultiBuildLocateWindow(const PEImage& Build, const PackedDescriptor& Signature, const std::vector<size_t>& Boundaries, size_t Start, bool Parallel, size_t& Offset, size_t& End)
+{
+	PackedDescriptor window;
+
+	for (size_t i = Start; i < Signature.Count(); i++)
+		window.Append(Signature.Value(i), Signature.IsWildcard(i));
+
+	ScanCandidates candidates(Build.Data(), Build.Size(), MultiBuildCandidateLimit, Parallel);
+	ScanPattern pattern(window);
+
+	End = 0;
+
+	for (size_t boundary : Boundaries)
+	{
+		if (boundary <= Start)
+			continue;
+
+		pattern.Resize(boundary - Start);
+		size_t count = candidates.Update(pattern);
+
+		if (count == 0)
+		{
+			End = boundary;
+			return false;
+		}
+
+		if (count > 1)
+			continue;
+
+		// The candidate set only keeps ambiguous results, so look the match up again
+		std::vector<size_t> match;
+
+		for (size_t offset : candidates.Offsets())
+		{
+			if (pattern.MatchAt(Build.Data(), Build.Size(), offset))
+				match.push_back(offset);
+		}
+
+		if (match.empty())
+			pattern.Scan(Build.Data(), Build.Size(), match, 1);
+
+		if (match.empty() || match[0] < Start)
+			return false;
+
+		Offset = match[0] - Start;
+		return true;
+	}
+
+	return false;
+}
+
+static bool MultiBuildLocate(const PEImage& Build, const PackedDescriptor& Signature, const std::vector<size_t>& Boundaries, bool Parallel, uint64_t& Location)
+{
+	// Grow a window of the reference code until it matches only once. If the build
+	// changed inside the window, start over after the instruction that differs, so the
+	// target is found as long as some stretch of code following it is unchanged.
+	for (size_t start = 0; start < Signature.Count();)
+	{
+		size_t offset;
+		size_t end;
+
+		if (MultiBuildLocateWindow(Build, Signature, Boundaries, start, Parallel, offset, end))
+		{
+			Location = Build.Base() + offset;
+			return true;
+		}
+
+		if (end == 0)
+			break;
+
+		start = end;
+	}
+
+	return false;
+}
+
+static void MultiBuildLocateAll(const std::vector<PEImage>& Builds, const PackedDescriptor& Signature, const std::vector<size_t>& Boundaries, std::vector<uint64_t>& Locations)
+{
+	Locations.assign(Builds.size(), 0);
+
+	// One build per worker; with fewer builds than cores the scans split up as well
+	size_t coreCount	= std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	size_t threadCount	= std::min(coreCount, Builds.size());
+	bool parallel		= Builds.size() < coreCount;
+
+	std::atomic<size_t> nextBuild(0);
+
+	auto worker = [&]()
+	{
+		for (size_t i; (i = nextBuild.fetch_add(1)) < Builds.size();)
+		{
+			if (!MultiBuildLocate(Builds[i], Signature, Boundaries, parallel, Locations[i]))
+				Locations[i] = 0;
+		}
+	};
+
+	std::vector<std::thread> threads;
+
+	for (size_t i = 1; i < threadCount; i++)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+bool MultiBuildGenerate(const PEImage& Reference, uint64_t Address, const std::vector<PEImage>& Builds, const MULTI_BUILD_OPTIONS& Options, MULTI_BUILD_RESULT& Result)
+{
+	Result.Found		= false;
+	Result.Signature	= PackedDescriptor();
+	Result.Locations.clear();
+
+	if (Address < Reference.Base() || Address >= (Reference.Base() + Reference.Size()))
+		return false;
+
+	size_t offset = (size_t)(Address - Reference.Base());
+
+	PackedDescriptor reference;
+	std::vector<size_t> boundaries;
+
+	if (!MultiBuildDecode(Reference, offset, Options.Filter, Options.MaxLength * MultiBuildLocateFactor, reference, boundaries))
+		return false;
+
+	MultiBuildLocateAll(Builds, reference, boundaries, Result.Locations);
+
+	// Only bytes that are fixed in the reference and identical (and not relocated) in
+	// every build stay fixed. Builds are compared position by position, so code that
+	// was inserted in the middle wildcards everything after it.
+	size_t length = reference.Count();
+
+	for (size_t boundary : boundaries)
+	{
+		// Like BatchSig, the instruction that crosses MaxLength is the last one
+		if (boundary >= Options.MaxLength)
+		{
+			length = boundary;
+			break;
+		}
+	}
+
+	for (size_t i = 0; i < Builds.size(); i++)
+	{
+		if (Result.Locations[i] == 0)
+			return false;
+
+		length = std::min<size_t>(length, Builds[i].Base() + Builds[i].Size() - Result.Locations[i]);
+	}
+
+	PackedDescriptor merged;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		uint8_t value	= Reference.Data()[offset + i];
+		bool wildcard	= reference.IsWildcard(i);
+
+		for (size_t j = 0; j < Builds.size() && !wildcard; j++)
+		{
+			size_t buildOffset = (size_t)(Result.Locations[j] - Builds[j].Base()) + i;
+
+			if (Builds[j].Data()[buildOffset] != value || Builds[j].IsRelocated((uint32_t)buildOffset))
+				wildcard = true;
+		}
+
+		merged.Append(value, wildcard);
+	}
+
+	// Grow by whole instructions until every image has exactly one match. Each pattern
+	// refines the previous one, so only the previous matches are checked again.
+	std::vector<ScanCandidates> candidates;
+	candidates.emplace_back(Reference.Data(), Reference.Size(), MultiBuildCandidateLimit);
+
+	for (auto& build : Builds)
+		candidates.emplace_back(build.Data(), build.Size(), MultiBuildCandidateLimit);
+
+	ScanPattern pattern(merged);
+	size_t ambiguousLength = 0;
+
+	auto isUnique = [&]()
+	{
+		for (auto& image : candidates)
+		{
+			if (image.Update(pattern) != 1)
+				return false;
+		}
+
+		return true;
+	};
+
+	for (size_t boundary : boundaries)
+	{
+		if (boundary > length)
+			break;
+
+		if (boundary < Options.MinLength && boundary != length)
+			continue;
+
+		pattern.Resize(boundary);
+
+		if (!isUnique())
+		{
+			ambiguousLength = boundary;
+			continue;
+		}
+
+		// Anything longer than the last ambiguous prefix still refines it
+		size_t high = boundary;
+
+		if (Options.Shorten)
+		{
+			size_t low = ambiguousLength + 1;
+
+			while (low < high)
+			{
+				size_t mid = low + (high - low) / 2;
+
+				pattern.Resize(mid);
+
+				if (isUnique())
+					high = mid;
+				else
+					low = mid + 1;
+			}
+		}
+
+		merged.Resize(high);
+
+		if (Options.Trim)
+			merged.Trim();
+
+		Result.Found		= true;
+		Result.Signature	= std::move(merged);
+		return true;
+	}
+
+	return false;
+}
+
+#include "MultiBuildTest.h"
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+//
+// Signatures that keep working across builds of a module: the target is located in
+// every other build, bytes that differ between builds (or that the loader relocates)
+// become wildcards and the signature grows until it is unique in all of them at once.
+//
+#include "BatchSig.h"
+#include "PEImage.h"
+
+struct MULTI_BUILD_OPTIONS
+{
+	uint32_t MinLength;		// Instructions are added until this many bytes are used
+	uint32_t MaxLength;		// Give up once a signature would grow past this
+	bool Trim;				// Remove trailing wildcards
+	bool Shorten;			// Cut the unique signature down to the shortest unique prefix
+
+	// Wildcard policy for the reference instructions, also used to find them in the
+	// other builds. Empty keeps every byte.
+	BatchSigFilter Filter;
+};
+
+struct MULTI_BUILD_RESULT
+{
+	bool Found;
+	std::vector<uint64_t> Locations;	// Target address in Builds[i], 0 if it couldn't be located
+	PackedDescriptor Signature;			// Starts at the target in every image
+};
+
+//
+// Locating runs on one thread per build: the reference code from the target on is
+// grown until it matches only once in the build, starting over past any instruction
+// the build changed.
+//
+bool MultiBuildGenerate(const PEImage& Reference, uint64_t Address, const std::vector<PEImage>& Builds, const MULTI_BUILD_OPTIONS& Options, MULTI_BUILD_RESULT& Result);
+
+bool MultiBuildSelfTest();
\ No newline at end of file
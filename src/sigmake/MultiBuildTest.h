@@ -0,0 +1,110 @@
+#pragma once
+
+//
+// Two "builds" of a generated image: one with code inserted before the targets and
+// one with code removed, both with a few bytes changed here and there. Every target
+// that is found has to be located at its shifted address, and the signature has to
+// match there and nowhere else in all three images.
+//
+static size_t MultiBuildTestCount(const PEImage& Image, const PackedDescriptor& Signature)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; Signature.Count() <= Image.Size() && i <= (Image.Size() - Signature.Count()); i++)
+	{
+		if (Signature.MatchAt(Image.Data(), Image.Size(), i))
+			count++;
+	}
+
+	return count;
+}
+
+bool MultiBuildSelfTest()
+{
+	uint32_t state = 0x6B43A9B5;
+
+	auto random = [&state]()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	// Copies of a few "functions" that only differ in a byte here and there
+	std::vector<uint8_t> image(64 * 1024);
+	std::vector<uint8_t> function(4096);
+
+	for (auto& b : function)
+		b = (uint8_t)random();
+
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = ((random() % 64) == 0) ? (uint8_t)random() : function[i % function.size()];
+
+	// The other builds move everything past 0x800 and change about one byte in 512
+	const size_t shiftOffset	= 0x800;
+	const size_t inserted		= 0x123;
+	const size_t removed		= 0x40;
+
+	std::vector<uint8_t> inserting(image.begin(), image.begin() + shiftOffset);
+	std::vector<uint8_t> removing(image.begin(), image.begin() + shiftOffset);
+
+	for (size_t i = 0; i < inserted; i++)
+		inserting.push_back((uint8_t)random());
+
+	inserting.insert(inserting.end(), image.begin() + shiftOffset, image.end());
+	removing.insert(removing.end(), image.begin() + shiftOffset + removed, image.end());
+
+	for (auto build : { &inserting, &removing })
+	{
+		for (auto& b : *build)
+			b = ((random() % 512) == 0) ? (uint8_t)random() : b;
+	}
+
+	std::vector<PEImage> builds(2);
+	PEImage reference;
+
+	reference.LoadMapped(image.data(), image.size(), 0x400000, true);
+	builds[0].LoadMapped(inserting.data(), inserting.size(), 0x500000, true);
+	builds[1].LoadMapped(removing.data(), removing.size(), 0x600000, true);
+
+	MULTI_BUILD_OPTIONS options;
+	options.MinLength	= 10;
+	options.MaxLength	= 200;
+	options.Trim		= false;
+	options.Shorten		= true;
+	options.Filter		= BatchSigRelocationFilter;
+
+	size_t found = 0;
+
+	for (int i = 0; i < 32; i++)
+	{
+		size_t offset = shiftOffset + removed + (random() % (image.size() - shiftOffset - removed - 0x400));
+
+		MULTI_BUILD_RESULT result;
+
+		if (!MultiBuildGenerate(reference, reference.Base() + offset, builds, options, result))
+			continue;
+
+		if (result.Locations.size() != 2 || result.Locations[0] != (builds[0].Base() + offset + inserted) || result.Locations[1] != (builds[1].Base() + offset - removed))
+			return false;
+
+		if (!result.Signature.MatchAt(reference.Data(), reference.Size(), offset) || MultiBuildTestCount(reference, result.Signature) != 1)
+			return false;
+
+		for (size_t j = 0; j < builds.size(); j++)
+		{
+			if (!result.Signature.MatchAt(builds[j].Data(), builds[j].Size(), (size_t)(result.Locations[j] - builds[j].Base())))
+				return false;
+
+			if (MultiBuildTestCount(builds[j], result.Signature) != 1)
+				return false;
+		}
+
+		found++;
+	}
+
+	// Most targets are far enough from a changed byte to be located
+	return found >= 16;
+}
\ No newline at end of file
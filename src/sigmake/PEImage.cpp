@@ -0,0 +1,293 @@
+#include "PEImage.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// winnt.h values, which aren't available here
+const uint16_t PEDosSignature		= 0x5A4D;
+const uint32_t PENtSignature		= 0x00004550;
+const uint16_t PEMagic32			= 0x10B;
+const uint16_t PEMagic64			= 0x20B;
+const uint32_t PESectionHeaderSize	= 40;
+const uint32_t PEDirectoryBaseReloc	= 5;
+
+static uint16_t PERead16(const uint8_t *Data)
+{
+	uint16_t value;
+	memcpy(&value, Data, sizeof(value));
+	return value;
+}
+
+static uint32_t PERead32(const uint8_t *Data)
+{
+	uint32_t value;
+	memcpy(&value, Data, sizeof(value));
+	return value;
+}
+
+static uint64_t PERead64(const uint8_t *Data)
+{
+	uint64_t value;
+	memcpy(&value, Data, sizeof(value));
+	return value;
+}
+
+PEImage::PEImage()
+{
+	m_Base	= 0;
+	m_Is64	= false;
+}
+
+void PEImage::Clear()
+{
+	m_Base	= 0;
+	m_Is64	= false;
+
+	m_Data.clear();
+	m_Sections.clear();
+	m_Directories.clear();
+	m_Relocations.clear();
+}
+
+bool PEImage::ReadHeaders(const uint8_t *Data, size_t Size, uint32_t& ImageSize, uint32_t& HeaderSize)
+{
+	if (Size < 0x40 || PERead16(Data) != PEDosSignature)
+		return false;
+
+	// NT signature and file header
+	size_t ntOffset = PERead32(Data + 0x3C);
+
+	if (ntOffset > Size || (Size - ntOffset) < 24 || PERead32(Data + ntOffset) != PENtSignature)
+		return false;
+
+	const uint8_t *fileHeader	= Data + ntOffset + 4;
+	uint32_t sectionCount		= PERead16(fileHeader + 2);
+	uint32_t optionalSize		= PERead16(fileHeader + 16);
+	size_t optionalOffset		= ntOffset + 24;
+
+	if ((Size - optionalOffset) < optionalSize)
+		return false;
+
+	// Only the image base and the data directories differ between PE32 and PE32+
+	const uint8_t *optional = Data + optionalOffset;
+	uint32_t countOffset;
+	uint32_t directoryOffset;
+
+	if (optionalSize >= 112 && PERead16(optional) == PEMagic64)
+	{
+		m_Is64			= true;
+		m_Base			= PERead64(optional + 24);
+		countOffset		= 108;
+		directoryOffset	= 112;
+	}
+	else if (optionalSize >= 96 && PERead16(optional) == PEMagic32)
+	{
+		m_Is64			= false;
+		m_Base			= PERead32(optional + 28);
+		countOffset		= 92;
+		directoryOffset	= 96;
+	}
+	else
+	{
+		return false;
+	}
+
+	ImageSize	= PERead32(optional + 56);
+	HeaderSize	= PERead32(optional + 60);
+
+	if (ImageSize == 0 || ImageSize > PEImageMaxSize)
+		return false;
+
+	uint32_t directoryCount = std::min(PERead32(optional + countOffset), (optionalSize - directoryOffset) / 8);
+
+	for (uint32_t i = 0; i < directoryCount; i++)
+	{
+		const uint8_t *directory = optional + directoryOffset + (i * 8);
+		m_Directories.emplace_back(PERead32(directory), PERead32(directory + 4));
+	}
+
+	size_t sectionOffset = optionalOffset + optionalSize;
+
+	if (sectionCount > ((Size - sectionOffset) / PESectionHeaderSize))
+		return false;
+
+	for (uint32_t i = 0; i < sectionCount; i++)
+	{
+		const uint8_t *header = Data + sectionOffset + (i * PESectionHeaderSize);
+
+		PE_SECTION section;
+		memcpy(section.Name, header, 8);
+		section.Name[8]				= '\0';
+		section.VirtualSize			= PERead32(header + 8);
+		section.VirtualAddress		= PERead32(header + 12);
+		section.SizeOfRawData		= PERead32(header + 16);
+		section.PointerToRawData	= PERead32(header + 20);
+		section.Characteristics		= PERead32(header + 36);
+
+		m_Sections.push_back(section);
+	}
+
+	return true;
+}
+
+void PEImage::ReadRelocations()
+{
+	uint32_t rva;
+	uint32_t size;
+
+	if (!DataDirectory(PEDirectoryBaseReloc, rva, size) || rva >= m_Data.size())
+		return;
+
+	// Blocks of 16-bit entries, each one a 4-bit type and a 12-bit page offset
+	size_t end = std::min<size_t>((size_t)rva + size, m_Data.size());
+
+	for (size_t block = rva; (block + 8) <= end;)
+	{
+		uint32_t page		= PERead32(&m_Data[block]);
+		uint32_t blockSize	= PERead32(&m_Data[block + 4]);
+
+		if (blockSize < 8 || blockSize > (end - block))
+			break;
+
+		for (size_t entry = block + 8; (entry + 2) <= (block + blockSize); entry += 2)
+		{
+			uint16_t value = PERead16(&m_Data[entry]);
+
+			PE_RELOCATION relocation;
+			relocation.Rva = page + (value & 0xFFF);
+
+			switch (value >> 12)
+			{
+			case 0:		continue;						// ABSOLUTE (padding)
+			case 3:		relocation.Size = 4; break;		// HIGHLOW
+			case 10:	relocation.Size = 8; break;		// DIR64
+			default:	relocation.Size = 2; break;		// HIGH, LOW and friends
+			}
+
+			if (relocation.Rva < m_Data.size() && relocation.Size <= (m_Data.size() - relocation.Rva))
+				m_Relocations.push_back(relocation);
+		}
+
+		block += blockSize;
+	}
+
+	std::sort(m_Relocations.begin(), m_Relocations.end(), [](const PE_RELOCATION& A, const PE_RELOCATION& B)
+	{
+		return A.Rva < B.Rva;
+	});
+}
+
+bool PEImage::Load(const uint8_t *File, size_t Size)
+{
+	Clear();
+
+	uint32_t imageSize;
+	uint32_t headerSize;
+
+	if (!ReadHeaders(File, Size, imageSize, headerSize))
+	{
+		Clear();
+		return false;
+	}
+
+	m_Data.assign(imageSize, 0);
+	memcpy(m_Data.data(), File, std::min<size_t>(std::min(headerSize, imageSize), Size));
+
+	// Anything past the raw data (or the end of the file) stays zero, like the loader does
+	for (auto& section : m_Sections)
+	{
+		if (section.VirtualAddress >= imageSize || section.PointerToRawData >= Size)
+			continue;
+
+		size_t copySize = std::min<size_t>(section.SizeOfRawData, Size - section.PointerToRawData);
+		copySize = std::min<size_t>(copySize, imageSize - section.VirtualAddress);
+
+		memcpy(&m_Data[section.VirtualAddress], File + section.PointerToRawData, copySize);
+	}
+
+	ReadRelocations();
+	return true;
+}
+
+bool PEImage::LoadFile(const char *Path)
+{
+	Clear();
+
+	FILE *file = nullptr;
+
+#ifdef _MSC_VER
+	fopen_s(&file, Path, "rb");
+#else
+	file = fopen(Path, "rb");
+#endif // _MSC_VER
+
+	if (!file)
+		return false;
+
+	std::vector<uint8_t> data;
+
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long size = ftell(file);
+
+		if (size > 0 && size <= (long)PEImageMaxSize && fseek(file, 0, SEEK_SET) == 0)
+		{
+			data.resize((size_t)size);
+			data.resize(fread(data.data(), 1, data.size(), file));
+		}
+	}
+
+	fclose(file);
+	return !data.empty() && Load(data.data(), data.size());
+}
+
+void PEImage::LoadMapped(const uint8_t *Data, size_t Size, uint64_t Base, bool Is64)
+{
+	Clear();
+
+	m_Data.assign(Data, Data + Size);
+
+	// Headers in a dump are optional; without them it is just a blob
+	uint32_t imageSize;
+	uint32_t headerSize;
+
+	if (ReadHeaders(m_Data.data(), m_Data.size(), imageSize, headerSize))
+	{
+		ReadRelocations();
+	}
+	else
+	{
+		m_Sections.clear();
+		m_Directories.clear();
+	}
+
+	m_Base	= Base;
+	m_Is64	= Is64;
+}
+
+bool PEImage::DataDirectory(uint32_t Index, uint32_t& Rva, uint32_t& Size) const
+{
+	if (Index >= m_Directories.size() || m_Directories[Index].first == 0 || m_Directories[Index].second == 0)
+		return false;
+
+	Rva		= m_Directories[Index].first;
+	Size	= m_Directories[Index].second;
+	return true;
+}
+
+bool PEImage::IsRelocated(uint32_t Rva) const
+{
+	// Find the last relocation starting at or before Rva
+	auto next = std::upper_bound(m_Relocations.begin(), m_Relocations.end(), Rva, [](uint32_t Value, const PE_RELOCATION& Relocation)
+	{
+		return Value < Relocation.Rva;
+	});
+
+	if (next == m_Relocations.begin())
+		return false;
+
+	--next;
+	return (Rva - next->Rva) < next->Size;
+}
+
+#include "PEImageTest.h"
\ No newline at end of file
@@ -0,0 +1,92 @@
+#pragma once
+
+//
+// A PE file laid out the way the loader would map it, at its preferred base, along
+// with its sections and base relocations. It only needs the raw file, so signatures
+// can be built from other builds of a module without running them.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <utility>
+
+// Images larger than this are treated as corrupt instead of allocated
+const uint32_t PEImageMaxSize = 1024 * 1024 * 1024;
+
+struct PE_SECTION
+{
+	char Name[9];
+	uint32_t VirtualAddress;
+	uint32_t VirtualSize;
+	uint32_t PointerToRawData;
+	uint32_t SizeOfRawData;
+	uint32_t Characteristics;
+};
+
+struct PE_RELOCATION
+{
+	uint32_t Rva;
+	uint32_t Size;			// 4 for HIGHLOW, 8 for DIR64
+};
+
+class PEImage
+{
+public:
+	PEImage();
+
+	// Maps a PE file from memory or from disk
+	bool Load(const uint8_t *File, size_t Size);
+	bool LoadFile(const char *Path);
+
+	// Takes a buffer that is already in image layout (a memory dump) as is. Sections and
+	// relocations are read from its headers if it has any.
+	void LoadMapped(const uint8_t *Data, size_t Size, uint64_t Base, bool Is64);
+
+	uint64_t Base() const
+	{
+		return m_Base;
+	}
+
+	const uint8_t *Data() const
+	{
+		return m_Data.data();
+	}
+
+	size_t Size() const
+	{
+		return m_Data.size();
+	}
+
+	bool Is64() const
+	{
+		return m_Is64;
+	}
+
+	const std::vector<PE_SECTION>& Sections() const
+	{
+		return m_Sections;
+	}
+
+	// Rva and Size of data directory Index, false if it is missing or empty
+	bool DataDirectory(uint32_t Index, uint32_t& Rva, uint32_t& Size) const;
+
+	// True if the byte at Rva is rewritten by a base relocation
+	bool IsRelocated(uint32_t Rva) const;
+
+private:
+	bool ReadHeaders(const uint8_t *Data, size_t Size, uint32_t& ImageSize, uint32_t& HeaderSize);
+	void ReadRelocations();
+	void Clear();
+
+	uint64_t m_Base;
+	bool m_Is64;
+
+	std::vector<uint8_t> m_Data;
+	std::vector<PE_SECTION> m_Sections;
+	std::vector<std::pair<uint32_t, uint32_t>> m_Directories;
+
+	// Sorted by Rva
+	std::vector<PE_RELOCATION> m_Relocations;
+};
+
+bool PEImageSelfTest();
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+//
+// Builds a small PE32+ file in memory (a code section with one DIR64 relocation and
+// a .reloc section), then checks the mapped layout, the relocation lookup and that
+// truncated files are rejected instead of read past.
+//
+static void PEImageTestPut(std::vector<uint8_t>& File, size_t Offset, uint64_t Value, size_t Size)
+{
+	memcpy(&File[Offset], &Value, Size);
+}
+
+bool PEImageSelfTest()
+{
+	std::vector<uint8_t> file(0x800, 0);
+
+	PEImageTestPut(file, 0x00, PEDosSignature, 2);
+	PEImageTestPut(file, 0x3C, 0x80, 4);
+	PEImageTestPut(file, 0x80, PENtSignature, 4);
+
+	// File header: machine, 2 sections, optional header size
+	PEImageTestPut(file, 0x84, 0x8664, 2);
+	PEImageTestPut(file, 0x86, 2, 2);
+	PEImageTestPut(file, 0x94, 0xF0, 2);
+
+	// Optional header: magic, image base, image size, header size, 16 directories
+	const size_t optional = 0x98;
+	PEImageTestPut(file, optional + 0, PEMagic64, 2);
+	PEImageTestPut(file, optional + 24, 0x140000000ull, 8);
+	PEImageTestPut(file, optional + 56, 0x3000, 4);
+	PEImageTestPut(file, optional + 60, 0x400, 4);
+	PEImageTestPut(file, optional + 108, 16, 4);
+	PEImageTestPut(file, optional + 112 + (PEDirectoryBaseReloc * 8), 0x2000, 4);
+	PEImageTestPut(file, optional + 112 + (PEDirectoryBaseReloc * 8) + 4, 12, 4);
+
+	// .text at 0x1000 from 0x400, .reloc at 0x2000 from 0x600
+	const size_t sections = optional + 0xF0;
+	memcpy(&file[sections], ".text", 5);
+	PEImageTestPut(file, sections + 8, 0x180, 4);
+	PEImageTestPut(file, sections + 12, 0x1000, 4);
+	PEImageTestPut(file, sections + 16, 0x200, 4);
+	PEImageTestPut(file, sections + 20, 0x400, 4);
+
+	memcpy(&file[sections + 40], ".reloc", 6);
+	PEImageTestPut(file, sections + 48, 12, 4);
+	PEImageTestPut(file, sections + 52, 0x2000, 4);
+	PEImageTestPut(file, sections + 56, 0x200, 4);
+	PEImageTestPut(file, sections + 60, 0x600, 4);
+
+	for (size_t i = 0; i < 0x200; i++)
+		file[0x400 + i] = (uint8_t)(i * 7 + 1);
+
+	// One block for page 0x1000: a DIR64 at 0x10 and a padding entry
+	PEImageTestPut(file, 0x600, 0x1000, 4);
+	PEImageTestPut(file, 0x604, 12, 4);
+	PEImageTestPut(file, 0x608, (10 << 12) | 0x10, 2);
+
+	PEImage image;
+
+	if (!image.Load(file.data(), file.size()))
+		return false;
+
+	if (image.Base() != 0x140000000ull || !image.Is64() || image.Size() != 0x3000 || image.Sections().size() != 2)
+		return false;
+
+	if (strcmp(image.Sections()[1].Name, ".reloc") != 0 || memcmp(image.Data() + 0x1000, &file[0x400], 0x200) != 0 || image.Data()[0x1200] != 0)
+		return false;
+
+	for (uint32_t rva = 0x1000; rva < 0x1020; rva++)
+	{
+		if (image.IsRelocated(rva) != (rva >= 0x1010 && rva < 0x1018))
+			return false;
+	}
+
+	// A dump of the mapped image finds the same relocations at its own base
+	PEImage mapped;
+	mapped.LoadMapped(image.Data(), image.Size(), 0x7FF600000000ull, true);
+
+	if (mapped.Base() != 0x7FF600000000ull || mapped.Sections().size() != 2 || !mapped.IsRelocated(0x1017) || mapped.IsRelocated(0x1018))
+		return false;
+
+	// Cut off inside the section table
+	if (image.Load(file.data(), sections + 60))
+		return false;
+
+	return true;
+}
\ No newline at end of file
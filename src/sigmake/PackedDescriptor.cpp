@@ -0,0 +1,97 @@
+#include "PackedDescriptor.h"
+#include <string.h>
+
+bool PackedMatch(const uint8_t *Data, const uint8_t *Values, const uint32_t *WildcardMask, size_t Count)
+{
+	size_t i = 0;
+
+	// Eight bytes at a time: spread 8 mask bits over whole bytes and compare the rest
+	for (; (i + 8) <= Count; i += 8)
+	{
+		uint64_t wild	= (WildcardMask[i >> 5] >> (i & 31)) & 0xFF;
+		uint64_t spread	= (wild * 0x0101010101010101ull) & 0x8040201008040201ull;
+		uint64_t bytes	= (((spread + 0x7F7F7F7F7F7F7F7Full) & 0x8080808080808080ull) >> 7) * 0xFF;
+
+		uint64_t data;
+		uint64_t values;
+		memcpy(&data, Data + i, sizeof(uint64_t));
+		memcpy(&values, Values + i, sizeof(uint64_t));
+
+		if (((data ^ values) & ~bytes) != 0)
+			return false;
+	}
+
+	for (; i < Count; i++)
+	{
+		if (((WildcardMask[i >> 5] >> (i & 31)) & 1) == 0 && Data[i] != Values[i])
+			return false;
+	}
+
+	return true;
+}
+
+PackedDescriptor::PackedDescriptor()
+{
+	m_Count = 0;
+}
+
+PackedDescriptor::PackedDescriptor(const uint8_t *Values, const uint8_t *Wildcards, size_t Count)
+{
+	m_Count = 0;
+	m_Values.reserve(Count);
+	m_WildcardMask.reserve((Count + 31) / 32);
+
+	for (size_t i = 0; i < Count; i++)
+		Append(Values[i], Wildcards[i] != 0);
+}
+
+bool PackedDescriptor::operator==(const PackedDescriptor& Other) const
+{
+	return m_Count == Other.m_Count && m_Values == Other.m_Values && m_WildcardMask == Other.m_WildcardMask;
+}
+
+void PackedDescriptor::Append(uint8_t Value, bool Wildcard)
+{
+	if ((m_Count & 31) == 0)
+		m_WildcardMask.push_back(0xFFFFFFFF);
+
+	if (!Wildcard)
+		m_WildcardMask[m_Count >> 5] &= ~(1u << (m_Count & 31));
+
+	m_Values.push_back(Wildcard ? 0 : Value);
+	m_Count++;
+}
+
+void PackedDescriptor::Resize(size_t Count)
+{
+	while (m_Count < Count)
+		Append(0, true);
+
+	if (Count >= m_Count)
+		return;
+
+	m_Count = Count;
+	m_Values.resize(Count);
+	m_WildcardMask.resize((Count + 31) / 32);
+
+	if ((Count & 31) != 0)
+		m_WildcardMask.back() |= 0xFFFFFFFF << (Count & 31);
+}
+
+void PackedDescriptor::Trim()
+{
+	size_t count = m_Count;
+
+	while (count > 0 && IsWildcard(count - 1))
+		count--;
+
+	Resize(count);
+}
+
+bool PackedDescriptor::MatchAt(const uint8_t *Data, size_t Size, size_t Offset) const
+{
+	if (Offset > Size || m_Count > (Size - Offset))
+		return false;
+
+	return PackedMatch(Data + Offset, m_Values.data(), m_WildcardMask.data(), m_Count);
+}
\ No newline at end of file
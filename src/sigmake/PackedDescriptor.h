@@ -0,0 +1,69 @@
+#pragma once
+
+//
+// A signature stored as two planes: the byte values (zero where wildcarded) and a
+// bitmask with one bit per byte, set for wildcards. Bits past the end are always set.
+// This takes a little over one byte per entry instead of the two SIG_DESCRIPTOR uses,
+// and it is what ScanPattern compiles from.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+// Compares Count bytes of Data against the planes; WildcardMask must cover Count bits
+bool PackedMatch(const uint8_t *Data, const uint8_t *Values, const uint32_t *WildcardMask, size_t Count);
+
+class PackedDescriptor
+{
+public:
+	PackedDescriptor();
+
+	// Wildcards[i] != 0 marks Values[i] as "don't care"
+	PackedDescriptor(const uint8_t *Values, const uint8_t *Wildcards, size_t Count);
+
+	bool operator==(const PackedDescriptor& Other) const;
+	bool operator!=(const PackedDescriptor& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	size_t Count() const
+	{
+		return m_Count;
+	}
+
+	const uint8_t *Values() const
+	{
+		return m_Values.data();
+	}
+
+	const uint32_t *WildcardMask() const
+	{
+		return m_WildcardMask.data();
+	}
+
+	uint8_t Value(size_t Index) const
+	{
+		return m_Values[Index];
+	}
+
+	bool IsWildcard(size_t Index) const
+	{
+		return ((m_WildcardMask[Index >> 5] >> (Index & 31)) & 1) != 0;
+	}
+
+	void Append(uint8_t Value, bool Wildcard);
+
+	// Growing appends wildcards
+	void Resize(size_t Count);
+
+	// Removes trailing wildcards
+	void Trim();
+
+	bool MatchAt(const uint8_t *Data, size_t Size, size_t Offset) const;
+
+private:
+	size_t m_Count;
+	std::vector<uint8_t> m_Values;
+	std::vector<uint32_t> m_WildcardMask;
+};
\ No newline at end of file
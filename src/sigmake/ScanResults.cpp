@@ -0,0 +1,149 @@
+#include "stdafx.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+// Rows handed to the references view per update
+const static size_t ScanResultsPageSize = 256;
+
+struct RESULT_MODULE
+{
+	SnapshotPtr Snapshot;
+	char Name[MAX_MODULE_SIZE];
+};
+
+static std::mutex g_ResultsLock;
+static std::thread g_ResultsThread;
+static std::atomic<bool> g_ResultsCancel;
+
+static const RESULT_MODULE *GetResultModule(duint Address, std::map<duint, RESULT_MODULE>& Modules)
+{
+	duint moduleBase = DbgFunctions()->ModBaseFromAddr(Address);
+
+	if (moduleBase == 0)
+		return nullptr;
+
+	auto itr = Modules.find(moduleBase);
+
+	if (itr == Modules.end())
+	{
+		RESULT_MODULE& module = Modules[moduleBase];
+		module.Snapshot = SnapshotModule(moduleBase);
+
+		if (!DbgFunctions()->ModNameFromAddr(moduleBase, module.Name, true))
+			strcpy_s(module.Name, "");
+
+		return &module;
+	}
+
+	return &itr->second;
+}
+
+static void DisassembleResult(duint Address, const RESULT_MODULE *Module, char *Buffer, size_t BufferSize)
+{
+	const ModuleSnapshot *module = Module ? Module->Snapshot.get() : nullptr;
+
+	// Anything outside of a module copy goes through the debugger
+	if (!module || Address < module->Base() || Address >= (module->Base() + module->Size()))
+	{
+		DISASM_INSTR inst;
+		DbgDisasmAt(Address, &inst);
+
+		strcpy_s(Buffer, BufferSize, inst.instruction);
+		return;
+	}
+
+	duint offset = Address - module->Base();
+
+	_CodeInfo info;
+	memset(&info, 0, sizeof(_CodeInfo));
+
+	info.codeOffset	= Address;
+	info.code		= module->Data() + offset;
+	info.codeLen	= (int)min(module->Size() - offset, (duint)15);
+	info.features	= DF_NONE;
+
+#ifdef _WIN64
+	info.dt = Decode64Bits;
+#else
+	info.dt = Decode32Bits;
+#endif // _WIN64
+
+	_DInst instruction;
+	_DecodedInst text;
+	unsigned int count = 0;
+
+	if (distorm_decompose(&info, &instruction, 1, &count) == DECRES_INPUTERR || count <= 0)
+	{
+		strcpy_s(Buffer, BufferSize, "???");
+		return;
+	}
+
+	distorm_format(&info, &instruction, &text);
+
+	// Match the debugger's lower case style
+	sprintf_s(Buffer, BufferSize, "%s%s%s", (char *)text.mnemonic.p, (text.operands.length > 0) ? " " : "", (char *)text.operands.p);
+	_strlwr_s(Buffer, BufferSize);
+}
+
+static void PopulateResults(std::vector<duint> Results)
+{
+	std::map<duint, RESULT_MODULE> modules;
+
+	for (size_t page = 0; page < Results.size() && !g_ResultsCancel; page += ScanResultsPageSize)
+	{
+		size_t end = min(page + ScanResultsPageSize, Results.size());
+
+		for (size_t i = page; i < end; i++)
+		{
+			const RESULT_MODULE *module = GetResultModule(Results[i], modules);
+
+			char temp[256];
+			sprintf_s(temp, "%p", (PVOID)Results[i]);
+			GuiReferenceSetCellContent((int)i, 0, temp);
+
+			GuiReferenceSetCellContent((int)i, 1, module ? module->Name : "");
+
+			DisassembleResult(Results[i], module, temp, sizeof(temp));
+			GuiReferenceSetCellContent((int)i, 2, temp);
+		}
+
+		GuiReferenceSetProgress((int)((end * 100) / Results.size()));
+		GuiReferenceReloadData();
+	}
+
+	GuiReferenceSetProgress(100);
+}
+
+static void StopScanResultsLocked()
+{
+	g_ResultsCancel = true;
+
+	if (g_ResultsThread.joinable())
+		g_ResultsThread.join();
+
+	g_ResultsCancel = false;
+}
+
+void ShowScanResults(const std::vector<duint>& Results)
+{
+	// Only one population can write to the view at a time (the dialog and commands run on different threads)
+	std::lock_guard<std::mutex> lock(g_ResultsLock);
+	StopScanResultsLocked();
+
+	GuiReferenceDeleteAllColumns();
+	GuiReferenceAddColumn(20, "Address");
+	GuiReferenceAddColumn(20, "Module");
+	GuiReferenceAddColumn(100, "Disassembly");
+	GuiReferenceSetRowCount((int)Results.size());
+	GuiReferenceSetProgress(0);
+	GuiShowReferences();
+
+	g_ResultsThread = std::thread(PopulateResults, Results);
+}
+
+void StopScanResults()
+{
+	std::lock_guard<std::mutex> lock(g_ResultsLock);
+	StopScanResultsLocked();
+}
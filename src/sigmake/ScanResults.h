@@ -0,0 +1,11 @@
+#pragma once
+
+//
+// Fills the references view with scan matches. The rows show up right away and are
+// filled page by page on a background thread, with the disassembly decoded locally
+// from module snapshots instead of one bridge call per match.
+//
+void ShowScanResults(const std::vector<duint>& Results);
+
+// Stops a population still in progress; must be called before the plugin unloads
+void StopScanResults();
\ No newline at end of file
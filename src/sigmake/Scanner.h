@@ -0,0 +1,135 @@
+#pragma once
+
+//
+// Wildcard byte pattern scanner. It only operates on local buffers.
+//
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <functional>
+#include <memory>
+#include "PackedDescriptor.h"
+
+enum SCAN_LEVEL
+{
+	SCAN_LEVEL_SCALAR,
+	SCAN_LEVEL_SSE2,
+	SCAN_LEVEL_AVX2,
+};
+
+SCAN_LEVEL ScanGetBestLevel();
+
+// Receives each match offset; return false to stop the scan early
+typedef std::function<bool(size_t Offset)> ScanCallback;
+
+// Appends the matches starting at positions [Start, Start + Count) to Offsets, in ascending order
+typedef std::function<void(size_t Start, size_t Count, std::vector<size_t>& Offsets)> ScanChunkCallback;
+
+//
+// The chunking behind ScanPattern::ScanParallel, for other kinds of patterns: splits
+// Positions between every core and hands the offsets to Callback on the calling
+// thread in ascending order. Returns the number of offsets passed to Callback.
+//
+size_t ScanChunksParallel(size_t Positions, const ScanChunkCallback& ScanChunk, const ScanCallback& Callback);
+
+//
+// A signature compiled once for any number of scans: packed values, a wildcard
+// bitmask, the anchor used by the vector scanners and a wildcard-aware Horspool
+// skip table for the scalar scanner.
+//
+class ScanPattern
+{
+public:
+	// Wildcards[i] != 0 marks Values[i] as "don't care"
+	ScanPattern(const uint8_t *Values, const uint8_t *Wildcards, size_t Count);
+	explicit ScanPattern(const PackedDescriptor& Descriptor);
+
+	// Limits the pattern to its first Count compiled bytes (can grow back up to the full length)
+	void Resize(size_t Count);
+
+	size_t Count() const
+	{
+		return m_Count;
+	}
+
+	size_t AnchorOffset() const
+	{
+		return m_AnchorOffset;
+	}
+
+	bool IsWildcard(size_t Index) const
+	{
+		return ((m_WildcardMask[Index >> 5] >> (Index & 31)) & 1) != 0;
+	}
+
+	bool MatchAt(const uint8_t *Data, size_t Size, size_t Offset) const;
+
+	// True if every match of this pattern is also a match of Coarser
+	bool Refines(const ScanPattern& Coarser) const;
+
+	// Appends every matching offset (ascending, overlapping allowed) and returns the number added
+	size_t Scan(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t Scan(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults, SCAN_LEVEL Level) const;
+
+	// Splits the buffer into chunks scanned on every core. Callback runs on the calling
+	// thread in ascending offset order. Returns the number of offsets passed to Callback.
+	size_t ScanParallel(const uint8_t *Data, size_t Size, const ScanCallback& Callback) const;
+
+private:
+	void SelectAnchor();
+	void BuildSkipTable();
+
+	size_t ScanScalar(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t ScanHorspool(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t ScanSSE2(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+	size_t ScanAVX2(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets, size_t MaxResults) const;
+
+	bool VerifySSE2(const uint8_t *Data, size_t Size, size_t Offset) const;
+	bool VerifyAVX2(const uint8_t *Data, size_t Size, size_t Offset) const;
+
+	size_t m_Count;
+	size_t m_AnchorOffset;	// Offset of the rarest fixed byte (or byte pair)
+	int m_AnchorLength;		// 0 = all wildcards, 1 = single byte, 2 = byte pair
+
+	// Both planes are padded with wildcards to a multiple of 32 bytes
+	std::vector<uint8_t> m_Values;
+	std::vector<uint32_t> m_WildcardMask;	// Bit set = wildcard
+
+	// Full-length source used by Resize
+	PackedDescriptor m_Compiled;
+
+	size_t m_MaxSkip;
+	uint32_t m_Skip[256];
+};
+
+//
+// Tracks where a growing signature can still match. The first update scans the
+// whole buffer; later updates only re-verify the surviving offsets, as long as
+// the new pattern refines the one that produced them. The set is only replaced
+// while there is more than one match.
+//
+class ScanCandidates
+{
+public:
+	// Parallel = false keeps full scans on the calling thread (for callers with their own workers)
+	ScanCandidates(const uint8_t *Data, size_t Size, size_t Limit, bool Parallel = true);
+
+	// Number of matches of Pattern, capped at Limit + 1
+	size_t Update(const ScanPattern& Pattern);
+
+	const std::vector<size_t>& Offsets() const
+	{
+		return m_Offsets;
+	}
+
+private:
+	const uint8_t *m_Data;
+	size_t m_Size;
+	size_t m_Limit;
+	bool m_Parallel;
+
+	std::unique_ptr<ScanPattern> m_Source;
+	std::vector<size_t> m_Offsets;
+};
+
+bool PatternScanSelfTest();
\ No newline at end of file
@@ -0,0 +1,218 @@
+#pragma once
+
+//
+// Cross-checks every scanner implementation against a naive byte-by-byte search
+// on generated buffers. No debugger functions are used here so the same test can
+// be run outside of x64dbg.
+//
+static uint32_t ScannerTestRandom(uint32_t& State)
+{
+	// xorshift32
+	State ^= State << 13;
+	State ^= State >> 17;
+	State ^= State << 5;
+	return State;
+}
+
+static void ScannerTestReference(const uint8_t *Data, size_t Size, const uint8_t *Values, const uint8_t *Wildcards, size_t Count, std::vector<size_t>& Offsets, size_t MaxResults)
+{
+	for (size_t i = 0; Count <= Size && i <= (Size - Count) && Offsets.size() < MaxResults; i++)
+	{
+		size_t j = 0;
+
+		for (; j < Count; j++)
+		{
+			if (Wildcards[j] == 0 && Data[i + j] != Values[j])
+				break;
+		}
+
+		if (j == Count)
+			Offsets.push_back(i);
+	}
+}
+
+bool PatternScanSelfTest()
+{
+	uint32_t state = 0x2545F491;
+
+	std::vector<uint8_t> data;
+	std::vector<uint8_t> values;
+	std::vector<uint8_t> wildcards;
+	std::vector<size_t> expected;
+	std::vector<size_t> actual;
+
+	for (int iteration = 0; iteration < 2000; iteration++)
+	{
+		// Small alphabets produce lots of partial and overlapping matches
+		size_t size			= ScannerTestRandom(state) % 2048;
+		uint32_t alphabet	= (iteration % 3 == 0) ? 256 : (2 + ScannerTestRandom(state) % 4);
+
+		data.resize(size);
+
+		for (auto& b : data)
+			b = (uint8_t)(ScannerTestRandom(state) % alphabet);
+
+		// Take the pattern from the buffer most of the time so it actually hits
+		size_t count		= 1 + ScannerTestRandom(state) % 80;
+		uint32_t wildRate	= ScannerTestRandom(state) % 5;
+
+		values.resize(count);
+		wildcards.resize(count);
+
+		size_t source = (size >= count) ? ScannerTestRandom(state) % (size - count + 1) : 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			bool fromData = size >= count && (iteration % 7) != 0;
+
+			values[i]		= fromData ? data[source + i] : (uint8_t)(ScannerTestRandom(state) % alphabet);
+			wildcards[i]	= (wildRate == 4 || (ScannerTestRandom(state) % 8) < wildRate) ? 1 : 0;
+		}
+
+		size_t maxResults = (iteration % 5 == 0) ? (1 + ScannerTestRandom(state) % 4) : 10000;
+
+		expected.clear();
+		ScannerTestReference(data.data(), size, values.data(), wildcards.data(), count, expected, maxResults);
+
+		ScanPattern pattern(values.data(), wildcards.data(), count);
+
+		for (int level = SCAN_LEVEL_SCALAR; level <= ScanGetBestLevel(); level++)
+		{
+			actual.clear();
+			pattern.Scan(data.data(), size, actual, maxResults, (SCAN_LEVEL)level);
+
+			if (actual != expected)
+				return false;
+		}
+
+		// The chunked scanner must report the same offsets in the same order
+		actual.clear();
+		pattern.ScanParallel(data.data(), size, [&](size_t Offset)
+		{
+			actual.push_back(Offset);
+			return actual.size() < maxResults;
+		});
+
+		if (actual != expected)
+			return false;
+
+		// The packed form must match at exactly the same offsets (no result limit here)
+		PackedDescriptor packed(values.data(), wildcards.data(), count);
+
+		expected.clear();
+		ScannerTestReference(data.data(), size, values.data(), wildcards.data(), count, expected, SIZE_MAX);
+
+		actual.clear();
+
+		for (size_t i = 0; i <= size; i++)
+		{
+			if (packed.MatchAt(data.data(), size, i))
+				actual.push_back(i);
+		}
+
+		if (actual != expected)
+			return false;
+
+		// Resized patterns must behave exactly like freshly compiled ones, including
+		// growing back after being shortened
+		for (size_t resize : { 1 + ScannerTestRandom(state) % count, 1 + ScannerTestRandom(state) % count, count })
+		{
+			pattern.Resize(resize);
+
+			// Refines compares only the resized length, whatever was compiled
+			if (!ScanPattern(values.data(), wildcards.data(), resize).Refines(pattern))
+				return false;
+
+			expected.clear();
+			ScannerTestReference(data.data(), size, values.data(), wildcards.data(), resize, expected, maxResults);
+
+			for (int level = SCAN_LEVEL_SCALAR; level <= ScanGetBestLevel(); level++)
+			{
+				actual.clear();
+				pattern.Scan(data.data(), size, actual, maxResults, (SCAN_LEVEL)level);
+
+				if (actual != expected)
+					return false;
+			}
+		}
+	}
+
+	// Growing a pattern one byte at a time must give the same counts as a full scan,
+	// both while candidates are tracked and after falling back to one
+	for (int iteration = 0; iteration < 200; iteration++)
+	{
+		size_t size = 64 + ScannerTestRandom(state) % 4096;
+
+		data.resize(size);
+
+		for (auto& b : data)
+			b = (uint8_t)(ScannerTestRandom(state) % 3);
+
+		size_t count	= 1 + ScannerTestRandom(state) % 40;
+		size_t limit	= 1 + ScannerTestRandom(state) % 64;
+		size_t source	= ScannerTestRandom(state) % (size - count + 1);
+
+		values.assign(data.begin() + source, data.begin() + source + count);
+		wildcards.resize(count);
+
+		for (size_t i = 0; i < count; i++)
+			wildcards[i] = (ScannerTestRandom(state) % 4) == 0 ? 1 : 0;
+
+		ScanCandidates candidates(data.data(), size, limit, (iteration % 2) == 0);
+
+		for (size_t length = 1; length <= count; length++)
+		{
+			// An occasional edited byte may break refinement and force a rescan
+			if ((ScannerTestRandom(state) % 8) == 0)
+			{
+				size_t index = ScannerTestRandom(state) % length;
+
+				if (ScannerTestRandom(state) % 2)
+					values[index] ^= 1;
+				else
+					wildcards[index] ^= 1;
+			}
+
+			ScanPattern pattern(values.data(), wildcards.data(), length);
+
+			expected.clear();
+			ScannerTestReference(data.data(), size, values.data(), wildcards.data(), length, expected, limit + 1);
+
+			if (candidates.Update(pattern) != expected.size())
+				return false;
+		}
+	}
+
+	// Buffers spanning several chunks exercise the threaded path and chunk overlaps
+	data.resize(3 * 1024 * 1024 + 12345);
+
+	for (auto& b : data)
+		b = (uint8_t)(ScannerTestRandom(state) % 4);
+
+	for (size_t count = 3; count <= 67; count += 16)
+	{
+		values.assign(data.begin() + 1024 * 1024 - 1, data.begin() + 1024 * 1024 - 1 + count);
+		wildcards.assign(count, 0);
+		wildcards[count / 2] = 1;
+
+		ScanPattern pattern(values.data(), wildcards.data(), count);
+
+		for (size_t maxResults : { (size_t)1, (size_t)2, (size_t)SIZE_MAX })
+		{
+			expected.clear();
+			pattern.Scan(data.data(), data.size(), expected, maxResults, SCAN_LEVEL_SCALAR);
+
+			actual.clear();
+			pattern.ScanParallel(data.data(), data.size(), [&](size_t Offset)
+			{
+				actual.push_back(Offset);
+				return actual.size() < maxResults;
+			});
+
+			if (actual != expected)
+				return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
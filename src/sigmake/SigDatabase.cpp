@@ -0,0 +1,360 @@
+#include "SigDatabase.h"
+#include "CodeStream.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+// winnt.h values, which aren't available here
+const uint32_t SigDatabaseDirectoryException	= 3;
+const uint32_t SigDatabaseRuntimeFunctionSize	= 12;
+const uint8_t SigDatabaseUnwindChainInfo		= 0x04;
+const uint32_t SigDatabaseSectionCode			= 0x00000020;
+const uint32_t SigDatabaseSectionExecute		= 0x20000000;
+
+const char SigDatabaseMagic[8]					= { 'S', 'A', 'K', 'S', 'I', 'G', 'D', 'B' };
+const size_t SigDatabaseHeaderSize				= 32;
+const uint32_t SigDatabaseFlag64				= 0x1;
+
+static uint32_t SigDatabaseRead32(const uint8_t *Data)
+{
+	uint32_t value;
+	memcpy(&value, Data, sizeof(value));
+	return value;
+}
+
+static bool SigDatabaseIsExecutable(const PEImage& Image, uint32_t Rva)
+{
+	for (auto& section : Image.Sections())
+	{
+		if ((section.Characteristics & (SigDatabaseSectionCode | SigDatabaseSectionExecute)) == 0)
+			continue;
+
+		uint32_t size = section.VirtualSize ? section.VirtualSize : section.SizeOfRawData;
+
+		if (Rva >= section.VirtualAddress && (Rva - section.VirtualAddress) < size)
+			return true;
+	}
+
+	return false;
+}
+
+static void SigDatabaseFindUnwindFunctions(const PEImage& Image, uint32_t Rva, uint32_t Size, std::vector<uint32_t>& Functions)
+{
+	const uint8_t *data = Image.Data();
+	size_t imageSize	= Image.Size();
+
+	if (Rva >= imageSize)
+		return;
+
+	size_t count = std::min<size_t>(Size, imageSize - Rva) / SigDatabaseRuntimeFunctionSize;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const uint8_t *entry	= data + Rva + (i * SigDatabaseRuntimeFunctionSize);
+		uint32_t begin			= SigDatabaseRead32(entry);
+		uint32_t end			= SigDatabaseRead32(entry + 4);
+		uint32_t unwind			= SigDatabaseRead32(entry + 8);
+
+		if (begin == 0 || end <= begin || begin >= imageSize)
+			continue;
+
+		//
+		// The low bit marks unwind data that is another RUNTIME_FUNCTION, and chained
+		// unwind info continues the function it points to: both describe a later part
+		// of some function, not a new one.
+		//
+		if ((unwind & 1) != 0)
+			continue;
+
+		if (unwind < imageSize && (data[unwind] & (SigDatabaseUnwindChainInfo << 3)) != 0)
+			continue;
+
+		Functions.push_back(begin);
+	}
+}
+
+static void SigDatabaseFindCallTargets(const PEImage& Image, std::vector<uint32_t>& Functions)
+{
+	const uint8_t *data	= Image.Data();
+	size_t imageSize	= Image.Size();
+	uint64_t base		= Image.Base();
+
+	CodeStream stream(Image.Is64() ? Decode64Bits : Decode32Bits);
+
+	auto read = [&](uint64_t Address, uint8_t *Buffer, size_t Size)
+	{
+		memcpy(Buffer, data + (size_t)(Address - base), Size);
+		return true;
+	};
+
+	for (auto& section : Image.Sections())
+	{
+		if ((section.Characteristics & (SigDatabaseSectionCode | SigDatabaseSectionExecute)) == 0 || section.VirtualAddress >= imageSize)
+			continue;
+
+		uint32_t size = section.VirtualSize ? section.VirtualSize : section.SizeOfRawData;
+		size = (uint32_t)std::min<size_t>(size, imageSize - section.VirtualAddress);
+
+		stream.Decode(base + section.VirtualAddress, size, read, [&](_DInst *Instruction, const uint8_t *Data)
+		{
+			if (Instruction->flags != FLAG_NOT_DECODABLE && META_GET_FC(Instruction->meta) == FC_CALL && Instruction->ops[0].type == O_PC)
+			{
+				uint64_t target = INSTRUCTION_GET_TARGET(Instruction);
+
+				// Linear decoding also runs through data, so only calls into code count
+				if (target > base && (target - base) < imageSize && SigDatabaseIsExecutable(Image, (uint32_t)(target - base)))
+					Functions.push_back((uint32_t)(target - base));
+			}
+
+			return true;
+		});
+	}
+}
+
+void SigDatabaseFindFunctions(const PEImage& Image, std::vector<uint32_t>& Functions)
+{
+	Functions.clear();
+
+	uint32_t rva;
+	uint32_t size;
+
+	if (Image.Is64() && Image.DataDirectory(SigDatabaseDirectoryException, rva, size))
+		SigDatabaseFindUnwindFunctions(Image, rva, size, Functions);
+
+	if (Functions.empty())
+		SigDatabaseFindCallTargets(Image, Functions);
+
+	std::sort(Functions.begin(), Functions.end());
+	Functions.erase(std::unique(Functions.begin(), Functions.end()), Functions.end());
+}
+
+void SigDatabaseGenerate(const PEImage& Image, const BATCH_SIG_OPTIONS& Options, SIG_DATABASE& Database, size_t *Failed)
+{
+	Database.ImageBase	= Image.Base();
+	Database.ImageSize	= (uint32_t)Image.Size();
+	Database.Is64		= Image.Is64();
+	Database.Entries.clear();
+
+	std::vector<uint32_t> functions;
+	SigDatabaseFindFunctions(Image, functions);
+
+	std::vector<uint64_t> addresses;
+	addresses.reserve(functions.size());
+
+	for (uint32_t function : functions)
+		addresses.push_back(Image.Base() + function);
+
+	BATCH_SIG_MODULE module;
+	module.Base	= Image.Base();
+	module.Data	= Image.Data();
+	module.Size	= Image.Size();
+	module.Type	= Image.Is64() ? Decode64Bits : Decode32Bits;
+
+	std::vector<BATCH_SIG_RESULT> results;
+	BatchSigGenerate(module, Options, addresses, results);
+
+	size_t failed = 0;
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		if (!results[i].Found)
+		{
+			failed++;
+			continue;
+		}
+
+		SIG_DATABASE_ENTRY entry;
+		entry.Rva			= functions[i];
+		entry.TargetOffset	= results[i].TargetOffset;
+		entry.Signature		= std::move(results[i].Signature);
+
+		Database.Entries.push_back(std::move(entry));
+	}
+
+	if (Failed)
+		*Failed = failed;
+}
+
+static void SigDatabaseWriteNumber(std::vector<uint8_t>& Output, uint64_t Value)
+{
+	// LEB128: 7 bits at a time, high bit set on all but the last byte
+	do
+	{
+		uint8_t b = Value & 0x7F;
+		Value >>= 7;
+
+		Output.push_back(b | (Value ? 0x80 : 0));
+	} while (Value);
+}
+
+static bool SigDatabaseReadNumber(const uint8_t *Data, size_t Size, size_t& Offset, uint64_t& Value)
+{
+	Value = 0;
+
+	for (uint32_t shift = 0; shift < 64; shift += 7)
+	{
+		if (Offset >= Size)
+			return false;
+
+		uint8_t b = Data[Offset++];
+		Value |= (uint64_t)(b & 0x7F) << shift;
+
+		if ((b & 0x80) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static void SigDatabaseWriteFixed(std::vector<uint8_t>& Output, uint64_t Value, size_t Size)
+{
+	for (size_t i = 0; i < Size; i++)
+		Output.push_back((uint8_t)(Value >> (i * 8)));
+}
+
+static uint64_t SigDatabaseReadFixed(const uint8_t *Data, size_t Size)
+{
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < Size; i++)
+		value |= (uint64_t)Data[i] << (i * 8);
+
+	return value;
+}
+
+void SigDatabaseSerialize(const SIG_DATABASE& Database, std::vector<uint8_t>& Output)
+{
+	Output.assign(SigDatabaseMagic, SigDatabaseMagic + sizeof(SigDatabaseMagic));
+
+	SigDatabaseWriteFixed(Output, SigDatabaseVersion, 4);
+	SigDatabaseWriteFixed(Output, Database.Is64 ? SigDatabaseFlag64 : 0, 4);
+	SigDatabaseWriteFixed(Output, Database.ImageBase, 8);
+	SigDatabaseWriteFixed(Output, Database.ImageSize, 4);
+	SigDatabaseWriteFixed(Output, Database.Entries.size(), 4);
+
+	uint32_t previous = 0;
+
+	for (auto& entry : Database.Entries)
+	{
+		const PackedDescriptor& signature = entry.Signature;
+		size_t count = signature.Count();
+
+		SigDatabaseWriteNumber(Output, entry.Rva - previous);
+		SigDatabaseWriteNumber(Output, entry.TargetOffset);
+		SigDatabaseWriteNumber(Output, count);
+
+		for (size_t i = 0; i < count; i++)
+			Output.push_back(signature.IsWildcard(i) ? 0 : signature.Value(i));
+
+		for (size_t i = 0; i < count; i += 8)
+		{
+			uint8_t bits = 0;
+
+			for (size_t j = i; j < std::min<size_t>(i + 8, count); j++)
+				bits |= (signature.IsWildcard(j) ? 1 : 0) << (j - i);
+
+			Output.push_back(bits);
+		}
+
+		previous = entry.Rva;
+	}
+}
+
+bool SigDatabaseParse(const uint8_t *Data, size_t Size, SIG_DATABASE& Database)
+{
+	Database.Entries.clear();
+
+	if (Size < SigDatabaseHeaderSize || memcmp(Data, SigDatabaseMagic, sizeof(SigDatabaseMagic)) != 0)
+		return false;
+
+	if (SigDatabaseReadFixed(Data + 8, 4) != SigDatabaseVersion)
+		return false;
+
+	Database.Is64		= (SigDatabaseReadFixed(Data + 12, 4) & SigDatabaseFlag64) != 0;
+	Database.ImageBase	= SigDatabaseReadFixed(Data + 16, 8);
+	Database.ImageSize	= (uint32_t)SigDatabaseReadFixed(Data + 24, 4);
+
+	uint64_t entryCount	= SigDatabaseReadFixed(Data + 28, 4);
+	size_t offset		= SigDatabaseHeaderSize;
+	uint64_t rva		= 0;
+
+	// Every entry takes at least three bytes, which bounds the reservation
+	Database.Entries.reserve((size_t)std::min<uint64_t>(entryCount, (Size - offset) / 3));
+
+	for (uint64_t i = 0; i < entryCount; i++)
+	{
+		uint64_t delta;
+		uint64_t targetOffset;
+		uint64_t count;
+
+		if (!SigDatabaseReadNumber(Data, Size, offset, delta) ||
+			!SigDatabaseReadNumber(Data, Size, offset, targetOffset) ||
+			!SigDatabaseReadNumber(Data, Size, offset, count))
+			return false;
+
+		rva += delta;
+
+		if (rva > UINT32_MAX || targetOffset > UINT32_MAX || count > (Size - offset) || ((count + 7) / 8) > (Size - offset - count))
+			return false;
+
+		const uint8_t *values	= Data + offset;
+		const uint8_t *bits		= values + count;
+
+		SIG_DATABASE_ENTRY entry;
+		entry.Rva			= (uint32_t)rva;
+		entry.TargetOffset	= (uint32_t)targetOffset;
+
+		for (size_t j = 0; j < count; j++)
+			entry.Signature.Append(values[j], ((bits[j >> 3] >> (j & 7)) & 1) != 0);
+
+		Database.Entries.push_back(std::move(entry));
+		offset += (size_t)(count + ((count + 7) / 8));
+	}
+
+	return offset == Size;
+}
+
+bool SigDatabaseSave(const char *Path, const SIG_DATABASE& Database)
+{
+	std::vector<uint8_t> data;
+	SigDatabaseSerialize(Database, data);
+
+	FILE *file = nullptr;
+
+#ifdef _MSC_VER
+	fopen_s(&file, Path, "wb");
+#else
+	file = fopen(Path, "wb");
+#endif // _MSC_VER
+
+	if (!file)
+		return false;
+
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	return (fclose(file) == 0) && written;
+}
+
+bool SigDatabaseLoad(const char *Path, SIG_DATABASE& Database)
+{
+	FILE *file = nullptr;
+
+#ifdef _MSC_VER
+	fopen_s(&file, Path, "rb");
+#else
+	file = fopen(Path, "rb");
+#endif // _MSC_VER
+
+	if (!file)
+		return false;
+
+	std::vector<uint8_t> data;
+	uint8_t buffer[64 * 1024];
+
+	for (size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+		data.insert(data.end(), buffer, buffer + read);
+
+	fclose(file);
+	return SigDatabaseParse(data.data(), data.size(), Database);
+}
+
+#include "SigDatabaseTest.h"
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+//
+// Signatures for every function of a module at once, and a compact file format to
+// keep them in. Functions come from the x64 exception directory when there is one
+// and from direct call targets otherwise.
+//
+#include "BatchSig.h"
+#include "PEImage.h"
+
+// File format version written by SigDatabaseSerialize
+const uint32_t SigDatabaseVersion = 1;
+
+struct SIG_DATABASE_ENTRY
+{
+	uint32_t Rva;			// Function start
+	uint32_t TargetOffset;	// The signature starts this many bytes before Rva
+	PackedDescriptor Signature;
+};
+
+struct SIG_DATABASE
+{
+	uint64_t ImageBase;
+	uint32_t ImageSize;
+	bool Is64;
+
+	// Sorted by Rva
+	std::vector<SIG_DATABASE_ENTRY> Entries;
+};
+
+//
+// Function start RVAs, sorted and without duplicates. RUNTIME_FUNCTION entries that
+// only continue another function (chained unwind info) are skipped. Images without
+// an exception directory fall back to the targets of direct calls that land in an
+// executable section.
+//
+void SigDatabaseFindFunctions(const PEImage& Image, std::vector<uint32_t>& Functions);
+
+//
+// Generates a signature for every function in parallel (see BatchSigGenerate).
+// Functions without a unique signature are left out and counted in Failed.
+//
+void SigDatabaseGenerate(const PEImage& Image, const BATCH_SIG_OPTIONS& Options, SIG_DATABASE& Database, size_t *Failed);
+
+//
+// Header: "SAKSIGDB", version, flags (bit 0: 64-bit code), image base, image size and
+// entry count. Entries are sorted by RVA and stored as LEB128 numbers (RVA delta from
+// the previous entry, target offset, length), the byte values (0 for wildcards) and
+// one wildcard bit per byte.
+//
+void SigDatabaseSerialize(const SIG_DATABASE& Database, std::vector<uint8_t>& Output);
+bool SigDatabaseParse(const uint8_t *Data, size_t Size, SIG_DATABASE& Database);
+
+bool SigDatabaseSave(const char *Path, const SIG_DATABASE& Database);
+bool SigDatabaseLoad(const char *Path, SIG_DATABASE& Database);
+
+bool SigDatabaseSelfTest();
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+
+//
+// Builds a PE32+ file with a caller and sixteen small functions, listed in an
+// exception directory along with a chained and an indirect entry that have to be
+// skipped. Checks the functions found with and without that directory, that every
+// generated signature is unique and starts at its function, and that the serialized
+// database reads back the same and is rejected when truncated.
+//
+static void SigDatabaseTestPut(std::vector<uint8_t>& File, size_t Offset, uint64_t Value, size_t Size)
+{
+	memcpy(&File[Offset], &Value, Size);
+}
+
+bool SigDatabaseSelfTest()
+{
+	std::vector<uint8_t> file(0x1000, 0);
+
+	SigDatabaseTestPut(file, 0x00, 0x5A4D, 2);
+	SigDatabaseTestPut(file, 0x3C, 0x80, 4);
+	SigDatabaseTestPut(file, 0x80, 0x00004550, 4);
+
+	// File header: machine, 2 sections, optional header size
+	SigDatabaseTestPut(file, 0x84, 0x8664, 2);
+	SigDatabaseTestPut(file, 0x86, 2, 2);
+	SigDatabaseTestPut(file, 0x94, 0xF0, 2);
+
+	// Optional header: magic, image base, image size, header size, 16 directories
+	const size_t optional	= 0x98;
+	const size_t directory	= optional + 112 + (SigDatabaseDirectoryException * 8);
+	SigDatabaseTestPut(file, optional + 0, 0x20B, 2);
+	SigDatabaseTestPut(file, optional + 24, 0x140000000ull, 8);
+	SigDatabaseTestPut(file, optional + 56, 0x3000, 4);
+	SigDatabaseTestPut(file, optional + 60, 0x400, 4);
+	SigDatabaseTestPut(file, optional + 108, 16, 4);
+	SigDatabaseTestPut(file, directory, 0x2000, 4);
+	SigDatabaseTestPut(file, directory + 4, 19 * SigDatabaseRuntimeFunctionSize, 4);
+
+	// .text at 0x1000 from 0x400, .pdata at 0x2000 from 0xA00
+	const size_t sections = optional + 0xF0;
+	memcpy(&file[sections], ".text", 5);
+	SigDatabaseTestPut(file, sections + 8, 0x600, 4);
+	SigDatabaseTestPut(file, sections + 12, 0x1000, 4);
+	SigDatabaseTestPut(file, sections + 16, 0x600, 4);
+	SigDatabaseTestPut(file, sections + 20, 0x400, 4);
+	SigDatabaseTestPut(file, sections + 36, 0x60000020, 4);
+
+	memcpy(&file[sections + 40], ".pdata", 6);
+	SigDatabaseTestPut(file, sections + 48, 0x200, 4);
+	SigDatabaseTestPut(file, sections + 52, 0x2000, 4);
+	SigDatabaseTestPut(file, sections + 56, 0x200, 4);
+	SigDatabaseTestPut(file, sections + 60, 0xA00, 4);
+	SigDatabaseTestPut(file, sections + 76, 0x40000040, 4);
+
+	// Padding between functions
+	memset(&file[0x400], 0xCC, 0x600);
+
+	// The caller at 0x1000 calls every function once
+	const uint32_t functionCount	= 16;
+	const uint32_t functionStart	= 0x1080;
+	const uint32_t functionSize		= 0x40;
+
+	for (uint32_t i = 0; i < functionCount; i++)
+	{
+		uint32_t call		= 0x1000 + (i * 5);
+		uint32_t target		= functionStart + (i * functionSize);
+
+		file[0x400 + (call - 0x1000)] = 0xE8;
+		SigDatabaseTestPut(file, 0x400 + (call - 0x1000) + 1, target - (call + 5), 4);
+	}
+
+	file[0x400 + (functionCount * 5)] = 0xC3;
+
+	// Every function is a few arithmetic instructions with random 8-bit immediates
+	uint32_t state = 0x2545F491;
+
+	auto random = [&state]()
+	{
+		// xorshift32
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	const uint8_t opcodes[][3] =
+	{
+		{ 0x48, 0x83, 0xC0 },		// add rax, imm8
+		{ 0x48, 0x83, 0xE9 },		// sub rcx, imm8
+		{ 0x48, 0x83, 0xF2 },		// xor rdx, imm8
+		{ 0x48, 0x6B, 0xC0 },		// imul rax, rax, imm8
+	};
+
+	for (uint32_t i = 0; i < functionCount; i++)
+	{
+		size_t offset = 0x400 + (functionStart - 0x1000) + (i * functionSize);
+
+		for (int j = 0; j < 6; j++, offset += 4)
+		{
+			memcpy(&file[offset], opcodes[random() % 4], 3);
+			file[offset + 3] = (uint8_t)random();
+		}
+
+		file[offset] = 0xC3;
+	}
+
+	// RUNTIME_FUNCTIONs, all but two pointing at plain unwind info at 0x2100
+	const size_t pdata = 0xA00;
+	SigDatabaseTestPut(file, pdata + 0x100, 0x01, 1);
+	SigDatabaseTestPut(file, pdata + 0x108, 0x01 | (SigDatabaseUnwindChainInfo << 3), 1);
+
+	for (uint32_t i = 0; i < functionCount; i++)
+	{
+		size_t entry	= pdata + (i * SigDatabaseRuntimeFunctionSize);
+		uint32_t begin	= functionStart + (i * functionSize);
+
+		SigDatabaseTestPut(file, entry, begin, 4);
+		SigDatabaseTestPut(file, entry + 4, begin + 0x19, 4);
+		SigDatabaseTestPut(file, entry + 8, 0x2100, 4);
+	}
+
+	SigDatabaseTestPut(file, pdata + (16 * SigDatabaseRuntimeFunctionSize), 0x1000, 4);
+	SigDatabaseTestPut(file, pdata + (16 * SigDatabaseRuntimeFunctionSize) + 4, 0x1051, 4);
+	SigDatabaseTestPut(file, pdata + (16 * SigDatabaseRuntimeFunctionSize) + 8, 0x2100, 4);
+
+	// A chained part of the first function and one through an indirect entry
+	SigDatabaseTestPut(file, pdata + (17 * SigDatabaseRuntimeFunctionSize), functionStart + 8, 4);
+	SigDatabaseTestPut(file, pdata + (17 * SigDatabaseRuntimeFunctionSize) + 4, functionStart + 0x10, 4);
+	SigDatabaseTestPut(file, pdata + (17 * SigDatabaseRuntimeFunctionSize) + 8, 0x2108, 4);
+	SigDatabaseTestPut(file, pdata + (18 * SigDatabaseRuntimeFunctionSize), functionStart + functionSize + 8, 4);
+	SigDatabaseTestPut(file, pdata + (18 * SigDatabaseRuntimeFunctionSize) + 4, functionStart + functionSize + 0x10, 4);
+	SigDatabaseTestPut(file, pdata + (18 * SigDatabaseRuntimeFunctionSize) + 8, 0x2001, 4);
+
+	PEImage image;
+
+	if (!image.Load(file.data(), file.size()))
+		return false;
+
+	std::vector<uint32_t> expected;
+	expected.push_back(0x1000);
+
+	for (uint32_t i = 0; i < functionCount; i++)
+		expected.push_back(functionStart + (i * functionSize));
+
+	std::vector<uint32_t> functions;
+	SigDatabaseFindFunctions(image, functions);
+
+	if (functions != expected)
+		return false;
+
+	// Without the directory only the called functions are found
+	PEImage noDirectory;
+	std::vector<uint8_t> stripped(file);
+	SigDatabaseTestPut(stripped, directory, 0, 8);
+
+	if (!noDirectory.Load(stripped.data(), stripped.size()))
+		return false;
+
+	SigDatabaseFindFunctions(noDirectory, functions);
+
+	if (functions != std::vector<uint32_t>(expected.begin() + 1, expected.end()))
+		return false;
+
+	BATCH_SIG_OPTIONS options;
+	options.MinLength		= 4;
+	options.MaxLength		= 50;
+	options.Trim			= true;
+	options.Shorten			= true;
+	options.SearchWindow	= 0;
+
+	SIG_DATABASE database;
+	size_t failed = 0;
+	SigDatabaseGenerate(image, options, database, &failed);
+
+	if (failed != 0 || database.Entries.size() != expected.size() || database.ImageBase != image.Base() || !database.Is64)
+		return false;
+
+	for (size_t i = 0; i < database.Entries.size(); i++)
+	{
+		const SIG_DATABASE_ENTRY& entry = database.Entries[i];
+		size_t matches = 0;
+		size_t last = 0;
+
+		for (size_t j = 0; j + entry.Signature.Count() <= image.Size(); j++)
+		{
+			if (entry.Signature.MatchAt(image.Data(), image.Size(), j))
+			{
+				matches++;
+				last = j;
+			}
+		}
+
+		if (entry.Rva != expected[i] || matches != 1 || last != (entry.Rva - entry.TargetOffset))
+			return false;
+	}
+
+	// Wildcards and target offsets have to survive the round trip too
+	database.Entries[1].TargetOffset = 300;
+	database.Entries[1].Signature.Append(0x12, true);
+	database.Entries[1].Signature.Append(0x34, false);
+
+	std::vector<uint8_t> serialized;
+	SigDatabaseSerialize(database, serialized);
+
+	SIG_DATABASE parsed;
+
+	if (!SigDatabaseParse(serialized.data(), serialized.size(), parsed))
+		return false;
+
+	if (parsed.ImageBase != database.ImageBase || parsed.ImageSize != database.ImageSize || parsed.Is64 != database.Is64 ||
+		parsed.Entries.size() != database.Entries.size())
+		return false;
+
+	for (size_t i = 0; i < parsed.Entries.size(); i++)
+	{
+		const SIG_DATABASE_ENTRY& a = parsed.Entries[i];
+		const SIG_DATABASE_ENTRY& b = database.Entries[i];
+
+		if (a.Rva != b.Rva || a.TargetOffset != b.TargetOffset || a.Signature.Count() != b.Signature.Count())
+			return false;
+
+		for (size_t j = 0; j < a.Signature.Count(); j++)
+		{
+			if (a.Signature.IsWildcard(j) != b.Signature.IsWildcard(j) || (!a.Signature.IsWildcard(j) && a.Signature.Value(j) != b.Signature.Value(j)))
+				return false;
+		}
+	}
+
+	// Truncated anywhere, or with trailing garbage
+	for (size_t size = 0; size < serialized.size(); size++)
+	{
+		if (SigDatabaseParse(serialized.data(), size, parsed))
+			return false;
+	}
+
+	serialized.push_back(0);
+
+	if (SigDatabaseParse(serialized.data(), serialized.size(), parsed))
+		return false;
+
+	return true;
+}
\ No newline at end of file
@@ -1,205 +1,402 @@
-#include <algorithm>
 #include "stdafx.h"
 
-const static duint CodeSizeMinimum = 1;			// 01 bytes
-const static duint CodeSizeMaximum = 64 * 1024;	// 64 kilobytes
+const static duint CodeSizeMinimum = 1;					// 01 bytes
+const static duint CodeSizeMaximum = 64 * 1024 * 1024;	// 64 megabytes
+const static duint ShortenFirstCheck = 16;				// Uniqueness is first checked here, then every time the length doubles
+const static int InstructionSizeMaximum = 15;			// Longest x86 instruction
 
 SIG_DESCRIPTOR *GenerateSigFromCode(duint Start, duint End)
 {
-	// Avoid duplicating code everywhere
-	bool returnStatus = false;
-
-	PBYTE processMemory		= nullptr;
-	SIG_DESCRIPTOR *desc	= nullptr;
-	_DInst *instructions	= nullptr;
-
 	//
 	// Check if the copy size is within sane limits.
 	// The last byte is inclusive.
 	//
-	ULONG codeSize = (ULONG)(End - Start + 1);
+	duint codeSize = End - Start + 1;
 
-	if (codeSize < CodeSizeMinimum || codeSize > CodeSizeMaximum)
+	if (End < Start || codeSize < CodeSizeMinimum || codeSize > CodeSizeMaximum)
 	{
-		_plugin_logprintf("Code selection size 0x%X not within bounds (Min: 0x%X Max: 0x%X)\n", codeSize, CodeSizeMinimum, CodeSizeMaximum);
-		goto __freememory;
+		_plugin_logprintf("Code selection size 0x%llX not within bounds (Min: 0x%llX Max: 0x%llX)\n", (ULONGLONG)codeSize, (ULONGLONG)CodeSizeMinimum, (ULONGLONG)CodeSizeMaximum);
+		return nullptr;
 	}
 
-	// Allocate and read the memory buffer
-	processMemory = (PBYTE)BridgeAlloc(codeSize);
+	// Pointer checks use a local copy of the memory map
+	MemoryIndex memory;
+	DbgGetMemoryIndex(memory);
+
+	//
+	// With shortening enabled the signature is checked for uniqueness while it is
+	// generated: once a prefix is unique, nothing after it can end up in the result
+	// and the rest of the selection is never decoded.
+	//
+	SnapshotPtr module;
+	std::unique_ptr<ScanCandidates> candidates;
 
-	if (!DbgMemRead(Start, processMemory, codeSize))
+	if (Settings::ShortestSignatures)
 	{
-		_plugin_logprintf("Couldn't read process memory\n");
-		goto __freememory;
-	}
+		module = SnapshotModule(DbgGetCurrentModule());
 
-	// Allocate the descriptor buffer (Count = # of bytes)
-	desc = AllocDescriptor(codeSize);
+		if (!module)
+		{
+			_plugin_logprintf("Couldn't read process memory for scan\n");
+			return nullptr;
+		}
 
-	// Allocate the disassembly buffer
-	uint32_t instructionCount	= 0;
-	instructions				= (_DInst *)BridgeAlloc(codeSize * sizeof(_DInst));
+		candidates.reset(new ScanCandidates(module->Data(), module->Size(), 4096));
+	}
 
-	_CodeInfo info;
-	info.codeOffset = Start;
-	info.code		= processMemory;
-	info.codeLen	= codeSize;
-	info.features	= DF_NONE;
+	PackedDescriptor signature;
+	size_t ambiguousLength	= 0;
+	size_t nextCheck		= ShortenFirstCheck;
+	bool unique				= false;
 
 #ifdef _WIN64
-	info.dt = Decode64Bits;
+	CodeStream stream(Decode64Bits);
 #else
-	info.dt = Decode32Bits;
+	CodeStream stream(Decode32Bits);
 #endif // _WIN64
 
-	_DecodeResult res = distorm_decompose(&info, instructions, codeSize, &instructionCount);
+	auto read = [](uint64_t Address, uint8_t *Buffer, size_t Size)
+	{
+		return DbgMemRead((duint)Address, Buffer, Size);
+	};
+
+	bool decoded = stream.Decode(Start, codeSize, read, [&](_DInst *Instruction, const uint8_t *Data)
+	{
+		// Determine if the bytes should be used or not
+		// Only displacement and immediate bytes can be wild cards
+		uint8_t wildcards[InstructionSizeMaximum] = {};
+		MatchInstruction(Instruction, Data, memory, wildcards);
+
+		for (int i = 0; i < std::max<int>(Instruction->size, 1); i++)
+			signature.Append(Data[i], wildcards[i] != 0);
+
+		if (!candidates || signature.Count() < nextCheck)
+			return true;
+
+		// Longer prefixes only refine this one, so only its matches are checked again
+		if (candidates->Update(ScanPattern(signature)) > 1)
+		{
+			ambiguousLength	= signature.Count();
+			nextCheck		= signature.Count() * 2;
+			return true;
+		}
+
+		unique = true;
+		return false;
+	});
 
-	// Check if decoding failed
-	if (res != DECRES_SUCCESS)
+	if (!decoded)
 	{
-		_plugin_logprintf("Instruction decoding failed\n");
-		goto __freememory;
+		_plugin_logprintf("Couldn't read process memory\n");
+		return nullptr;
 	}
 
-	// Loop through each instruction
-	uint32_t i = 0;// Instruction index counter
-	uint32_t d = 0;// Data index counter
+	if (candidates && !unique)
+		unique = candidates->Update(ScanPattern(signature)) <= 1;
 
-	for (; i < instructionCount; i++)
+	// Is the setting enabled to shorten signatures? Binary search the rest of the way.
+	if (unique)
 	{
-		// Determine if the bytes should be used or not
-		// All bytes are a wild card unless if proved otherwise
-		{
-			int matchSize = MatchInstruction(&instructions[i], &processMemory[d]);
+		ScanPattern pattern(signature);
+		size_t low	= ambiguousLength + 1;
+		size_t high	= signature.Count();
 
-			// Copy the actual instruction data into signature format
-			for (int j = 0; j < instructions[i].size; j++)
-			{
-				// Is 'j' within the matched data block?
-				if (j < matchSize)
-				{
-					desc->Entries[d + j].Value		= processMemory[d + j];
-					desc->Entries[d + j].Wildcard	= 0;
-				}
-				else
-				{
-					desc->Entries[d + j].Value		= 0;
-					desc->Entries[d + j].Wildcard	= 1;
-				}
-			}
+		while (low < high)
+		{
+			size_t mid = low + (high - low) / 2;
+			pattern.Resize(mid);
 
-			d += instructions[i].size;
+			if (candidates->Update(pattern) > 1)
+				low = mid + 1;
+			else
+				high = mid;
 		}
+
+		signature.Resize(high);
 	}
 
 	// Is the setting enabled to trim signatures?
 	if (Settings::TrimSignatures)
-		TrimDescriptor(desc);
+		signature.Trim();
 
-	// Is the setting enabled to shorten signatures?
-	if (Settings::ShortestSignatures)
-		ShortenDescriptor(desc);
+	return UnpackDescriptor(signature);
+}
 
-	returnStatus = true;
+SIG_DESCRIPTOR *SearchSigFromCode(duint Address, uint32_t *TargetOffset, uint32_t MaxLength)
+{
+	SnapshotPtr module = SnapshotModule(DbgFunctions()->ModBaseFromAddr(Address));
 
-__freememory:
-	if (processMemory)
-		BridgeFree(processMemory);
+	if (!module)
+	{
+		_plugin_logprintf("Couldn't read process memory\n");
+		return nullptr;
+	}
 
-	if (instructions)
-		BridgeFree(instructions);
+	BATCH_SIG_MODULE batchModule;
+	batchModule.Base	= module->Base();
+	batchModule.Data	= module->Data();
+	batchModule.Size	= module->Size();
 
-	// Was this function successful?
-	if (!returnStatus)
+#ifdef _WIN64
+	batchModule.Type = Decode64Bits;
+#else
+	batchModule.Type = Decode32Bits;
+#endif // _WIN64
+
+	BATCH_SIG_OPTIONS options = GetBatchSigOptions();
+
+	// MaxLength (0 = no limit) can only make signatures shorter than the usual limit
+	if (MaxLength > 0 && MaxLength < options.MaxLength)
 	{
-		if (desc)
-			BridgeFree(desc);
+		options.MaxLength = MaxLength;
+		options.MinLength = std::min<uint32_t>(options.MinLength, MaxLength);
+
+		_plugin_logprintf("Signatures are limited to the 0x%X selected bytes\n", MaxLength);
+	}
 
+	BATCH_SIG_RESULT result;
+	result.Address = Address;
+
+	if (!BatchSigSearch(batchModule, options, result))
+	{
+		_plugin_logprintf("Unable to find a unique signature near 0x%llX\n", (ULONGLONG)Address);
 		return nullptr;
 	}
 
-	return desc;
+	*TargetOffset = result.TargetOffset;
+	return UnpackDescriptor(result.Signature);
 }
 
-void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results, duint BaseAddress, duint Size, PBYTE Memory)
+SIG_DESCRIPTOR *MultiBuildSigFromCode(duint Address, const std::vector<std::string>& Files)
 {
-	if (Descriptor->Count <= 0)
+	// The module is read from disk as well, so relocated bytes are known and the
+	// addresses of every image are relative to their preferred bases
+	duint moduleBase = DbgFunctions()->ModBaseFromAddr(Address);
+	char modulePath[MAX_PATH];
+
+	if (!moduleBase || DbgFunctions()->ModPathFromAddr(moduleBase, modulePath, ARRAYSIZE(modulePath)) <= 0)
 	{
-		_plugin_logprintf("Trying to scan with an invalid signature\n");
-		return;
+		_plugin_logprintf("Couldn't get the module of 0x%llX\n", (ULONGLONG)Address);
+		return nullptr;
 	}
 
-	std::vector<uintptr_t> results;
-	std::vector<std::pair<uint8_t, bool>> pattern;
+	PEImage reference;
 
-	for (size_t i = 0; i < Descriptor->Count; i++)
-		pattern.emplace_back(Descriptor->Entries[i].Value, Descriptor->Entries[i].Wildcard);
+	if (!reference.LoadFile(modulePath))
+	{
+		_plugin_logprintf("Unable to load '%s'\n", modulePath);
+		return nullptr;
+	}
 
-	const uint8_t *dataStart = (uint8_t *)Memory;
-	const uint8_t *dataEnd = (uint8_t *)Memory + Size + 1;
+	std::vector<PEImage> builds(Files.size());
 
-	for (const uint8_t *i = dataStart;;)
+	for (size_t i = 0; i < Files.size(); i++)
 	{
-		auto ret = std::search(i, dataEnd, pattern.begin(), pattern.end(),
-			[](uint8_t CurrentByte, std::pair<uint8_t, bool>& Pattern)
+		if (!builds[i].LoadFile(Files[i].c_str()))
 		{
-			return Pattern.second || (CurrentByte == Pattern.first);
-		});
+			_plugin_logprintf("Unable to load '%s'\n", Files[i].c_str());
+			return nullptr;
+		}
+	}
+
+	// MatchInstruction checks operands against the live process, which says nothing
+	// about the other builds
+	BATCH_SIG_OPTIONS batchOptions = GetBatchSigOptions();
 
-		// No byte pattern matched, exit loop
-		if (ret == dataEnd)
-			break;
+	MULTI_BUILD_OPTIONS options;
+	options.MinLength	= batchOptions.MinLength;
+	options.MaxLength	= batchOptions.MaxLength;
+	options.Trim		= batchOptions.Trim;
+	options.Shorten		= batchOptions.Shorten;
 
-		// Cap at 10K for bogus results
-		if (Results.size() >= 10000)
-			break;
+	if (!Settings::DisableWildcards)
+		options.Filter = BatchSigRelocationFilter;
 
-		uintptr_t addr = std::distance(dataStart, ret) + BaseAddress;
-		Results.push_back(addr);
+	MULTI_BUILD_RESULT result;
+	bool found = MultiBuildGenerate(reference, reference.Base() + (Address - moduleBase), builds, options, result);
 
-		i = std::next(ret);
+	for (size_t i = 0; i < result.Locations.size(); i++)
+	{
+		if (result.Locations[i] != 0)
+			_plugin_logprintf("%s: RVA 0x%llX\n", Files[i].c_str(), (ULONGLONG)(result.Locations[i] - builds[i].Base()));
+		else
+			_plugin_logprintf("%s: not found\n", Files[i].c_str());
+	}
+
+	if (!found)
+	{
+		_plugin_logprintf("Unable to find a signature for 0x%llX that is unique in every build\n", (ULONGLONG)Address);
+		return nullptr;
 	}
+
+	return UnpackDescriptor(result.Signature);
 }
 
-void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results)
+bool ExportModuleSigs(duint ModuleBase, const char *Path)
+{
+	SnapshotPtr module = SnapshotModule(ModuleBase);
+
+	if (!module)
+	{
+		_plugin_logprintf("Couldn't read process memory\n");
+		return false;
+	}
+
+	// The exception directory is read from the headers of the loaded module
+	PEImage image;
+
+#ifdef _WIN64
+	image.LoadMapped(module->Data(), module->Size(), module->Base(), true);
+#else
+	image.LoadMapped(module->Data(), module->Size(), module->Base(), false);
+#endif // _WIN64
+
+	SIG_DATABASE database;
+	size_t failed = 0;
+	SigDatabaseGenerate(image, GetBatchSigOptions(), database, &failed);
+
+	if (database.Entries.empty() && failed == 0)
+	{
+		_plugin_logprintf("No functions found in the module\n");
+		return false;
+	}
+
+	if (!SigDatabaseSave(Path, database))
+	{
+		_plugin_logprintf("Unable to write '%s'\n", Path);
+		return false;
+	}
+
+	_plugin_logprintf("Exported %d signatures to '%s', %d functions had no unique signature\n", (int)database.Entries.size(), Path, (int)failed);
+	return true;
+}
+
+size_t PatternScan(const ScanPattern& Pattern, duint BaseAddress, duint Size, const BYTE *Memory, const std::function<bool(duint Address)>& Callback)
+{
+	return Pattern.ScanParallel(Memory, Size, [&](size_t Offset)
+	{
+		return Callback(BaseAddress + Offset);
+	});
+}
+
+void PatternScan(const ScanPattern& Pattern, std::vector<duint>& Results, duint BaseAddress, duint Size, const BYTE *Memory)
+{
+	// Cap at 10K for bogus results
+	const size_t maxResults = 10000;
+
+	if (Results.size() >= maxResults)
+		return;
+
+	PatternScan(Pattern, BaseAddress, Size, Memory, [&](duint Address)
+	{
+		Results.push_back(Address);
+
+		if (Results.size() >= maxResults)
+		{
+			_plugin_logprintf("Result limit of %d reached, stopping scan\n", (int)maxResults);
+			return false;
+		}
+
+		return true;
+	});
+}
+
+void PatternScan(const ScanPattern& Pattern, std::vector<duint>& Results)
 {
 	// Get a copy of the current module in disassembly
-	duint moduleBase	= DbgGetCurrentModule();
-	duint moduleSize	= DbgFunctions()->ModSizeFromAddr(moduleBase);
-	PBYTE processMemory = (PBYTE)BridgeAlloc(moduleSize);
+	SnapshotPtr module = SnapshotModule(DbgGetCurrentModule());
 
-	if (!DbgMemRead(moduleBase, processMemory, moduleSize))
+	if (!module)
 	{
 		_plugin_logprintf("Couldn't read process memory for scan\n");
 		return;
 	}
 
-	PatternScan(Descriptor, Results, moduleBase, moduleSize, processMemory);
-	BridgeFree(processMemory);
+	PatternScan(Pattern, Results, module->Base(), module->Size(), module->Data());
+}
+
+void PatternScan(const CrcPattern& Pattern, std::vector<duint>& Results)
+{
+	SnapshotPtr module = SnapshotModule(DbgGetCurrentModule());
+
+	if (!module)
+	{
+		_plugin_logprintf("Couldn't read process memory for scan\n");
+		return;
+	}
+
+	// Same cap as byte signatures
+	const size_t maxResults = 10000;
+
+	Pattern.ScanParallel(module->Data(), module->Size(), [&](size_t Offset)
+	{
+		Results.push_back(module->Base() + Offset);
+
+		if (Results.size() >= maxResults)
+		{
+			_plugin_logprintf("Result limit of %d reached, stopping scan\n", (int)maxResults);
+			return false;
+		}
+
+		return true;
+	});
+}
+
+void PatternScan(const PackedDescriptor& Descriptor, std::vector<duint>& Results, duint BaseAddress, duint Size, const BYTE *Memory)
+{
+	if (Descriptor.Count() <= 0)
+	{
+		_plugin_logprintf("Trying to scan with an invalid signature\n");
+		return;
+	}
+
+	PatternScan(ScanPattern(Descriptor), Results, BaseAddress, Size, Memory);
+}
+
+void PatternScan(const PackedDescriptor& Descriptor, std::vector<duint>& Results)
+{
+	if (Descriptor.Count() <= 0)
+	{
+		_plugin_logprintf("Trying to scan with an invalid signature\n");
+		return;
+	}
+
+	PatternScan(ScanPattern(Descriptor), Results);
+}
+
+void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results, duint BaseAddress, duint Size, const BYTE *Memory)
+{
+	PatternScan(PackDescriptor(Descriptor), Results, BaseAddress, Size, Memory);
+}
+
+void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results)
+{
+	PatternScan(PackDescriptor(Descriptor), Results);
 }
 
-bool MatchOperands(_DInst *Instruction, _Operand *Operands, int PrefixSize)
+void MatchOperands(_DInst *Instruction, const MemoryIndex& Memory, bool IncludeShortJumps, bool& Displacement, bool& Immediate)
 {
 	//
-	// This function determines if an instruction is static and will be
-	// included in the signature. Each operand is checked (4) to verify this.
-	// Settings are also taken into account.
+	// This function determines which variable fields of an instruction are
+	// static and will be included in the signature. Each operand is checked
+	// (4) to verify this. Settings are also taken into account.
 	//
+	Displacement	= false;
+	Immediate		= false;
+
+	// Determine if short branches are allowed (8 or 16-bit offsets)
+	bool shortBranch = false;
 
-	// Determine if short branches are allowed
 	if (META_GET_FC(Instruction->meta) == FC_UNC_BRANCH ||
 		META_GET_FC(Instruction->meta) == FC_CND_BRANCH)
-	{
-		// Unused prefixes might cause a larger instruction size
-		if (Settings::IncludeShortJumps && ((Instruction->size - PrefixSize) < 5))
-			return true;
-	}
+		shortBranch = IncludeShortJumps && (Instruction->immSize < 4);
 
 	// Loop through the operands
 	for (int i = 0; i < ARRAYSIZE(Instruction->ops); i++)
 	{
-		switch (Operands[i].type)
+		const _Operand& operand = Instruction->ops[i];
+
+		switch (operand.type)
 		{
 		case O_NONE:	// Invalid operand
 		case O_REG:		// Register
@@ -209,13 +406,14 @@ bool MatchOperands(_DInst *Instruction, _Operand *Operands, int PrefixSize)
 			if (Settings::IncludeMemRefences)
 				continue;
 
-			if (Operands[i].size < 32)
+			if (operand.size < 32)
 				continue;
 
-			if (!DbgMemIsValidReadPtr(Instruction->imm.qword))
+			if (!Memory.IsReadable(Instruction->imm.qword))
 				continue;
 
-			return false;
+			Immediate = true;
+			continue;
 
 		case O_IMM1:	// Special operands for ENTER (These are INCLUDED)
 		case O_IMM2:	// Same as above
@@ -225,8 +423,11 @@ bool MatchOperands(_DInst *Instruction, _Operand *Operands, int PrefixSize)
 		case O_SMEM:	// or not a real pointer
 		case O_MEM:		//
 #ifdef _WIN64
-			if (!Settings::IncludeRelAddresses && Operands[i].index == R_RIP)
-				return false;
+			if (!Settings::IncludeRelAddresses && operand.index == R_RIP)
+			{
+				Displacement = true;
+				continue;
+			}
 #endif // _WIN64
 
 			if (Settings::IncludeMemRefences)
@@ -235,81 +436,84 @@ bool MatchOperands(_DInst *Instruction, _Operand *Operands, int PrefixSize)
 			if (Instruction->dispSize < 32)
 				continue;
 
-			if (!DbgMemIsValidReadPtr(Instruction->disp))
+			if (!Memory.IsReadable(Instruction->disp))
 				continue;
 
-			return false;
+			Displacement = true;
+			continue;
 
 		case O_PC:		// Relative branches
+			if (!shortBranch)
+				Immediate = true;
+			continue;
+
 		case O_PTR:		// FAR branches
-			return false;
+			Immediate = true;
+			continue;
 		}
 	}
+}
 
-	return true;
+void MatchInstruction(_DInst *Instruction, const BYTE *Data, const MemoryIndex& Memory, uint8_t *Wildcards)
+{
+	MatchInstruction(Instruction, Data, Memory, Settings::IncludeShortJumps, Wildcards);
 }
 
-int MatchInstruction(_DInst *Instruction, PBYTE Data)
+void MatchInstruction(_DInst *Instruction, const BYTE *Data, const MemoryIndex& Memory, bool IncludeShortJumps, uint8_t *Wildcards)
 {
 	// Are wild cards forced to be off?
 	if (Settings::DisableWildcards)
-		return Instruction->size;
-
-	// Create a temporary struct in order to decode data
-	_CodeInfo info;
-	_PrefixState ps;
-
-	memset(&info, 0, sizeof(_CodeInfo));
-	memset(&ps, 0, sizeof(_PrefixState));
-	memset(ps.pfxIndexer, PFXIDX_NONE, sizeof(int) * PFXIDX_MAX);
-
-	info.codeOffset = (_OffsetType)Data;
-	info.code		= Data;
-	info.codeLen	= Instruction->size;
-	info.features	= DF_NONE;
-
-	ps.start		= Data;
-	ps.last			= Data;
+		return;
 
-#ifdef _WIN64
-	info.dt = Decode64Bits;
-#else
-	info.dt = Decode32Bits;
-#endif // _WIN64
+	if (Instruction->flags == FLAG_NOT_DECODABLE)
+		return;
 
 	//
-	// Calculate the prefixes (already validated)
-	// along with the sizes.
+	// The decoder already reported where the displacement and immediate
+	// fields are, so prefixes, opcode, ModRM and SIB bytes are ALWAYS kept
+	// and only the fields that can change become wild cards.
 	//
-	prefixes_decode(Data, info.codeLen, &ps, info.dt);
-
-	int prefixSize = (int)(ps.last - ps.start);
+	bool displacement;
+	bool immediate;
 
-	//
-	// The return value is ignored here. _CodeInfo::codeLen is modified
-	// and varies depending on the instruction length.
-	//
-	info.codeOffset = (_OffsetType)ps.last;
-	info.code		= ps.last;
-	info.codeLen	-= prefixSize;
+	MatchOperands(Instruction, Memory, IncludeShortJumps, displacement, immediate);
+	BatchSigWildcardFields(Instruction, displacement, immediate, Wildcards);
+}
 
-	inst_lookup(&info, &ps);
+BATCH_SIG_OPTIONS GetBatchSigOptions()
+{
+	// Guess the amount of bytes needed for a unique signature starting from 10 and maxing out at ~50. This
+	// doesn't take function boundaries into account.
+	BATCH_SIG_OPTIONS options;
+	options.MinLength		= 10;
+	options.MaxLength		= 50;
+	options.Trim			= Settings::TrimSignatures;
+	options.Shorten			= Settings::ShortestSignatures;
+	options.SearchWindow	= 0;
+
+	// Shared by every filter and worker thread, read-only once built
+	auto memory = std::make_shared<MemoryIndex>();
+	DbgGetMemoryIndex(*memory);
+
+	options.Filters.push_back([memory](_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards)
+	{
+		MatchInstruction(Instruction, Data, *memory, Wildcards);
+	});
 
-	//
-	// The instruction opcode itself is ALWAYS returned. The
-	// operands are variable.
-	// 'partialInstructionSize' holds sizeof(PREFIX) + sizeof(OPCODE).
-	// 'totalInstructionSize'   holds sizeof(PREFIX) + sizeof(OPCODE) + sizeof(OPERANDS).
-	//
-	int partialInstructionSize	= Instruction->size - info.codeLen;
-	int totalInstructionSize	= Instruction->size;
+	if (Settings::SearchAnchors)
+	{
+		// Also try starting a few instructions earlier
+		options.SearchWindow = 32;
 
-	//
-	// Determine if the operands should be included - increasing
-	// the total copy size.
-	//
-	if (MatchOperands(Instruction, Instruction->ops, prefixSize))
-		return totalInstructionSize;
+		// Short jumps are usually stable and make a signature unique sooner
+		if (!Settings::DisableWildcards && !Settings::IncludeShortJumps)
+		{
+			options.Filters.push_back([memory](_DInst *Instruction, const uint8_t *Data, uint8_t *Wildcards)
+			{
+				MatchInstruction(Instruction, Data, *memory, true, Wildcards);
+			});
+		}
+	}
 
-	return partialInstructionSize;
+	return options;
 }
\ No newline at end of file
@@ -1,8 +1,20 @@
 #pragma once
 
 SIG_DESCRIPTOR *GenerateSigFromCode(duint Start, duint End);
-void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results, duint BaseAddress, duint Size, PBYTE Memory);
+SIG_DESCRIPTOR *SearchSigFromCode(duint Address, uint32_t *TargetOffset, uint32_t MaxLength = 0);
+SIG_DESCRIPTOR *MultiBuildSigFromCode(duint Address, const std::vector<std::string>& Files);
+bool ExportModuleSigs(duint ModuleBase, const char *Path);
+size_t PatternScan(const ScanPattern& Pattern, duint BaseAddress, duint Size, const BYTE *Memory, const std::function<bool(duint Address)>& Callback);
+void PatternScan(const ScanPattern& Pattern, std::vector<duint>& Results, duint BaseAddress, duint Size, const BYTE *Memory);
+void PatternScan(const ScanPattern& Pattern, std::vector<duint>& Results);
+void PatternScan(const CrcPattern& Pattern, std::vector<duint>& Results);
+void PatternScan(const PackedDescriptor& Descriptor, std::vector<duint>& Results, duint BaseAddress, duint Size, const BYTE *Memory);
+void PatternScan(const PackedDescriptor& Descriptor, std::vector<duint>& Results);
+void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results, duint BaseAddress, duint Size, const BYTE *Memory);
 void PatternScan(SIG_DESCRIPTOR *Descriptor, std::vector<duint>& Results);
 
-bool MatchOperands(_DInst *Instruction, _Operand *Operands, int PrefixSize);
-int MatchInstruction(_DInst *Instruction, PBYTE Data);
\ No newline at end of file
+void MatchOperands(_DInst *Instruction, const MemoryIndex& Memory, bool IncludeShortJumps, bool& Displacement, bool& Immediate);
+void MatchInstruction(_DInst *Instruction, const BYTE *Data, const MemoryIndex& Memory, uint8_t *Wildcards);
+void MatchInstruction(_DInst *Instruction, const BYTE *Data, const MemoryIndex& Memory, bool IncludeShortJumps, uint8_t *Wildcards);
+
+BATCH_SIG_OPTIONS GetBatchSigOptions();
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "stdafx.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+// Same cap as the single module scan, per range
+const static size_t SigScanMaxResults = 10000;
+
+struct SIG_SCAN_RANGE
+{
+	duint Start;
+	duint End;
+	duint ModuleBase;				// 0 if the range isn't part of a module
+	std::string ModuleName;
+
+	size_t UnreadablePages;
+	std::vector<duint> Results;
+};
+
+static bool SigScanModuleMatches(const std::string& Name, const std::vector<std::string>& Modules)
+{
+	if (Modules.empty())
+		return true;
+
+	// Accept the name with or without its extension
+	std::string shortName = Name.substr(0, Name.find_last_of('.'));
+
+	for (auto& filter : Modules)
+	{
+		if (_stricmp(filter.c_str(), Name.c_str()) == 0 || _stricmp(filter.c_str(), shortName.c_str()) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+static void SigScanGetRanges(bool Regions, const std::vector<std::string>& Modules, std::vector<SIG_SCAN_RANGE>& Ranges)
+{
+	MEMMAP map;
+
+	if (!DbgMemMap(&map))
+		return;
+
+	std::map<duint, std::string> moduleNames;
+
+	for (int i = 0; i < map.count; i++)
+	{
+		const MEMORY_BASIC_INFORMATION& mbi = map.page[i].mbi;
+
+		if (mbi.State != MEM_COMMIT)
+			continue;
+
+		duint start			= (duint)mbi.BaseAddress;
+		duint end			= start + mbi.RegionSize;
+		duint moduleBase	= DbgFunctions()->ModBaseFromAddr(start);
+
+		if (moduleBase != 0 && moduleNames.find(moduleBase) == moduleNames.end())
+		{
+			char name[MAX_MODULE_SIZE];
+
+			if (!DbgFunctions()->ModNameFromAddr(moduleBase, name, true))
+				strcpy_s(name, "???");
+
+			moduleNames[moduleBase] = name;
+
+			// Whole modules are only added once, at their first page
+			if (!Regions)
+			{
+				start	= moduleBase;
+				end		= moduleBase + DbgFunctions()->ModSizeFromAddr(moduleBase);
+			}
+		}
+		else if (!Regions)
+		{
+			continue;
+		}
+
+		// Filters only keep module ranges
+		std::string name = (moduleBase != 0) ? moduleNames[moduleBase] : "";
+
+		if (!Modules.empty() && (moduleBase == 0 || !SigScanModuleMatches(name, Modules)))
+			continue;
+
+		SIG_SCAN_RANGE range;
+		range.Start				= start;
+		range.End				= end;
+		range.ModuleBase		= moduleBase;
+		range.ModuleName		= name;
+		range.UnreadablePages	= 0;
+
+		Ranges.push_back(range);
+	}
+
+	BridgeFree(map.page);
+}
+
+bool SigScan(const char *Pattern, const char *Mask, bool Regions, const std::vector<std::string>& Modules)
+{
+	size_t length			= 0;
+	TextScanFunction scan	= TextPatternCompile(Pattern, Mask, SigScanMaxResults, &length);
+
+	if (!scan)
+	{
+		_plugin_logprintf("Unable to parse the signature\n");
+		return false;
+	}
+
+	std::vector<SIG_SCAN_RANGE> ranges;
+	SigScanGetRanges(Regions, Modules, ranges);
+
+	if (ranges.empty())
+	{
+		_plugin_logprintf("No %s to scan\n", Regions ? "memory regions" : "modules");
+		return false;
+	}
+
+	//
+	// Every worker takes the next range and streams it through a fixed window on its
+	// own, so memory use doesn't depend on the size of the largest region. Small modules
+	// are the common case, so splitting ranges between threads matters more than
+	// splitting any single range.
+	//
+	clock_t startTime = clock();
+	std::atomic<size_t> nextRange(0);
+	std::atomic<duint> totalSize(0);
+
+	auto worker = [&]()
+	{
+		std::vector<size_t> offsets;
+
+		for (size_t i; (i = nextRange.fetch_add(1)) < ranges.size();)
+		{
+			SIG_SCAN_RANGE& range = ranges[i];
+
+			// Windows overlap by all but one byte of a match; matches in the overlap belong to the next run
+			DbgStreamMemory(range.Start, range.End, (length > 0) ? (length - 1) : 0, [&](uint64_t Address, const uint8_t *Data, size_t Size, size_t Count)
+			{
+				offsets.clear();
+				scan(Data, Size, offsets);
+
+				for (size_t offset : offsets)
+				{
+					if (offset >= Count || range.Results.size() >= SigScanMaxResults)
+						break;
+
+					range.Results.push_back((duint)(Address + offset));
+				}
+
+				totalSize += Count;
+				return range.Results.size() < SigScanMaxResults;
+			}, &range.UnreadablePages);
+		}
+	};
+
+	size_t threadCount = max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+	threadCount = min(threadCount, ranges.size());
+
+	std::vector<std::thread> threads;
+
+	for (size_t i = 1; i < threadCount; i++)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (auto& thread : threads)
+		thread.join();
+
+	// Print the matches grouped by module, regions without one come last
+	std::stable_sort(ranges.begin(), ranges.end(), [](const SIG_SCAN_RANGE& A, const SIG_SCAN_RANGE& B)
+	{
+		if ((A.ModuleBase == 0) != (B.ModuleBase == 0))
+			return A.ModuleBase != 0;
+
+		return A.Start < B.Start;
+	});
+
+	std::vector<duint> results;
+	size_t moduleCount	= 0;
+	size_t unreadable	= 0;
+
+	for (size_t i = 0; i < ranges.size();)
+	{
+		size_t groupEnd		= i;
+		size_t groupMatches	= 0;
+
+		for (; groupEnd < ranges.size() && ranges[groupEnd].ModuleBase == ranges[i].ModuleBase; groupEnd++)
+		{
+			groupMatches += ranges[groupEnd].Results.size();
+			unreadable += ranges[groupEnd].UnreadablePages;
+		}
+
+		if (groupMatches > 0)
+		{
+			if (ranges[i].ModuleBase != 0)
+				_plugin_logprintf("%s (%p): %d match(es)\n", ranges[i].ModuleName.c_str(), (PVOID)ranges[i].ModuleBase, (int)groupMatches);
+			else
+				_plugin_logprintf("Outside of any module: %d match(es)\n", (int)groupMatches);
+
+			for (size_t j = i; j < groupEnd; j++)
+			{
+				for (duint address : ranges[j].Results)
+				{
+					_plugin_logprintf("    %p\n", (PVOID)address);
+					results.push_back(address);
+				}
+			}
+
+			moduleCount += (ranges[i].ModuleBase != 0) ? 1 : 0;
+		}
+
+		i = groupEnd;
+	}
+
+	double time		= double(clock() - startTime) / CLOCKS_PER_SEC;
+	const double MB	= 1024.0 * 1024.0;
+
+	_plugin_logprintf("Found %d match(es) in %d module(s), scanned %.2f MB in %.2f s\n", (int)results.size(), (int)moduleCount, totalSize / MB, time);
+
+	if (unreadable > 0)
+		_plugin_logprintf("Skipped %d page(s) that couldn't be read\n", (int)unreadable);
+
+	if (!results.empty())
+		ShowScanResults(results);
+
+	return true;
+}
\ No newline at end of file
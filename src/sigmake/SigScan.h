@@ -0,0 +1,8 @@
+#pragma once
+
+//
+// Scans every loaded module (or every committed memory region) for one signature
+// at once. Pattern may be in any text format: Code (with Mask), IDA, PEiD or CRC
+// (with an optional Mask). Modules limits the scan to the named modules.
+//
+bool SigScan(const char *Pattern, const char *Mask, bool Regions, const std::vector<std::string>& Modules);
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "TextPattern.h"
+#include <string.h>
+
+TextScanFunction TextPatternCompile(const char *Pattern, const char *Mask, size_t MaxResults, size_t *Length)
+{
+	// IDA and PEiD share a parser, Code always has escapes and CRC a length separator
+	if (strstr(Pattern, "\\x") || strstr(Pattern, "\\X"))
+	{
+		PackedDescriptor packed;
+
+		if (!PackedFromCode(Pattern, Mask ? Mask : "", packed))
+			return nullptr;
+
+		auto pattern = std::make_shared<ScanPattern>(packed);
+
+		if (Length)
+			*Length = pattern->Count();
+
+		return [pattern, MaxResults](const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets)
+		{
+			pattern->Scan(Data, Size, Offsets, MaxResults);
+		};
+	}
+
+	if (strchr(Pattern, ':'))
+	{
+		PackedDescriptor layout;
+		uint32_t checksum;
+
+		if (!PackedFromCRC(Pattern, Mask ? Mask : "", layout, checksum))
+			return nullptr;
+
+		auto pattern = std::make_shared<CrcPattern>(layout, checksum);
+
+		if (Length)
+			*Length = pattern->Count();
+
+		return [pattern, MaxResults](const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets)
+		{
+			pattern->Scan(Data, Size, Offsets, MaxResults);
+		};
+	}
+
+	PackedDescriptor packed;
+
+	if (!PackedFromPEiD(Pattern, packed))
+		return nullptr;
+
+	auto pattern = std::make_shared<ScanPattern>(packed);
+
+	if (Length)
+		*Length = pattern->Count();
+
+	return [pattern, MaxResults](const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets)
+	{
+		pattern->Scan(Data, Size, Offsets, MaxResults);
+	};
+}
\ No newline at end of file
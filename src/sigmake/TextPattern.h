@@ -0,0 +1,15 @@
+#pragma once
+
+//
+// Compiles a signature in any of the text formats into a scan over a local buffer, for
+// callers that take whatever the user pastes: Code (with Mask), IDA, PEiD or CRC (with
+// an optional Mask).
+//
+#include "DescriptorText.h"
+
+// Appends up to the compiled MaxResults matches in Data to Offsets, in ascending order
+typedef std::function<void(const uint8_t *Data, size_t Size, std::vector<size_t>& Offsets)> TextScanFunction;
+
+// Returns an empty function when Pattern can't be parsed. Length (optional) receives the
+// number of bytes a match spans.
+TextScanFunction TextPatternCompile(const char *Pattern, const char *Mask, size_t MaxResults, size_t *Length = nullptr);
\ No newline at end of file
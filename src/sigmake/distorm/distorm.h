@@ -255,6 +255,11 @@ typedef struct {
 	/* Used by ops[n].type == O_MEM. Base global register index (might be R_NONE), scale size (2/4/8), ignored for 0 or 1. */
 	uint8_t base, scale;
 	uint8_t dispSize;
+	/*
+	 * Where the displacement and the immediates (including relative branch offsets and far pointers) are encoded,
+	 * relative to the first byte of the instruction. Offsets are 0 if there is no such field, immSize is in bytes.
+	 */
+	uint8_t dispOffset, immOffset, immSize;
 	/* Meta defines the instruction set class, and the flow control flags. Use META macros. */
 	uint8_t meta;
 	/* The CPU flags that the instruction operates upon. */
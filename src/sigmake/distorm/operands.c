@@ -102,6 +102,22 @@ static int _FASTCALL_ read_stream_safe_sint(_CodeInfo* ci, int64_t* result, unsi
 	return TRUE;
 }
 
+/* Remembers that the displacement starts at the current position, relative to the first byte of the instruction. */
+static void _FASTCALL_ operands_mark_disp(_CodeInfo* ci, _DInst* di, _PrefixState* ps)
+{
+	di->dispOffset = (uint8_t)(ci->code - ps->start);
+}
+
+/*
+ * Same for immediates, relative branch offsets and far pointers, which are always adjacent (i.e: ENTER's imm16 and imm8),
+ * so only the first one sets the offset and the size covers all of them.
+ */
+static void _FASTCALL_ operands_mark_imm(_CodeInfo* ci, _DInst* di, _PrefixState* ps, unsigned int size)
+{
+	if (di->immSize == 0) di->immOffset = (uint8_t)(ci->code - ps->start);
+	di->immSize += (uint8_t)size;
+}
+
 /*
  * SIB decoding is the most confusing part when decoding IA-32 instructions.
  * This explanation should clear up some stuff.
@@ -397,6 +413,7 @@ static int operands_extract_modrm(_CodeInfo* ci,
 			/* 6 is a special case - only 16 bits displacement. */
 			op->type = O_DISP;
 			di->dispSize = 16;
+			operands_mark_disp(ci, di, ps);
 			if (!read_stream_safe_sint(ci, (int64_t*)&di->disp, sizeof(int16_t))) return FALSE;
 		} else {
 			/*
@@ -416,9 +433,11 @@ static int operands_extract_modrm(_CodeInfo* ci,
 
 			if (mod == 1) { /* 8 bits displacement + indirection */
 				di->dispSize = 8;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_sint(ci, (int64_t*)&di->disp, sizeof(int8_t))) return FALSE;
 			} else if (mod == 2) { /* 16 bits displacement + indirection */
 				di->dispSize = 16;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_sint(ci, (int64_t*)&di->disp, sizeof(int16_t))) return FALSE;
 			}
 		}
@@ -436,6 +455,7 @@ static int operands_extract_modrm(_CodeInfo* ci,
 
 			/* 5 is a special case - only 32 bits displacement, or RIP relative. */
 			di->dispSize = 32;
+			operands_mark_disp(ci, di, ps);
 			if (!read_stream_safe_sint(ci, (int64_t*)&di->disp, sizeof(int32_t))) return FALSE;
 
 			if (ci->dt == Decode64Bits) {
@@ -466,9 +486,11 @@ static int operands_extract_modrm(_CodeInfo* ci,
 
 			if (mod == 1) {
 				di->dispSize = 8;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_sint(ci, (int64_t*)&di->disp, sizeof(int8_t))) return FALSE;
 			} else if ((mod == 2) || ((sib & 7) == 5)) { /* If there is no BASE, read DISP32! */
 				di->dispSize = 32;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_sint(ci, (int64_t*)&di->disp, sizeof(int32_t))) return FALSE;
 			}
 		}
@@ -701,6 +723,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 	{
 		case OT_IMM8:
 			operands_set_ts(op, O_IMM, 8);
+			operands_mark_imm(ci, di, ps, sizeof(int8_t));
 			if (!read_stream_safe_uint(ci, &di->imm.byte, sizeof(int8_t))) return FALSE;
 		break;
 		case OT_IMM_FULL: /* 16, 32 or 64, depends on prefixes. */
@@ -709,6 +732,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				/* FALL THROUGH */
 		case OT_IMM16: /* Force 16 bits imm. */
 			operands_set_ts(op, O_IMM, 16);
+			operands_mark_imm(ci, di, ps, sizeof(int16_t));
 			if (!read_stream_safe_uint(ci, &di->imm.word, sizeof(int16_t))) return FALSE;
 		break;
 			/*
@@ -721,6 +745,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				ps->usedPrefixes |= INST_PRE_REX;
 
 				operands_set_ts(op, O_IMM, 64);
+				operands_mark_imm(ci, di, ps, sizeof(int64_t));
 				if (!read_stream_safe_uint(ci, &di->imm.qword, sizeof(int64_t))) return FALSE;
 				break;
 			} else ps->usedPrefixes |= INST_PRE_OP_SIZE;
@@ -731,9 +756,11 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				/* Imm32 is sign extended to 64 bits! */
 				op->size = 64;
 				di->flags |= FLAG_IMM_SIGNED;
+				operands_mark_imm(ci, di, ps, sizeof(int32_t));
 				if (!read_stream_safe_sint(ci, &di->imm.sqword, sizeof(int32_t))) return FALSE;
 			} else {
 				op->size = 32;
+				operands_mark_imm(ci, di, ps, sizeof(int32_t));
 				if (!read_stream_safe_uint(ci, &di->imm.dword, sizeof(int32_t))) return FALSE;
 			}
 		break;
@@ -760,18 +787,22 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				}
 			} else op->size = 8;
 			di->flags |= FLAG_IMM_SIGNED;
+			operands_mark_imm(ci, di, ps, sizeof(int8_t));
 			if (!read_stream_safe_sint(ci, &di->imm.sqword, sizeof(int8_t))) return FALSE;
 		break;
 		case OT_IMM16_1:
 			operands_set_ts(op, O_IMM1, 16);
+			operands_mark_imm(ci, di, ps, sizeof(int16_t));
 			if (!read_stream_safe_uint(ci, &di->imm.ex.i1, sizeof(int16_t))) return FALSE;
 		break;
 		case OT_IMM8_1:
 			operands_set_ts(op, O_IMM1, 8);
+			operands_mark_imm(ci, di, ps, sizeof(int8_t));
 			if (!read_stream_safe_uint(ci, &di->imm.ex.i1, sizeof(int8_t))) return FALSE;
 		break;
 		case OT_IMM8_2:
 			operands_set_ts(op, O_IMM2, 8);
+			operands_mark_imm(ci, di, ps, sizeof(int8_t));
 			if (!read_stream_safe_uint(ci, &di->imm.ex.i2, sizeof(int8_t))) return FALSE;
 		break;
 		case OT_REG8:
@@ -963,6 +994,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				if (ci->codeLen < 0) return FALSE;
 
 				operands_set_ts(op, O_PTR, 16);
+				operands_mark_imm(ci, di, ps, sizeof(int16_t)*2);
 				di->imm.ptr.off = RUSHORT(ci->code); /* Read offset first. */
 				di->imm.ptr.seg = RUSHORT((ci->code + sizeof(int16_t))); /* And read segment. */
 
@@ -973,6 +1005,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				if (ci->codeLen < 0) return FALSE;
 
 				operands_set_ts(op, O_PTR, 32);
+				operands_mark_imm(ci, di, ps, sizeof(int32_t) + sizeof(int16_t));
 				di->imm.ptr.off = RULONG(ci->code); /* Read 32bits offset this time. */
 				di->imm.ptr.seg = RUSHORT((ci->code + sizeof(int32_t))); /* And read segment, 16 bits. */
 				
@@ -984,6 +1017,7 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 
 			if (type == OT_RELCB) {
 				operands_set_ts(op, O_PC, 8);
+				operands_mark_imm(ci, di, ps, sizeof(int8_t));
 				if (!read_stream_safe_sint(ci, &di->imm.sqword, sizeof(int8_t))) return FALSE;
 			} else { /* OT_RELC_FULL */
 
@@ -991,9 +1025,11 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				ps->usedPrefixes |= INST_PRE_OP_SIZE;
 				if (effOpSz == Decode16Bits) {
 					operands_set_ts(op, O_PC, 16);
+					operands_mark_imm(ci, di, ps, sizeof(int16_t));
 					if (!read_stream_safe_sint(ci, &di->imm.sqword, sizeof(int16_t))) return FALSE;
 				} else { /* Decode32Bits or Decode64Bits = for now they are the same */
 					operands_set_ts(op, O_PC, 32);
+					operands_mark_imm(ci, di, ps, sizeof(int32_t));
 					if (!read_stream_safe_sint(ci, &di->imm.sqword, sizeof(int32_t))) return FALSE;
 				}
 			}
@@ -1034,14 +1070,17 @@ int operands_extract(_CodeInfo* ci, _DInst* di, _InstInfo* ii,
 				ps->usedPrefixes |= INST_PRE_ADDR_SIZE;
 
 				di->dispSize = 16;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_uint(ci, &di->disp, sizeof(int16_t))) return FALSE;
 			} else if (effAdrSz == Decode32Bits) {
 				ps->usedPrefixes |= INST_PRE_ADDR_SIZE;
 
 				di->dispSize = 32;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_uint(ci, &di->disp, sizeof(int32_t))) return FALSE;
 			} else { /* Decode64Bits */
 				di->dispSize = 64;
+				operands_mark_disp(ci, di, ps);
 				if (!read_stream_safe_uint(ci, &di->disp, sizeof(int64_t))) return FALSE;
 			}
 		break;
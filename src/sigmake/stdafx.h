@@ -12,8 +12,6 @@ extern "C"
 {
 #include "distorm/distorm.h"
 #include "distorm/mnemonics.h"
-#include "distorm/instructions.h"
-#include "distorm/prefix.h"
 }
 
 //
@@ -29,8 +27,21 @@ extern "C"
 extern HMODULE g_LocalDllHandle;
 
 #include "resource.h"
+#include "Scanner.h"
+#include "CrcPattern.h"
+#include "BatchSig.h"
+#include "MemoryIndex.h"
+#include "CodeStream.h"
+#include "MemoryStream.h"
+#include "SigDatabase.h"
+#include "PEImage.h"
+#include "MultiBuild.h"
+#include "DescriptorText.h"
+#include "TextPattern.h"
 #include "Descriptor.h"
 #include "SigMake.h"
+#include "ScanResults.h"
+#include "SigScan.h"
 #include "Dialog/SigMakeDialog.h"
 #include "Dialog/Settings.h"
 #include "Dialog/SettingsDialog.h"
\ No newline at end of file